@@ -0,0 +1,440 @@
+// async_client.h
+#ifndef ASYNC_CLIENT_H
+#define ASYNC_CLIENT_H
+
+#if __cplusplus < 202002L
+#error "async_client.h needs C++20 (configure with -DASYNC_CLIENT=ON)"
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <curl/curl.h>
+
+#include "request_control.h"   // CancelToken
+
+//------------------------------------------
+// COROUTINE CLIENT RUNTIME (C++20)
+//------------------------------------------
+// Opt-in (ASYNC_CLIENT=ON): co_await-able client operations on a single-threaded event
+// loop, so a workflow such as "fetch every product, place the orders, wait for the fills"
+// reads as straight-line code while all of its requests are in flight at once.
+//
+//   Task<T>     lazy coroutine; starts when awaited (or spawned) and resumes its awaiter
+//   EventLoop   one curl multi handle (HTTP/2 multiplexed, connections reused) plus timers;
+//               every coroutine on it runs on the thread calling run()
+//   whenAll     awaits several tasks concurrently and collects their results in order
+//
+// An in-flight request costs one easy handle and one suspended coroutine frame, so
+// thousands of them can share a thread. The Coinbase operations built on this
+// (httpRequestAsync, getCandlesAsync, placeLimitOrderAsync, ...) live in main.cpp next to
+// their blocking versions.
+
+template <typename T = void>
+class Task;
+
+namespace async_detail {
+
+struct PromiseBase {
+    std::coroutine_handle<> continuation;
+    std::exception_ptr error;
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    // Hands control straight to the awaiting coroutine (symmetric transfer, no stack growth)
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept
+        {
+            std::coroutine_handle<> next = h.promise().continuation;
+            return next ? next : std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+    FinalAwaiter final_suspend() noexcept { return {}; }
+
+    void unhandled_exception() { error = std::current_exception(); }
+};
+
+template <typename T>
+struct Promise : PromiseBase {
+    std::optional<T> value;
+
+    Task<T> get_return_object();
+    void return_value(T v) { value.emplace(std::move(v)); }
+    T result()
+    {
+        if (error) std::rethrow_exception(error);
+        return std::move(*value);
+    }
+};
+
+template <>
+struct Promise<void> : PromiseBase {
+    Task<void> get_return_object();
+    void return_void() {}
+    void result()
+    {
+        if (error) std::rethrow_exception(error);
+    }
+};
+
+} // namespace async_detail
+
+template <typename T>
+class Task {
+public:
+    using promise_type = async_detail::Promise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    Task() = default;
+    explicit Task(Handle h) : handle_(h) {}
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    Task& operator=(Task&& other) noexcept
+    {
+        if (this != &other) {
+            if (handle_) handle_.destroy();
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task()
+    {
+        if (handle_) handle_.destroy();
+    }
+
+    bool await_ready() const noexcept { return !handle_ || handle_.done(); }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        handle_.promise().continuation = awaiting;
+        return handle_;
+    }
+    T await_resume() { return handle_.promise().result(); }
+
+private:
+    Handle handle_;
+};
+
+namespace async_detail {
+
+template <typename T>
+Task<T> Promise<T>::get_return_object() { return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this)); }
+
+inline Task<void> Promise<void>::get_return_object()
+{
+    return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+// Fire-and-forget frame used by spawn() and whenAll(): runs eagerly, frees itself at the end
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); } // Bodies catch everything
+    };
+};
+
+inline int64_t nowNanos()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace async_detail
+
+//------------------------------------------
+// EVENT LOOP
+//------------------------------------------
+class EventLoop {
+public:
+    EventLoop()
+    {
+        multi_ = curl_multi_init();
+        if (multi_) {
+            curl_multi_setopt(multi_, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+        }
+    }
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+    ~EventLoop()
+    {
+        for (Transfer* t : transfers_) {
+            curl_multi_remove_handle(multi_, t->easy);
+        }
+        if (multi_) {
+            curl_multi_cleanup(multi_);
+        }
+    }
+
+    // co_await loop.perform(easy): runs a configured easy handle on the loop's multi handle
+    // and returns its result. The caller still owns (and cleans up) the handle.
+    struct Transfer {
+        EventLoop& loop;
+        CURL* easy;
+        const CancelToken* cancel;
+        CURLcode code = CURLE_OK;
+        std::coroutine_handle<> waiting;
+
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> h)
+        {
+            waiting = h;
+            if (!loop.multi_ || curl_multi_add_handle(loop.multi_, easy) != CURLM_OK) {
+                code = CURLE_FAILED_INIT;
+                return false; // Resume right away with the error
+            }
+            loop.transfers_.push_back(this);
+            return true;
+        }
+        CURLcode await_resume() const noexcept { return code; }
+    };
+    Transfer perform(CURL* easy, const CancelToken* cancel = nullptr) { return Transfer{*this, easy, cancel, CURLE_OK, {}}; }
+
+    // co_await loop.sleepUntil(monotonic ns) / loop.sleepFor(ns)
+    struct Timer {
+        EventLoop& loop;
+        int64_t wakeNanos;
+
+        bool await_ready() const noexcept { return wakeNanos <= async_detail::nowNanos(); }
+        void await_suspend(std::coroutine_handle<> h) { loop.timers_.push(TimerEntry{wakeNanos, loop.timerSeq_++, h}); }
+        void await_resume() const noexcept {}
+    };
+    Timer sleepUntil(int64_t wakeNanos) { return Timer{*this, wakeNanos}; }
+    Timer sleepFor(int64_t nanos) { return Timer{*this, async_detail::nowNanos() + nanos}; }
+
+    // Starts `task` now; it runs to its first suspension before spawn() returns.
+    // Exceptions escaping it are reported, not propagated.
+    void spawn(Task<void> task)
+    {
+        [](EventLoop& loop, Task<void> t) -> async_detail::Detached {
+            loop.live_++;
+            try {
+                co_await t;
+            } catch (const std::exception& e) {
+                std::cerr << "[ERROR] Async task: " << e.what() << std::endl;
+            } catch (...) {
+                std::cerr << "[ERROR] Async task: unknown exception" << std::endl;
+            }
+            loop.live_--;
+        }(*this, std::move(task));
+    }
+
+    // Resumes `h` on the loop thread at the next turn
+    void schedule(std::coroutine_handle<> h) { ready_.push_back(h); }
+
+    // Thread-safe: runs fn on the loop thread (e.g. to hand a websocket message to a coroutine)
+    void post(std::function<void()> fn)
+    {
+        {
+            std::lock_guard<std::mutex> lock(postedMutex_);
+            posted_.push_back(std::move(fn));
+        }
+        curl_multi_wakeup(multi_);
+    }
+
+    // Runs until every spawned task has finished
+    void run()
+    {
+        while (turn(live_ > 0)) {
+        }
+    }
+
+    // Runs `task` to completion on this thread and returns its result
+    template <typename T>
+    T runUntilComplete(Task<T> task)
+    {
+        if constexpr (std::is_void_v<T>) {
+            runUntilComplete([](Task<void> t) -> Task<bool> {
+                co_await t;
+                co_return true;
+            }(std::move(task)));
+            return;
+        } else {
+            return runValueTask(std::move(task));
+        }
+    }
+
+    size_t inFlight() const { return transfers_.size(); }
+
+private:
+    template <typename T>
+    T runValueTask(Task<T> task)
+    {
+        std::optional<T> result;
+        std::exception_ptr error;
+        bool finished = false;
+        [](Task<T> t, std::optional<T>& out, std::exception_ptr& err, bool& done) -> async_detail::Detached {
+            try {
+                out.emplace(co_await t);
+            } catch (...) {
+                err = std::current_exception();
+            }
+            done = true;
+        }(std::move(task), result, error, finished);
+        while (!finished && turn(true)) {
+        }
+        if (error) std::rethrow_exception(error);
+        return std::move(*result);
+    }
+
+    struct TimerEntry {
+        int64_t wakeNanos;
+        uint64_t seq;
+        std::coroutine_handle<> handle;
+        bool operator>(const TimerEntry& o) const
+        {
+            return wakeNanos != o.wakeNanos ? wakeNanos > o.wakeNanos : seq > o.seq;
+        }
+    };
+
+    // One pass: resume ready coroutines, drive curl, fire timers, then wait for I/O.
+    // Returns false once there is nothing left to wait for.
+    bool turn(bool keepWaiting)
+    {
+        drainPosted();
+        while (!ready_.empty()) {
+            std::vector<std::coroutine_handle<>> batch;
+            batch.swap(ready_);
+            for (auto h : batch) {
+                h.resume();
+            }
+        }
+
+        if (!transfers_.empty()) {
+            int running = 0;
+            curl_multi_perform(multi_, &running);
+            int left = 0;
+            while (CURLMsg* msg = curl_multi_info_read(multi_, &left)) {
+                if (msg->msg == CURLMSG_DONE) {
+                    complete(msg->easy_handle, msg->data.result);
+                }
+            }
+            for (size_t i = transfers_.size(); i-- > 0;) {
+                if (transfers_[i]->cancel && transfers_[i]->cancel->isCancelled()) {
+                    complete(transfers_[i]->easy, CURLE_ABORTED_BY_CALLBACK);
+                }
+            }
+        }
+
+        int64_t now = async_detail::nowNanos();
+        while (!timers_.empty() && timers_.top().wakeNanos <= now) {
+            ready_.push_back(timers_.top().handle);
+            timers_.pop();
+        }
+        if (!ready_.empty()) {
+            return true;
+        }
+        if (transfers_.empty() && timers_.empty() && !keepWaiting) {
+            return false;
+        }
+
+        // Sleep until I/O, the next timer or a post(); wake at least every 50ms to notice cancellation
+        int64_t waitNanos = 50'000'000;
+        if (!timers_.empty()) {
+            waitNanos = std::min(waitNanos, timers_.top().wakeNanos - now);
+        }
+        int timeoutMs = static_cast<int>(std::clamp<int64_t>((waitNanos + 999'999) / 1'000'000, 0, 50));
+        curl_multi_poll(multi_, nullptr, 0, timeoutMs, nullptr);
+        return true;
+    }
+
+    void complete(CURL* easy, CURLcode code)
+    {
+        auto it = std::find_if(transfers_.begin(), transfers_.end(), [easy](Transfer* t) { return t->easy == easy; });
+        if (it == transfers_.end()) {
+            return;
+        }
+        Transfer* t = *it;
+        *it = transfers_.back();
+        transfers_.pop_back();
+        curl_multi_remove_handle(multi_, easy);
+        t->code = code;
+        ready_.push_back(t->waiting);
+    }
+
+    void drainPosted()
+    {
+        std::vector<std::function<void()>> posted;
+        {
+            std::lock_guard<std::mutex> lock(postedMutex_);
+            posted.swap(posted_);
+        }
+        for (auto& fn : posted) {
+            fn();
+        }
+    }
+
+    CURLM* multi_ = nullptr;
+    std::vector<Transfer*> transfers_;
+    std::vector<std::coroutine_handle<>> ready_;
+    std::priority_queue<TimerEntry, std::vector<TimerEntry>, std::greater<TimerEntry>> timers_;
+    uint64_t timerSeq_ = 0;
+    size_t live_ = 0;
+    std::mutex postedMutex_;
+    std::vector<std::function<void()>> posted_;
+};
+
+//------------------------------------------
+// WHEN ALL
+//------------------------------------------
+// Runs every task concurrently; results come back in the tasks' order. If any task throws,
+// the first exception is rethrown once all of them have finished.
+template <typename T>
+Task<std::vector<T>> whenAll(EventLoop& loop, std::vector<Task<T>> tasks)
+{
+    struct State {
+        std::vector<std::optional<T>> results;
+        std::exception_ptr error;
+        size_t remaining = 0;
+        std::coroutine_handle<> parent;
+    } state;
+    state.results.resize(tasks.size());
+    state.remaining = tasks.size();
+
+    struct AllDone {
+        State& s;
+        bool await_ready() const noexcept { return s.remaining == 0; }
+        void await_suspend(std::coroutine_handle<> h) noexcept { s.parent = h; }
+        void await_resume() const noexcept {}
+    };
+
+    for (size_t i = 0; i < tasks.size(); i++) {
+        [](EventLoop& l, Task<T> t, State& s, size_t index) -> async_detail::Detached {
+            try {
+                s.results[index].emplace(co_await t);
+            } catch (...) {
+                if (!s.error) s.error = std::current_exception();
+            }
+            if (--s.remaining == 0 && s.parent) {
+                l.schedule(s.parent);
+            }
+        }(loop, std::move(tasks[i]), state, i);
+    }
+    co_await AllDone{state};
+
+    if (state.error) std::rethrow_exception(state.error);
+    std::vector<T> out;
+    out.reserve(state.results.size());
+    for (auto& r : state.results) {
+        out.push_back(std::move(*r));
+    }
+    co_return out;
+}
+
+#endif // ASYNC_CLIENT_H
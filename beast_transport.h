@@ -0,0 +1,362 @@
+// beast_transport.h
+#ifndef BEAST_TRANSPORT_H
+#define BEAST_TRANSPORT_H
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <boost/asio/connect.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/asio/write.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/beast/ssl.hpp>
+
+#include "request_control.h"   // HttpResult, CancelToken
+
+//------------------------------------------
+// BOOST.BEAST HTTPS TRANSPORT (HTTP_TRANSPORT=beast)
+//------------------------------------------
+// Alternative to the libcurl path in httpRequestInto(), on the same Asio/OpenSSL stack as
+// the websocket clients. TLS connections are kept alive and pooled per host, so a request
+// on a warm connection costs one write and one read: no DNS, TCP or TLS handshake, and no
+// handle setup. The request head is formatted into the connection's reusable buffer and
+// written together with the body in one gather write.
+//
+// Calls are synchronous on the caller's thread, like the curl path. Each caller takes a
+// connection from the pool for the duration of its request, so the threads that make
+// requests (market data, gateway, downloader workers) each end up with a warm connection.
+// Internally every operation is asynchronous and the io_context is run in short slices, so
+// the request deadline and CancelToken are honoured just as on the curl path. DNS lookups
+// run on the client's own resolver thread: getaddrinfo cannot be interrupted, so a request
+// that times out or is cancelled during a lookup returns at once and leaves it behind.
+//
+// No HTTP/1.1 pipelining, deliberately: a connection carries one request at a time. The
+// callers are synchronous, one request per thread, and each already has its own warm
+// connection; pipelining would only queue one thread's request behind another's response
+// (head-of-line blocking) on the order path.
+//
+// A pooled connection the server has quietly closed fails before any response byte arrives;
+// the request is then resent once on a fresh connection (what curl does for a dead reused
+// connection too).
+class BeastHttpsClient {
+public:
+    static constexpr size_t kMaxIdleConnections = 16;
+
+    BeastHttpsClient()
+        : ssl_(boost::asio::ssl::context::tlsv12_client), dnsWork_(boost::asio::make_work_guard(dnsIoc_)),
+          dnsThread_([this] { dnsIoc_.run(); })
+    {
+        ssl_.set_default_verify_paths();
+        ssl_.set_verify_mode(boost::asio::ssl::verify_peer);
+    }
+
+    ~BeastHttpsClient()
+    {
+        dnsWork_.reset();
+        dnsIoc_.stop();
+        dnsThread_.join();
+    }
+
+    // True for the URLs this transport can serve (https only)
+    static bool handles(std::string_view url) { return url.substr(0, 8) == "https://"; }
+
+    // Same contract as the curl path: the body is appended to readBuffer; code/httpStatus
+    // are filled in as curl would (CURLE_OPERATION_TIMEDOUT, CURLE_ABORTED_BY_CALLBACK, ...)
+    template <typename StringT>
+    HttpResult request(std::string_view method, std::string_view url, std::string_view bearerToken,
+                       std::string_view body, StringT& readBuffer, int64_t deadlineNanos, const CancelToken* cancel)
+    {
+        HttpResult result;
+        std::string_view host;
+        std::string_view port;
+        std::string_view target;
+        if (!splitUrl(url, host, port, target)) {
+            result.code = CURLE_URL_MALFORMAT;
+            return result;
+        }
+
+        for (int attempt = 0; attempt < 2; attempt++) {
+            std::unique_ptr<Connection> conn = acquire(host, port);
+            bool reused = conn->open;
+            Outcome outcome = exchange(*conn, method, target, bearerToken, body, deadlineNanos, cancel);
+            if (outcome == Outcome::Ok) {
+                const auto& res = conn->parser->get();
+                result.httpStatus = static_cast<long>(res.result_int());
+                readBuffer.append(res.body().data(), res.body().size());
+                if (res.keep_alive()) {
+                    release(std::move(conn));
+                }
+                return result;
+            }
+            if (outcome == Outcome::StaleConnection && reused) {
+                continue; // Idle connection was closed by the server: retry once on a new one
+            }
+            result.code = outcome == Outcome::TimedOut ? CURLE_OPERATION_TIMEDOUT
+                        : outcome == Outcome::Cancelled ? CURLE_ABORTED_BY_CALLBACK
+                        : outcome == Outcome::ConnectFailed ? CURLE_COULDNT_CONNECT
+                        : CURLE_RECV_ERROR;
+            result.timedOut = (outcome == Outcome::TimedOut);
+            result.cancelled = (outcome == Outcome::Cancelled);
+            return result;
+        }
+        result.code = CURLE_RECV_ERROR;
+        return result;
+    }
+
+private:
+    using Stream = boost::beast::ssl_stream<boost::beast::tcp_stream>;
+
+    enum class Outcome { Ok, StaleConnection, ConnectFailed, Failed, TimedOut, Cancelled };
+
+    struct Connection {
+        std::string host;
+        std::string port;
+        boost::asio::io_context ioc;
+        std::unique_ptr<Stream> stream;
+        boost::beast::flat_buffer buffer;
+        std::string head;   // Preformatted request head; reused, so it stops allocating once warm
+        std::optional<boost::beast::http::response_parser<boost::beast::http::string_body>> parser;
+        bool open = false;
+    };
+
+    static bool splitUrl(std::string_view url, std::string_view& host, std::string_view& port, std::string_view& target)
+    {
+        if (!handles(url)) {
+            return false;
+        }
+        std::string_view rest = url.substr(8);
+        size_t slash = rest.find('/');
+        std::string_view authority = rest.substr(0, slash);
+        target = slash == std::string_view::npos ? std::string_view("/") : rest.substr(slash);
+        size_t colon = authority.find(':');
+        host = authority.substr(0, colon);
+        port = colon == std::string_view::npos ? std::string_view("443") : authority.substr(colon + 1);
+        return !host.empty();
+    }
+
+    std::unique_ptr<Connection> acquire(std::string_view host, std::string_view port)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (size_t i = idle_.size(); i-- > 0;) {
+                if (idle_[i]->host == host && idle_[i]->port == port) {
+                    std::unique_ptr<Connection> conn = std::move(idle_[i]);
+                    idle_.erase(idle_.begin() + static_cast<std::ptrdiff_t>(i));
+                    return conn;
+                }
+            }
+        }
+        auto conn = std::make_unique<Connection>();
+        conn->host = std::string(host);
+        conn->port = std::string(port);
+        conn->head.reserve(2048);
+        return conn;
+    }
+
+    void release(std::unique_ptr<Connection> conn)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (idle_.size() < kMaxIdleConnections) {
+            idle_.push_back(std::move(conn));
+        }
+    }
+
+    // Runs the connection's io_context until `done`, the deadline or cancellation. On
+    // timeout/cancel the socket is closed so the pending operation completes (aborted).
+    static Outcome runUntilDone(Connection& conn, const bool& done, int64_t deadlineNanos, const CancelToken* cancel)
+    {
+        conn.ioc.restart();
+        while (!done) {
+            int64_t now = nowNanos();
+            bool cancelled = cancel && cancel->isCancelled();
+            if (cancelled || now >= deadlineNanos) {
+                boost::system::error_code ec;
+                boost::beast::get_lowest_layer(*conn.stream).socket().close(ec);
+                conn.ioc.restart();
+                conn.ioc.run();
+                conn.open = false;
+                return cancelled ? Outcome::Cancelled : Outcome::TimedOut;
+            }
+            // Slices of at most 50ms to notice cancellation
+            auto slice = std::chrono::nanoseconds(std::min<int64_t>(deadlineNanos - now, 50'000'000));
+            conn.ioc.run_for(slice);
+            if (conn.ioc.stopped()) {
+                conn.ioc.restart();
+            }
+        }
+        return Outcome::Ok;
+    }
+
+    // One lookup on the resolver thread. Shared with the completion handler, so a lookup the
+    // request gave up on still has somewhere to complete into.
+    struct Lookup {
+        boost::asio::ip::tcp::resolver resolver;
+        std::mutex mutex;
+        std::condition_variable finished;
+        bool done = false;
+        boost::system::error_code ec;
+        boost::asio::ip::tcp::resolver::results_type endpoints;
+
+        explicit Lookup(boost::asio::io_context& ioc) : resolver(ioc) {}
+    };
+
+    // Waits for the lookup in slices of at most 50ms to notice cancellation, like runUntilDone
+    Outcome resolve(const Connection& conn, int64_t deadlineNanos, const CancelToken* cancel,
+                    boost::asio::ip::tcp::resolver::results_type& endpoints)
+    {
+        auto lookup = std::make_shared<Lookup>(dnsIoc_);
+        lookup->resolver.async_resolve(
+                conn.host, conn.port,
+                [lookup](const boost::system::error_code& ec, boost::asio::ip::tcp::resolver::results_type results) {
+                    std::lock_guard<std::mutex> lock(lookup->mutex);
+                    lookup->ec = ec;
+                    lookup->endpoints = std::move(results);
+                    lookup->done = true;
+                    lookup->finished.notify_one();
+                });
+        std::unique_lock<std::mutex> lock(lookup->mutex);
+        while (!lookup->done) {
+            int64_t now = nowNanos();
+            if (cancel && cancel->isCancelled()) {
+                return Outcome::Cancelled;
+            }
+            if (now >= deadlineNanos) {
+                return Outcome::TimedOut;
+            }
+            lookup->finished.wait_for(lock, std::chrono::nanoseconds(std::min<int64_t>(deadlineNanos - now, 50'000'000)));
+        }
+        if (lookup->ec) {
+            return Outcome::ConnectFailed;
+        }
+        endpoints = lookup->endpoints;
+        return Outcome::Ok;
+    }
+
+    Outcome connect(Connection& conn, int64_t deadlineNanos, const CancelToken* cancel)
+    {
+        namespace net = boost::asio;
+        namespace ssl = boost::asio::ssl;
+
+        conn.stream = std::make_unique<Stream>(conn.ioc, ssl_);
+        conn.buffer.clear();
+        if (!SSL_set_tlsext_host_name(conn.stream->native_handle(), conn.host.c_str())) {
+            return Outcome::ConnectFailed;
+        }
+        conn.stream->set_verify_callback(ssl::host_name_verification(conn.host));
+
+        net::ip::tcp::resolver::results_type endpoints;
+        Outcome resolved = resolve(conn, deadlineNanos, cancel, endpoints);
+        if (resolved != Outcome::Ok) {
+            return resolved;
+        }
+
+        boost::system::error_code ec;
+        bool done = false;
+        boost::beast::get_lowest_layer(*conn.stream).async_connect(
+                endpoints, [&](const boost::system::error_code& e, const net::ip::tcp::endpoint&) { ec = e; done = true; });
+        Outcome waited = runUntilDone(conn, done, deadlineNanos, cancel);
+        if (waited != Outcome::Ok) return waited;
+        if (ec) return Outcome::ConnectFailed;
+        boost::beast::get_lowest_layer(*conn.stream).socket().set_option(net::ip::tcp::no_delay(true));
+
+        done = false;
+        conn.stream->async_handshake(ssl::stream_base::client, [&](const boost::system::error_code& e) { ec = e; done = true; });
+        waited = runUntilDone(conn, done, deadlineNanos, cancel);
+        if (waited != Outcome::Ok) return waited;
+        if (ec) return Outcome::ConnectFailed;
+        conn.open = true;
+        return Outcome::Ok;
+    }
+
+    Outcome exchange(Connection& conn, std::string_view method, std::string_view target, std::string_view bearerToken,
+                     std::string_view body, int64_t deadlineNanos, const CancelToken* cancel)
+    {
+        namespace net = boost::asio;
+        namespace http = boost::beast::http;
+
+        if (!conn.open) {
+            Outcome connected = connect(conn, deadlineNanos, cancel);
+            if (connected != Outcome::Ok) {
+                return connected;
+            }
+        }
+
+        // Request head, same headers as the curl path
+        std::string& h = conn.head;
+        h.clear();
+        h.append(method).append(" ").append(target).append(" HTTP/1.1\r\nHost: ").append(conn.host);
+        h.append("\r\nUser-Agent: CoinBaseBot\r\nAccept: */*\r\n");
+        if (!bearerToken.empty()) {
+            h.append("Authorization: Bearer ").append(bearerToken).append("\r\n");
+        }
+        h.append("Content-Type: application/json\r\n");
+        if (method == "POST" || !body.empty()) {
+            h.append("Content-Length: ").append(std::to_string(body.size())).append("\r\n");
+        }
+        h.append("\r\n");
+
+        boost::system::error_code ec;
+        bool done = false;
+        std::array<net::const_buffer, 2> buffers = {net::buffer(h), net::buffer(body.data(), body.size())};
+        net::async_write(*conn.stream, buffers, [&](const boost::system::error_code& e, size_t) { ec = e; done = true; });
+        Outcome waited = runUntilDone(conn, done, deadlineNanos, cancel);
+        if (waited != Outcome::Ok) return waited;
+        if (ec) {
+            conn.open = false;
+            return Outcome::StaleConnection;
+        }
+
+        conn.parser.emplace();
+        conn.parser->body_limit(64 * 1024 * 1024);
+        if (method == "HEAD") {
+            conn.parser->skip(true);
+        }
+        done = false;
+        http::async_read(*conn.stream, conn.buffer, *conn.parser,
+                         [&](const boost::system::error_code& e, size_t) { ec = e; done = true; });
+        waited = runUntilDone(conn, done, deadlineNanos, cancel);
+        if (waited != Outcome::Ok) return waited;
+        if (ec) {
+            conn.open = false;
+            bool nothingRead = !conn.parser->got_some();
+            return nothingRead ? Outcome::StaleConnection : Outcome::Failed;
+        }
+        return Outcome::Ok;
+    }
+
+    static int64_t nowNanos()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    boost::asio::ssl::context ssl_;
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<Connection>> idle_;
+    boost::asio::io_context dnsIoc_;   // Resolver completions, on dnsThread_
+    boost::asio::executor_work_guard<boost::asio::io_context::executor_type> dnsWork_;
+    std::thread dnsThread_;
+};
+
+// Process-wide client (one connection pool)
+inline BeastHttpsClient& beastHttps()
+{
+    static BeastHttpsClient instance;
+    return instance;
+}
+
+#endif // BEAST_TRANSPORT_H
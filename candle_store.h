@@ -0,0 +1,285 @@
+// candle_store.h
+#ifndef CANDLE_STORE_H
+#define CANDLE_STORE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <numeric>
+#include <set>
+#include <string>
+#include <vector>
+
+//------------------------------------------
+// COLUMNAR CANDLE FILE
+//------------------------------------------
+// Layout:
+//   CandleFileHeader
+//   CandleBlockHeader + int64 start[count] + double open/high/low/close/volume[count]
+//   CandleBlockHeader + ...
+//
+// Each block holds one downloaded chunk. Blocks are appended in completion order,
+// so the file itself is the resume checkpoint: a chunk is done iff its block is present
+// and its checksum matches. A torn block at the tail is truncated on reopen.
+
+struct CandleColumns {
+    std::vector<int64_t> start;
+    std::vector<double> open;
+    std::vector<double> high;
+    std::vector<double> low;
+    std::vector<double> close;
+    std::vector<double> volume;
+
+    size_t size() const { return start.size(); }
+
+    void push_back(int64_t s, double o, double h, double l, double c, double v) {
+        start.push_back(s);
+        open.push_back(o);
+        high.push_back(h);
+        low.push_back(l);
+        close.push_back(c);
+        volume.push_back(v);
+    }
+
+    void clear() {
+        start.clear(); open.clear(); high.clear(); low.clear(); close.clear(); volume.clear();
+    }
+
+    // Sort ascending by start time and drop duplicate candles
+    void sortAndDedup() {
+        std::vector<size_t> order(size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return start[a] < start[b]; });
+
+        CandleColumns sorted;
+        for (size_t i : order) {
+            if (sorted.size() > 0 && sorted.start.back() == start[i]) {
+                continue;
+            }
+            sorted.push_back(start[i], open[i], high[i], low[i], close[i], volume[i]);
+        }
+        *this = std::move(sorted);
+    }
+};
+
+struct CandleFileHeader {
+    char magic[4] = {'C', 'B', 'C', '1'};
+    uint32_t version = 1;
+    int64_t granularitySeconds = 0;
+    int64_t rangeStart = 0; // Inclusive, epoch seconds
+    int64_t rangeEnd = 0;   // Exclusive, epoch seconds
+    int64_t chunkSeconds = 0;
+    char productId[32] = {};
+};
+
+struct CandleBlockHeader {
+    uint32_t magic = 0x314B4C42; // "BLK1"
+    uint32_t chunkIndex = 0;
+    uint32_t count = 0;
+    uint32_t checksum = 0; // FNV-1a over the column payload
+};
+
+inline uint32_t fnv1a(const void* data, size_t len, uint32_t hash = 2166136261u)
+{
+    const auto* p = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < len; i++) {
+        hash ^= p[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+inline uint32_t candleChecksum(const CandleColumns& c)
+{
+    size_t n = c.size();
+    uint32_t h = fnv1a(c.start.data(), n * sizeof(int64_t));
+    h = fnv1a(c.open.data(), n * sizeof(double), h);
+    h = fnv1a(c.high.data(), n * sizeof(double), h);
+    h = fnv1a(c.low.data(), n * sizeof(double), h);
+    h = fnv1a(c.close.data(), n * sizeof(double), h);
+    return fnv1a(c.volume.data(), n * sizeof(double), h);
+}
+
+// Bytes per candle in a block payload: start + open/high/low/close/volume
+constexpr size_t kCandleRecordBytes = sizeof(int64_t) + 5 * sizeof(double);
+
+// Reads the next block into out. Returns false at end of file or on a torn/corrupt block.
+inline bool readCandleBlock(std::FILE* f, CandleBlockHeader& bh, CandleColumns& out)
+{
+    if (std::fread(&bh, sizeof(bh), 1, f) != 1 || bh.magic != CandleBlockHeader{}.magic) {
+        return false;
+    }
+    // A corrupt count must not size the columns: the payload has to fit in what is left
+    long payloadStart = std::ftell(f);
+    if (payloadStart < 0 || std::fseek(f, 0, SEEK_END) != 0) {
+        return false;
+    }
+    long fileEnd = std::ftell(f);
+    if (fileEnd < payloadStart || std::fseek(f, payloadStart, SEEK_SET) != 0) {
+        return false;
+    }
+    size_t n = bh.count;
+    if (n > static_cast<size_t>(fileEnd - payloadStart) / kCandleRecordBytes) {
+        return false;
+    }
+    out.start.resize(n);
+    out.open.resize(n);
+    out.high.resize(n);
+    out.low.resize(n);
+    out.close.resize(n);
+    out.volume.resize(n);
+    bool ok = std::fread(out.start.data(), sizeof(int64_t), n, f) == n
+              && std::fread(out.open.data(), sizeof(double), n, f) == n
+              && std::fread(out.high.data(), sizeof(double), n, f) == n
+              && std::fread(out.low.data(), sizeof(double), n, f) == n
+              && std::fread(out.close.data(), sizeof(double), n, f) == n
+              && std::fread(out.volume.data(), sizeof(double), n, f) == n;
+    return ok && candleChecksum(out) == bh.checksum;
+}
+
+//------------------------------------------
+// WRITER (THREAD-SAFE APPEND)
+//------------------------------------------
+class CandleFileWriter {
+public:
+    ~CandleFileWriter() { close(); }
+
+    // Opens or creates path. completedChunks receives every chunk already on disk.
+    // Returns false if the file exists but was written for a different product/range.
+    bool open(const std::string& path, const CandleFileHeader& header, std::set<uint32_t>& completedChunks)
+    {
+        namespace fs = std::filesystem;
+        completedChunks.clear();
+
+        if (fs::exists(path) && fs::file_size(path) >= sizeof(CandleFileHeader)) {
+            std::FILE* in = std::fopen(path.c_str(), "rb");
+            if (!in) {
+                return false;
+            }
+            CandleFileHeader existing;
+            std::fread(&existing, sizeof(existing), 1, in);
+            if (std::memcmp(&existing, &header, sizeof(header)) != 0) {
+                std::cerr << "[ERROR] " << path << " was written for a different product/range.\n";
+                std::fclose(in);
+                return false;
+            }
+
+            // Walk blocks until the first torn one
+            long validEnd = std::ftell(in);
+            CandleBlockHeader bh;
+            CandleColumns scratch;
+            while (readCandleBlock(in, bh, scratch)) {
+                completedChunks.insert(bh.chunkIndex);
+                validEnd = std::ftell(in);
+            }
+            std::fclose(in);
+            fs::resize_file(path, static_cast<uintmax_t>(validEnd));
+
+            file_ = std::fopen(path.c_str(), "ab");
+            committed_ = static_cast<uintmax_t>(validEnd);
+        } else {
+            file_ = std::fopen(path.c_str(), "wb");
+            if (file_) {
+                std::fwrite(&header, sizeof(header), 1, file_);
+                std::fflush(file_);
+            }
+            committed_ = sizeof(header);
+        }
+        path_ = path;
+        return file_ != nullptr;
+    }
+
+    // Appends one completed chunk and flushes it, so the chunk survives an interruption.
+    // A failed append is cut back to the last complete block, so a retry starts clean.
+    bool appendBlock(uint32_t chunkIndex, const CandleColumns& c)
+    {
+        CandleBlockHeader bh;
+        bh.chunkIndex = chunkIndex;
+        bh.count = static_cast<uint32_t>(c.size());
+        bh.checksum = candleChecksum(c);
+
+        size_t n = c.size();
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!file_) {
+            return false;
+        }
+        bool ok = std::fwrite(&bh, sizeof(bh), 1, file_) == 1
+                  && std::fwrite(c.start.data(), sizeof(int64_t), n, file_) == n
+                  && std::fwrite(c.open.data(), sizeof(double), n, file_) == n
+                  && std::fwrite(c.high.data(), sizeof(double), n, file_) == n
+                  && std::fwrite(c.low.data(), sizeof(double), n, file_) == n
+                  && std::fwrite(c.close.data(), sizeof(double), n, file_) == n
+                  && std::fwrite(c.volume.data(), sizeof(double), n, file_) == n;
+        if (ok && std::fflush(file_) == 0) {
+            committed_ += sizeof(bh) + n * (sizeof(int64_t) + 5 * sizeof(double));
+            return true;
+        }
+        truncateToCommitted();
+        return false;
+    }
+
+    void close()
+    {
+        if (file_) {
+            std::fclose(file_);
+            file_ = nullptr;
+        }
+    }
+
+private:
+    // Drops a torn tail: reopened afterwards, since append mode writes at the (new) end
+    void truncateToCommitted()
+    {
+        std::fclose(file_);
+        std::error_code ec;
+        std::filesystem::resize_file(path_, committed_, ec);
+        if (ec) {
+            std::cerr << "[ERROR] Could not truncate " << path_ << ": " << ec.message() << "\n";
+        }
+        file_ = std::fopen(path_.c_str(), "ab");
+    }
+
+    std::FILE* file_ = nullptr;
+    std::string path_;
+    uintmax_t committed_ = 0; // Bytes up to the end of the last complete block
+    std::mutex mutex_;
+};
+
+//------------------------------------------
+// READER (FOR BACKTESTS)
+//------------------------------------------
+// Loads every valid block into one set of columns sorted by start time
+inline bool readCandleFile(const std::string& path, CandleFileHeader& header, CandleColumns& out)
+{
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) {
+        std::cerr << "[ERROR] Could not open candle file " << path << "\n";
+        return false;
+    }
+    out.clear();
+    if (std::fread(&header, sizeof(header), 1, f) != 1) {
+        std::fclose(f);
+        return false;
+    }
+
+    CandleBlockHeader bh;
+    CandleColumns block;
+    while (readCandleBlock(f, bh, block)) {
+        out.start.insert(out.start.end(), block.start.begin(), block.start.end());
+        out.open.insert(out.open.end(), block.open.begin(), block.open.end());
+        out.high.insert(out.high.end(), block.high.begin(), block.high.end());
+        out.low.insert(out.low.end(), block.low.begin(), block.low.end());
+        out.close.insert(out.close.end(), block.close.begin(), block.close.end());
+        out.volume.insert(out.volume.end(), block.volume.begin(), block.volume.end());
+    }
+    std::fclose(f);
+
+    out.sortAndDedup();
+    return true;
+}
+
+#endif // CANDLE_STORE_H
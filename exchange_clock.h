@@ -0,0 +1,89 @@
+// exchange_clock.h
+#ifndef EXCHANGE_CLOCK_H
+#define EXCHANGE_CLOCK_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+
+//------------------------------------------
+// EXCHANGE CLOCK
+//------------------------------------------
+// Tracks the offset between the local wall clock and the exchange clock.
+// Samples come from timing a request to the exchange time endpoint: the server
+// timestamp is assumed to be taken half way through the round trip. Of the last
+// kSamples samples, the one with the smallest RTT wins (least queueing noise).
+//
+// Readers (now(), offsetNanos()) are lock-free; addSample() is called from housekeeping.
+class ExchangeClock {
+public:
+    static constexpr size_t kSamples = 8;
+
+    // sendWallNanos: local wall clock when the request was sent
+    // rttNanos:      monotonic round trip
+    // serverNanos:   exchange timestamp from the response
+    void addSample(int64_t sendWallNanos, int64_t rttNanos, int64_t serverNanos)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Sample& s = samples_[next_++ % kSamples];
+        s.rttNanos = rttNanos;
+        s.offsetNanos = serverNanos - (sendWallNanos + rttNanos / 2);
+        s.valid = true;
+
+        const Sample* best = nullptr;
+        for (const Sample& c : samples_) {
+            if (c.valid && (!best || c.rttNanos < best->rttNanos)) {
+                best = &c;
+            }
+        }
+        offsetNanos_.store(best->offsetNanos, std::memory_order_relaxed);
+        rttNanos_.store(best->rttNanos, std::memory_order_relaxed);
+        synced_.store(true, std::memory_order_release);
+    }
+
+    // Exchange time = local wall clock + offset (offset is 0 until the first sample)
+    std::chrono::system_clock::time_point now() const
+    {
+        return std::chrono::system_clock::now()
+               + std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                       std::chrono::nanoseconds(offsetNanos_.load(std::memory_order_relaxed)));
+    }
+
+    time_t nowSeconds() const { return std::chrono::system_clock::to_time_t(now()); }
+
+    int64_t offsetNanos() const { return offsetNanos_.load(std::memory_order_relaxed); }
+    int64_t rttNanos() const { return rttNanos_.load(std::memory_order_relaxed); }
+    bool synced() const { return synced_.load(std::memory_order_acquire); }
+
+    static int64_t wallNanos()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+private:
+    struct Sample {
+        int64_t offsetNanos = 0;
+        int64_t rttNanos = 0;
+        bool valid = false;
+    };
+
+    std::mutex mutex_;
+    std::array<Sample, kSamples> samples_{};
+    size_t next_ = 0;
+    std::atomic<int64_t> offsetNanos_{0};
+    std::atomic<int64_t> rttNanos_{0};
+    std::atomic<bool> synced_{false};
+};
+
+// Process-wide exchange clock
+inline ExchangeClock& exchangeClock()
+{
+    static ExchangeClock instance;
+    return instance;
+}
+
+#endif // EXCHANGE_CLOCK_H
@@ -0,0 +1,752 @@
+// indicator_kernels.h
+#ifndef INDICATOR_KERNELS_H
+#define INDICATOR_KERNELS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define INDICATOR_KERNELS_X86 1
+#include <immintrin.h>
+#define KERNEL_TARGET(isa) __attribute__((target(isa)))
+// Fixed 4/8-step loops over vector arrays must unroll, or the arrays live on the stack
+#define KERNEL_UNROLL _Pragma("GCC unroll 8")
+#endif
+
+// GCC fuses a*b+c into an FMA whenever the target has one, which would make results depend
+// on the instruction set. Clang only contracts within one expression, which never happens here.
+// This only covers the kernels: the streaming classes they are compared against need the
+// whole build at -ffp-contract=off (CMakeLists.txt sets it), e.g. under -march=native.
+#if defined(__GNUC__) && !defined(__clang__)
+#define KERNEL_EXACT __attribute__((optimize("fp-contract=off")))
+#else
+#define KERNEL_EXACT
+#endif
+
+//------------------------------------------
+// BATCH INDICATOR KERNELS
+//------------------------------------------
+// Whole-array versions of the indicators.h recurrences for backtests and multi-product scans,
+// run over contiguous close columns (CandleColumns::close). Output i is what the streaming
+// indicator would return after input i, warm-up included.
+//
+// A running sum is one long dependency chain, so a single series is split into
+// kKernelLanes contiguous lanes. Lane 0 continues from the warm-up; every other lane seeds
+// itself from the window just before its first output. The SIMD paths step all lanes at
+// once (one AVX-512 vector, or two AVX2 vectors, per step); the scalar path steps them
+// one after another, which still gives the CPU eight independent chains.
+//
+// The streaming classes re-sum their window after every `period` updates. Lanes start on
+// those points, seed themselves the same way and re-sum at the same steps, so every output
+// is bit-identical to Sma<> / Bollinger<>, on the scalar, AVX2 and AVX-512 paths alike
+// (tests/indicator_kernels_test.cpp). EMA has no window to reseed, so it is vectorized
+// across series instead (one lane per product) and is bit-identical to Ema<>.
+
+enum class SimdLevel : uint8_t { Scalar, Avx2, Avx512 };
+
+constexpr size_t kKernelLanes = 8;
+constexpr size_t kMinLaneSteps = 1024;  // Shorter series run as one lane
+
+inline SimdLevel detectSimdLevel()
+{
+#ifdef INDICATOR_KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return SimdLevel::Avx512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return SimdLevel::Avx2;
+    }
+#endif
+    return SimdLevel::Scalar;
+}
+
+// Detected once. INDICATOR_SIMD=scalar|avx2|avx512 caps it (A/B runs, bisecting).
+inline SimdLevel activeSimdLevel()
+{
+    static const SimdLevel level = [] {
+        SimdLevel best = detectSimdLevel();
+        const char* env = std::getenv("INDICATOR_SIMD");
+        if (!env) {
+            return best;
+        }
+        std::string want(env);
+        SimdLevel cap = want == "scalar" ? SimdLevel::Scalar : want == "avx2" ? SimdLevel::Avx2 : SimdLevel::Avx512;
+        return std::min(cap, best);
+    }();
+    return level;
+}
+
+inline const char* simdLevelName(SimdLevel level)
+{
+    switch (level) {
+        case SimdLevel::Avx512: return "avx512";
+        case SimdLevel::Avx2: return "avx2";
+        default: return "scalar";
+    }
+}
+
+//------------------------------------------
+// LANE KERNELS
+//------------------------------------------
+// Each advances kKernelLanes lanes by `count` steps: lane k reads in[k][j] (entering the
+// window) and old[k][j] (leaving it) and writes out[k][j]. The SIMD versions load a block
+// of consecutive steps from every lane and transpose it in registers, so step j of all
+// lanes sits in one vector. They return how many steps they did (a whole number of
+// blocks); the driver finishes the rest with the scalar step.
+
+#ifdef INDICATOR_KERNELS_X86
+// r[k] = 4 consecutive values of lane k  <->  r[t] = step t of lanes 0..3
+KERNEL_TARGET("avx2") inline void transpose4(__m256d* r)
+{
+    __m256d t0 = _mm256_unpacklo_pd(r[0], r[1]);
+    __m256d t1 = _mm256_unpackhi_pd(r[0], r[1]);
+    __m256d t2 = _mm256_unpacklo_pd(r[2], r[3]);
+    __m256d t3 = _mm256_unpackhi_pd(r[2], r[3]);
+    r[0] = _mm256_permute2f128_pd(t0, t2, 0x20);
+    r[1] = _mm256_permute2f128_pd(t1, t3, 0x20);
+    r[2] = _mm256_permute2f128_pd(t0, t2, 0x31);
+    r[3] = _mm256_permute2f128_pd(t1, t3, 0x31);
+}
+
+// 8x8 version: unpack pairs, then gather 128-bit blocks twice
+KERNEL_TARGET("avx512f") inline void transpose8(__m512d* r)
+{
+    __m512d t[8];
+    KERNEL_UNROLL
+    for (int i = 0; i < 8; i += 2) {
+        t[i] = _mm512_unpacklo_pd(r[i], r[i + 1]);
+        t[i + 1] = _mm512_unpackhi_pd(r[i], r[i + 1]);
+    }
+    __m512d u[8];
+    KERNEL_UNROLL
+    for (int i = 0; i < 8; i += 4) {
+        u[i] = _mm512_shuffle_f64x2(t[i], t[i + 2], 0x88);     // steps 0, 4
+        u[i + 1] = _mm512_shuffle_f64x2(t[i], t[i + 2], 0xDD); // steps 2, 6
+        u[i + 2] = _mm512_shuffle_f64x2(t[i + 1], t[i + 3], 0x88); // steps 1, 5
+        u[i + 3] = _mm512_shuffle_f64x2(t[i + 1], t[i + 3], 0xDD); // steps 3, 7
+    }
+    r[0] = _mm512_shuffle_f64x2(u[0], u[4], 0x88);
+    r[4] = _mm512_shuffle_f64x2(u[0], u[4], 0xDD);
+    r[2] = _mm512_shuffle_f64x2(u[1], u[5], 0x88);
+    r[6] = _mm512_shuffle_f64x2(u[1], u[5], 0xDD);
+    r[1] = _mm512_shuffle_f64x2(u[2], u[6], 0x88);
+    r[5] = _mm512_shuffle_f64x2(u[2], u[6], 0xDD);
+    r[3] = _mm512_shuffle_f64x2(u[3], u[7], 0x88);
+    r[7] = _mm512_shuffle_f64x2(u[3], u[7], 0xDD);
+}
+
+// SMA: sum += in - old; value = sum / period
+KERNEL_TARGET("avx2") KERNEL_EXACT
+inline size_t smaLanesAvx2(double* sum, double period, const double* const* in, const double* const* old,
+                           double* const* out, size_t count)
+{
+    const __m256d p = _mm256_set1_pd(period);
+    size_t j = 0;
+    for (size_t h = 0; h < kKernelLanes; h += 4) {
+        __m256d s = _mm256_loadu_pd(sum + h);
+        for (j = 0; j + 4 <= count; j += 4) {
+            __m256d a[4];
+            __m256d b[4];
+            KERNEL_UNROLL
+            for (int k = 0; k < 4; k++) {
+                a[k] = _mm256_loadu_pd(in[h + k] + j);
+                b[k] = _mm256_loadu_pd(old[h + k] + j);
+            }
+            transpose4(a);
+            transpose4(b);
+            KERNEL_UNROLL
+            for (int t = 0; t < 4; t++) {
+                s = _mm256_add_pd(s, _mm256_sub_pd(a[t], b[t]));
+                a[t] = _mm256_div_pd(s, p);
+            }
+            transpose4(a);
+            KERNEL_UNROLL
+            for (int k = 0; k < 4; k++) {
+                _mm256_storeu_pd(out[h + k] + j, a[k]);
+            }
+        }
+        _mm256_storeu_pd(sum + h, s);
+    }
+    return j;
+}
+
+KERNEL_TARGET("avx512f") KERNEL_EXACT
+inline size_t smaLanesAvx512(double* sum, double period, const double* const* in, const double* const* old,
+                             double* const* out, size_t count)
+{
+    const __m512d p = _mm512_set1_pd(period);
+    __m512d s = _mm512_loadu_pd(sum);
+    size_t j = 0;
+    for (; j + 8 <= count; j += 8) {
+        __m512d a[8];
+        __m512d b[8];
+        KERNEL_UNROLL
+        for (int k = 0; k < 8; k++) {
+            a[k] = _mm512_loadu_pd(in[k] + j);
+            b[k] = _mm512_loadu_pd(old[k] + j);
+        }
+        transpose8(a);
+        transpose8(b);
+        KERNEL_UNROLL
+        for (int t = 0; t < 8; t++) {
+            s = _mm512_add_pd(s, _mm512_sub_pd(a[t], b[t]));
+            a[t] = _mm512_div_pd(s, p);
+        }
+        transpose8(a);
+        KERNEL_UNROLL
+        for (int k = 0; k < 8; k++) {
+            _mm512_storeu_pd(out[k] + j, a[k]);
+        }
+    }
+    _mm512_storeu_pd(sum, s);
+    return j;
+}
+
+// Rolling mean / population stddev: Welford replace step, as in Bollinger<>
+KERNEL_TARGET("avx2") KERNEL_EXACT
+inline size_t stddevLanesAvx2(double* mean, double* m2, double period, const double* const* in,
+                              const double* const* old, double* const* outMean, double* const* outStd, size_t count)
+{
+    const __m256d p = _mm256_set1_pd(period);
+    const __m256d zero = _mm256_setzero_pd();
+    size_t j = 0;
+    for (size_t h = 0; h < kKernelLanes; h += 4) {
+        __m256d mu = _mm256_loadu_pd(mean + h);
+        __m256d s2 = _mm256_loadu_pd(m2 + h);
+        for (j = 0; j + 4 <= count; j += 4) {
+            __m256d a[4];
+            __m256d b[4];
+            KERNEL_UNROLL
+            for (int k = 0; k < 4; k++) {
+                a[k] = _mm256_loadu_pd(in[h + k] + j);
+                b[k] = _mm256_loadu_pd(old[h + k] + j);
+            }
+            transpose4(a);
+            transpose4(b);
+            KERNEL_UNROLL
+            for (int t = 0; t < 4; t++) {
+                __m256d d = _mm256_sub_pd(a[t], b[t]);
+                __m256d oldMu = mu;
+                mu = _mm256_add_pd(mu, _mm256_div_pd(d, p));
+                __m256d e = _mm256_sub_pd(_mm256_add_pd(_mm256_sub_pd(a[t], mu), b[t]), oldMu);
+                s2 = _mm256_add_pd(s2, _mm256_mul_pd(d, e));
+                s2 = _mm256_blendv_pd(s2, zero, _mm256_cmp_pd(s2, zero, _CMP_LT_OQ));
+                a[t] = mu;
+                b[t] = _mm256_sqrt_pd(_mm256_div_pd(s2, p));
+            }
+            transpose4(a);
+            transpose4(b);
+            KERNEL_UNROLL
+            for (int k = 0; k < 4; k++) {
+                _mm256_storeu_pd(outMean[h + k] + j, a[k]);
+                _mm256_storeu_pd(outStd[h + k] + j, b[k]);
+            }
+        }
+        _mm256_storeu_pd(mean + h, mu);
+        _mm256_storeu_pd(m2 + h, s2);
+    }
+    return j;
+}
+
+KERNEL_TARGET("avx512f") KERNEL_EXACT
+inline size_t stddevLanesAvx512(double* mean, double* m2, double period, const double* const* in,
+                                const double* const* old, double* const* outMean, double* const* outStd, size_t count)
+{
+    const __m512d p = _mm512_set1_pd(period);
+    const __m512d zero = _mm512_setzero_pd();
+    __m512d mu = _mm512_loadu_pd(mean);
+    __m512d s2 = _mm512_loadu_pd(m2);
+    size_t j = 0;
+    for (; j + 8 <= count; j += 8) {
+        __m512d a[8];
+        __m512d b[8];
+        KERNEL_UNROLL
+        for (int k = 0; k < 8; k++) {
+            a[k] = _mm512_loadu_pd(in[k] + j);
+            b[k] = _mm512_loadu_pd(old[k] + j);
+        }
+        transpose8(a);
+        transpose8(b);
+        KERNEL_UNROLL
+        for (int t = 0; t < 8; t++) {
+            __m512d d = _mm512_sub_pd(a[t], b[t]);
+            __m512d oldMu = mu;
+            mu = _mm512_add_pd(mu, _mm512_div_pd(d, p));
+            __m512d e = _mm512_sub_pd(_mm512_add_pd(_mm512_sub_pd(a[t], mu), b[t]), oldMu);
+            s2 = _mm512_add_pd(s2, _mm512_mul_pd(d, e));
+            s2 = _mm512_mask_mov_pd(s2, _mm512_cmp_pd_mask(s2, zero, _CMP_LT_OQ), zero);
+            a[t] = mu;
+            b[t] = _mm512_sqrt_pd(_mm512_div_pd(s2, p));
+        }
+        transpose8(a);
+        transpose8(b);
+        KERNEL_UNROLL
+        for (int k = 0; k < 8; k++) {
+            _mm512_storeu_pd(outMean[k] + j, a[k]);
+            _mm512_storeu_pd(outStd[k] + j, b[k]);
+        }
+    }
+    _mm512_storeu_pd(mean, mu);
+    _mm512_storeu_pd(m2, s2);
+    return j;
+}
+
+// EMA steady state: value += alpha * (x - value)
+KERNEL_TARGET("avx2") KERNEL_EXACT
+inline size_t emaLanesAvx2(double* value, double alpha, const double* const* in, double* const* out, size_t count)
+{
+    const __m256d al = _mm256_set1_pd(alpha);
+    size_t j = 0;
+    for (size_t h = 0; h < kKernelLanes; h += 4) {
+        __m256d v = _mm256_loadu_pd(value + h);
+        for (j = 0; j + 4 <= count; j += 4) {
+            __m256d a[4];
+            KERNEL_UNROLL
+            for (int k = 0; k < 4; k++) {
+                a[k] = _mm256_loadu_pd(in[h + k] + j);
+            }
+            transpose4(a);
+            KERNEL_UNROLL
+            for (int t = 0; t < 4; t++) {
+                v = _mm256_add_pd(v, _mm256_mul_pd(al, _mm256_sub_pd(a[t], v)));
+                a[t] = v;
+            }
+            transpose4(a);
+            KERNEL_UNROLL
+            for (int k = 0; k < 4; k++) {
+                _mm256_storeu_pd(out[h + k] + j, a[k]);
+            }
+        }
+        _mm256_storeu_pd(value + h, v);
+    }
+    return j;
+}
+
+KERNEL_TARGET("avx512f") KERNEL_EXACT
+inline size_t emaLanesAvx512(double* value, double alpha, const double* const* in, double* const* out, size_t count)
+{
+    const __m512d al = _mm512_set1_pd(alpha);
+    __m512d v = _mm512_loadu_pd(value);
+    size_t j = 0;
+    for (; j + 8 <= count; j += 8) {
+        __m512d a[8];
+        KERNEL_UNROLL
+        for (int k = 0; k < 8; k++) {
+            a[k] = _mm512_loadu_pd(in[k] + j);
+        }
+        transpose8(a);
+        KERNEL_UNROLL
+        for (int t = 0; t < 8; t++) {
+            v = _mm512_add_pd(v, _mm512_mul_pd(al, _mm512_sub_pd(a[t], v)));
+            a[t] = v;
+        }
+        transpose8(a);
+        KERNEL_UNROLL
+        for (int k = 0; k < 8; k++) {
+            _mm512_storeu_pd(out[k] + j, a[k]);
+        }
+    }
+    _mm512_storeu_pd(value, v);
+    return j;
+}
+#endif // INDICATOR_KERNELS_X86
+
+//------------------------------------------
+// LANE DRIVER
+//------------------------------------------
+// Runs a windowed recurrence over positions [period, n) of x. The caller has already run
+// the warm-up [0, period) into lane 0 of the kernel. Kernel interface:
+//   static constexpr size_t kOutputs
+//   void seed(size_t lane, const double* window)   - state from `period` inputs (the re-sum)
+//   void emit(size_t lane, double* const* outs, size_t i)   - outputs for position i
+//   void step(size_t lane, double in, double old, double* const* outs, size_t i)   - update + emit
+//   size_t lanes(SimdLevel, in, old, out[kOutputs], count) - SIMD steps for all lanes, returns steps done
+
+// One scalar step at x[i], re-summing where the streaming class does (after every period-th input)
+template <typename Kernel>
+KERNEL_EXACT void stepLane(Kernel& kernel, size_t lane, const double* x, size_t i, size_t period, double* const* outs)
+{
+    kernel.step(lane, x[i], x[i - period], outs, i);
+    if ((i + 1) % period == 0) {
+        kernel.seed(lane, x + i + 1 - period);
+        kernel.emit(lane, outs, i);
+    }
+}
+
+template <typename Kernel>
+KERNEL_EXACT void runWindowLanes(Kernel& kernel, const double* x, size_t n, size_t period, double* const* outs,
+                                 SimdLevel level)
+{
+    if (n <= period) {
+        return;
+    }
+    size_t segment = (n - period) / kKernelLanes;
+    if (segment < std::max(period, kMinLaneSteps)) {
+        for (size_t i = period; i < n; i++) {
+            stepLane(kernel, 0, x, i, period, outs);
+        }
+        return;
+    }
+    // Lanes start on re-sum points, so seeding a lane is exactly the streaming re-sum there.
+    // The last lane takes what rounding down leaves over, so it is never the shortest.
+    segment -= segment % period;
+
+    size_t begin[kKernelLanes];
+    size_t length[kKernelLanes];
+    const double* in[kKernelLanes];
+    const double* old[kKernelLanes];
+    for (size_t k = 0; k < kKernelLanes; k++) {
+        begin[k] = period + k * segment;
+        length[k] = k + 1 < kKernelLanes ? segment : n - begin[k];
+        in[k] = x + begin[k];
+        old[k] = x + begin[k] - period;
+        if (k > 0) {
+            kernel.seed(k, old[k]);
+        }
+    }
+
+    // All lanes together, one re-sum interval at a time; then the last lane's extra steps alone
+    for (size_t j = 0; j < segment; j += period) {
+        const double* inAt[kKernelLanes];
+        const double* oldAt[kKernelLanes];
+        double* outAt[Kernel::kOutputs][kKernelLanes];
+        for (size_t k = 0; k < kKernelLanes; k++) {
+            inAt[k] = in[k] + j;
+            oldAt[k] = old[k] + j;
+            for (size_t o = 0; o < Kernel::kOutputs; o++) {
+                outAt[o][k] = outs[o] + begin[k] + j;
+            }
+        }
+        size_t done = kernel.lanes(level, inAt, oldAt, outAt, period);
+        for (size_t t = done; t < period; t++) {
+            for (size_t k = 0; k < kKernelLanes; k++) {
+                kernel.step(k, inAt[k][t], oldAt[k][t], outs, begin[k] + j + t);
+            }
+        }
+        for (size_t k = 0; k < kKernelLanes; k++) {
+            kernel.seed(k, inAt[k]);
+            kernel.emit(k, outs, begin[k] + j + period - 1);
+        }
+    }
+    size_t last = kKernelLanes - 1;
+    for (size_t i = begin[last] + segment; i < begin[last] + length[last]; i++) {
+        stepLane(kernel, last, x, i, period, outs);
+    }
+}
+
+//------------------------------------------
+// SMA
+//------------------------------------------
+struct SmaLanes {
+    static constexpr size_t kOutputs = 1;
+
+    size_t period;
+    double sum[kKernelLanes] = {};
+
+    KERNEL_EXACT void seed(size_t lane, const double* window)
+    {
+        double s = 0.0;
+        for (size_t i = 0; i < period; i++) {
+            s += window[i];
+        }
+        sum[lane] = s;
+    }
+
+    KERNEL_EXACT void emit(size_t lane, double* const* outs, size_t i)
+    {
+        outs[0][i] = sum[lane] / static_cast<double>(period);
+    }
+
+    KERNEL_EXACT void step(size_t lane, double in, double old, double* const* outs, size_t i)
+    {
+        sum[lane] += in - old;
+        emit(lane, outs, i);
+    }
+
+    KERNEL_EXACT size_t lanes(SimdLevel level, const double* const* in, const double* const* old,
+                              double* const (*out)[kKernelLanes], size_t count)
+    {
+#ifdef INDICATOR_KERNELS_X86
+        double p = static_cast<double>(period);
+        if (level == SimdLevel::Avx512) {
+            return smaLanesAvx512(sum, p, in, old, out[0], count);
+        }
+        if (level == SimdLevel::Avx2) {
+            return smaLanesAvx2(sum, p, in, old, out[0], count);
+        }
+#endif
+        (void)level; (void)in; (void)old; (void)out; (void)count;
+        return 0;
+    }
+};
+
+// out[i] = Sma<>(period) after x[0..i]
+KERNEL_EXACT inline void smaBatch(const double* x, size_t n, size_t period, double* out,
+                                  SimdLevel level = activeSimdLevel())
+{
+    SmaLanes kernel{std::max<size_t>(period, 1)};
+    double* outs[1] = {out};
+    size_t warm = std::min(n, kernel.period);
+    for (size_t i = 0; i < warm; i++) {
+        kernel.sum[0] += x[i];
+        out[i] = kernel.sum[0] / static_cast<double>(i + 1);
+    }
+    if (warm == kernel.period) {
+        kernel.seed(0, x); // First re-sum, once the window is full
+        kernel.emit(0, outs, warm - 1);
+    }
+    runWindowLanes(kernel, x, n, kernel.period, outs, level);
+}
+
+//------------------------------------------
+// ROLLING MEAN / STDDEV
+//------------------------------------------
+struct StddevLanes {
+    static constexpr size_t kOutputs = 2;
+
+    size_t period;
+    double mean[kKernelLanes] = {};
+    double m2[kKernelLanes] = {};
+
+    // Welford add, as Bollinger<> does while its window fills
+    KERNEL_EXACT static void add(double& mu, double& s2, double x, size_t count)
+    {
+        double delta = x - mu;
+        mu += delta / static_cast<double>(count);
+        s2 += delta * (x - mu);
+        if (s2 < 0.0) {
+            s2 = 0.0;
+        }
+    }
+
+    // Two passes over the window, as Bollinger<> re-sums
+    KERNEL_EXACT void seed(size_t lane, const double* window)
+    {
+        double sum = 0.0;
+        for (size_t i = 0; i < period; i++) {
+            sum += window[i];
+        }
+        double mu = sum / static_cast<double>(period);
+        double s2 = 0.0;
+        for (size_t i = 0; i < period; i++) {
+            s2 += (window[i] - mu) * (window[i] - mu);
+        }
+        mean[lane] = mu;
+        m2[lane] = s2;
+    }
+
+    KERNEL_EXACT void emit(size_t lane, double* const* outs, size_t i)
+    {
+        outs[0][i] = mean[lane];
+        outs[1][i] = std::sqrt(m2[lane] / static_cast<double>(period));
+    }
+
+    KERNEL_EXACT void step(size_t lane, double in, double old, double* const* outs, size_t i)
+    {
+        double p = static_cast<double>(period);
+        double oldMean = mean[lane];
+        mean[lane] += (in - old) / p;
+        m2[lane] += (in - old) * (in - mean[lane] + old - oldMean);
+        if (m2[lane] < 0.0) {
+            m2[lane] = 0.0;
+        }
+        emit(lane, outs, i);
+    }
+
+    KERNEL_EXACT size_t lanes(SimdLevel level, const double* const* in, const double* const* old,
+                              double* const (*out)[kKernelLanes], size_t count)
+    {
+#ifdef INDICATOR_KERNELS_X86
+        double p = static_cast<double>(period);
+        if (level == SimdLevel::Avx512) {
+            return stddevLanesAvx512(mean, m2, p, in, old, out[0], out[1], count);
+        }
+        if (level == SimdLevel::Avx2) {
+            return stddevLanesAvx2(mean, m2, p, in, old, out[0], out[1], count);
+        }
+#endif
+        (void)level; (void)in; (void)old; (void)out; (void)count;
+        return 0;
+    }
+};
+
+// mean[i] / stddev[i] = Bollinger<>(period).middle() / stddev() after x[0..i].
+// Bands are mean +/- k * stddev.
+KERNEL_EXACT inline void rollingStddevBatch(const double* x, size_t n, size_t period, double* mean, double* stddev,
+                                            SimdLevel level = activeSimdLevel())
+{
+    StddevLanes kernel{std::max<size_t>(period, 1)};
+    double* outs[2] = {mean, stddev};
+    size_t warm = std::min(n, kernel.period);
+    for (size_t i = 0; i < warm; i++) {
+        StddevLanes::add(kernel.mean[0], kernel.m2[0], x[i], i + 1);
+        mean[i] = kernel.mean[0];
+        stddev[i] = std::sqrt(kernel.m2[0] / static_cast<double>(i + 1));
+    }
+    if (warm == kernel.period) {
+        kernel.seed(0, x); // First re-sum, once the window is full
+        kernel.emit(0, outs, warm - 1);
+    }
+    runWindowLanes(kernel, x, n, kernel.period, outs, level);
+}
+
+//------------------------------------------
+// EMA (ACROSS SERIES)
+//------------------------------------------
+// out[s][i] = Ema<>(period) after series[s][0..i], for `count` series of n bars each.
+// Series are processed kKernelLanes at a time, one per lane; a partial last group pads
+// its spare lanes with a copy of the first series.
+KERNEL_EXACT inline void emaBatch(const double* const* series, size_t count, size_t n, size_t period,
+                                  double* const* out, SimdLevel level = activeSimdLevel())
+{
+    period = std::max<size_t>(period, 1);
+    const double alpha = 2.0 / (static_cast<double>(period) + 1.0);
+    size_t warm = std::min(n, period);
+    std::vector<double> spare;
+
+    for (size_t first = 0; first < count; first += kKernelLanes) {
+        size_t lanes = std::min(kKernelLanes, count - first);
+        double value[kKernelLanes] = {};
+        const double* in[kKernelLanes];
+        double* dst[kKernelLanes];
+        if (lanes < kKernelLanes) {
+            spare.resize(n - warm);
+        }
+        for (size_t k = 0; k < kKernelLanes; k++) {
+            bool real = k < lanes;
+            const double* x = series[real ? first + k : first];
+            // Seed with the running mean of the first `period` inputs, exactly as Ema<> does
+            double seedSum = 0.0;
+            for (size_t i = 0; i < warm; i++) {
+                seedSum += x[i];
+                value[k] = seedSum / static_cast<double>(i + 1);
+                if (real) {
+                    out[first + k][i] = value[k];
+                }
+            }
+            in[k] = x + warm;
+            dst[k] = real ? out[first + k] + warm : spare.data();
+        }
+
+        size_t steps = n - warm;
+        size_t done = 0;
+#ifdef INDICATOR_KERNELS_X86
+        if (level == SimdLevel::Avx512) {
+            done = emaLanesAvx512(value, alpha, in, dst, steps);
+        } else if (level == SimdLevel::Avx2) {
+            done = emaLanesAvx2(value, alpha, in, dst, steps);
+        }
+#endif
+        for (size_t k = 0; k < lanes; k++) {
+            double v = value[k];
+            for (size_t j = done; j < steps; j++) {
+                v += alpha * (in[k][j] - v);
+                dst[k][j] = v;
+            }
+        }
+    }
+    (void)level;
+}
+
+//------------------------------------------
+// CROSSOVER SIGNALS
+//------------------------------------------
+// out[i] = +1 where fast crosses above slow (below at i-1, above at i), -1 where it crosses
+// below, 0 otherwise (and at i = 0). Same rule as MaCrossSignal; NaN never crosses.
+inline void crossoverScalar(const double* fast, const double* slow, size_t begin, size_t n, int8_t* out)
+{
+    for (size_t i = std::max<size_t>(begin, 1); i < n; i++) {
+        bool up = fast[i - 1] < slow[i - 1] && fast[i] > slow[i];
+        bool down = fast[i - 1] > slow[i - 1] && fast[i] < slow[i];
+        out[i] = static_cast<int8_t>(up ? 1 : down ? -1 : 0);
+    }
+}
+
+#ifdef INDICATOR_KERNELS_X86
+// 4 compare bits -> 4 signal bytes
+struct CrossoverTable {
+    uint32_t up[16];
+    uint32_t down[16];
+
+    constexpr CrossoverTable() : up(), down()
+    {
+        for (uint32_t m = 0; m < 16; m++) {
+            for (uint32_t b = 0; b < 4; b++) {
+                if (m & (1u << b)) {
+                    up[m] |= 0x01u << (8 * b);
+                    down[m] |= 0xFFu << (8 * b);
+                }
+            }
+        }
+    }
+};
+inline constexpr CrossoverTable kCrossoverTable{};
+
+inline void storeCrossover(int8_t* out, unsigned up, unsigned down)
+{
+    uint32_t bytes = kCrossoverTable.up[up] | kCrossoverTable.down[down];
+    std::memcpy(out, &bytes, sizeof(bytes));
+}
+
+KERNEL_TARGET("avx2")
+inline size_t crossoverAvx2(const double* fast, const double* slow, size_t n, int8_t* out)
+{
+    size_t i = 1;
+    for (; i + 4 <= n; i += 4) {
+        __m256d f = _mm256_loadu_pd(fast + i);
+        __m256d s = _mm256_loadu_pd(slow + i);
+        __m256d fp = _mm256_loadu_pd(fast + i - 1);
+        __m256d sp = _mm256_loadu_pd(slow + i - 1);
+        __m256d up = _mm256_and_pd(_mm256_cmp_pd(fp, sp, _CMP_LT_OQ), _mm256_cmp_pd(f, s, _CMP_GT_OQ));
+        __m256d down = _mm256_and_pd(_mm256_cmp_pd(fp, sp, _CMP_GT_OQ), _mm256_cmp_pd(f, s, _CMP_LT_OQ));
+        storeCrossover(out + i, static_cast<unsigned>(_mm256_movemask_pd(up)),
+                       static_cast<unsigned>(_mm256_movemask_pd(down)));
+    }
+    return i;
+}
+
+KERNEL_TARGET("avx512f")
+inline size_t crossoverAvx512(const double* fast, const double* slow, size_t n, int8_t* out)
+{
+    size_t i = 1;
+    for (; i + 8 <= n; i += 8) {
+        __m512d f = _mm512_loadu_pd(fast + i);
+        __m512d s = _mm512_loadu_pd(slow + i);
+        __m512d fp = _mm512_loadu_pd(fast + i - 1);
+        __m512d sp = _mm512_loadu_pd(slow + i - 1);
+        unsigned up = _mm512_cmp_pd_mask(fp, sp, _CMP_LT_OQ) & _mm512_cmp_pd_mask(f, s, _CMP_GT_OQ);
+        unsigned down = _mm512_cmp_pd_mask(fp, sp, _CMP_GT_OQ) & _mm512_cmp_pd_mask(f, s, _CMP_LT_OQ);
+        storeCrossover(out + i, up & 0xF, down & 0xF);
+        storeCrossover(out + i + 4, up >> 4, down >> 4);
+    }
+    return i;
+}
+#endif // INDICATOR_KERNELS_X86
+
+inline void crossoverBatch(const double* fast, const double* slow, size_t n, int8_t* out,
+                           SimdLevel level = activeSimdLevel())
+{
+    if (n == 0) {
+        return;
+    }
+    out[0] = 0;
+    size_t done = 1;
+#ifdef INDICATOR_KERNELS_X86
+    if (level == SimdLevel::Avx512) {
+        done = crossoverAvx512(fast, slow, n, out);
+    } else if (level == SimdLevel::Avx2) {
+        done = crossoverAvx2(fast, slow, n, out);
+    }
+#endif
+    (void)level;
+    crossoverScalar(fast, slow, done, n, out);
+}
+
+#endif // INDICATOR_KERNELS_H
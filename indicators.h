@@ -0,0 +1,416 @@
+// indicators.h
+#ifndef INDICATORS_H
+#define INDICATORS_H
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+//------------------------------------------
+// STREAMING INDICATORS
+//------------------------------------------
+// Every indicator is updated in O(1) per bar (or trade) and keeps only what it needs:
+// running sums plus, for windowed ones, a ring buffer of the last N inputs.
+// Windowed running sums pick up rounding error with every add/remove, so they are
+// recomputed from the window once per N updates (O(1) amortized); the drift never
+// accumulates beyond one window's worth of updates.
+//
+// The window is a template parameter when it is known at compile time
+// (Sma<20>: std::array storage, constant divisors) and kDynamicWindow otherwise
+// (Sma<> sma(period): one vector allocated at construction, none afterwards).
+// value() is meaningful once ready() returns true.
+
+constexpr size_t kDynamicWindow = 0;
+
+struct Bar {
+    double open = 0.0;
+    double high = 0.0;
+    double low = 0.0;
+    double close = 0.0;
+    double volume = 0.0;
+};
+
+//------------------------------------------
+// RING BUFFER
+//------------------------------------------
+// Fixed-capacity FIFO; push() returns the element it overwrote once full.
+template <typename T, size_t N>
+class RingBuffer {
+public:
+    explicit RingBuffer(size_t capacity = N) { assert(capacity == N); (void)capacity; }
+
+    T push(T value)
+    {
+        T evicted = data_[head_];
+        data_[head_] = value;
+        head_ = (head_ + 1 == N) ? 0 : head_ + 1;
+        if (count_ < N) {
+            count_++;
+            evicted = T{};
+        }
+        return evicted;
+    }
+
+    bool full() const { return count_ == N; }
+    size_t size() const { return count_; }
+    static constexpr size_t capacity() { return N; }
+    void clear() { head_ = 0; count_ = 0; }
+
+    // Visits the stored values, oldest first
+    template <typename Fn>
+    void forEach(Fn&& fn) const
+    {
+        size_t i = count_ < N ? 0 : head_;
+        for (size_t k = 0; k < count_; k++) {
+            fn(data_[i]);
+            i = (i + 1 == N) ? 0 : i + 1;
+        }
+    }
+
+private:
+    std::array<T, N> data_{};
+    size_t head_ = 0;
+    size_t count_ = 0;
+};
+
+template <typename T>
+class RingBuffer<T, kDynamicWindow> {
+public:
+    explicit RingBuffer(size_t capacity) : data_(std::max<size_t>(capacity, 1)) {}
+
+    T push(T value)
+    {
+        T evicted = data_[head_];
+        data_[head_] = value;
+        head_ = (head_ + 1 == data_.size()) ? 0 : head_ + 1;
+        if (count_ < data_.size()) {
+            count_++;
+            evicted = T{};
+        }
+        return evicted;
+    }
+
+    bool full() const { return count_ == data_.size(); }
+    size_t size() const { return count_; }
+    size_t capacity() const { return data_.size(); }
+    void clear() { head_ = 0; count_ = 0; }
+
+    // Visits the stored values, oldest first
+    template <typename Fn>
+    void forEach(Fn&& fn) const
+    {
+        size_t i = count_ < data_.size() ? 0 : head_;
+        for (size_t k = 0; k < count_; k++) {
+            fn(data_[i]);
+            i = (i + 1 == data_.size()) ? 0 : i + 1;
+        }
+    }
+
+private:
+    std::vector<T> data_;
+    size_t head_ = 0;
+    size_t count_ = 0;
+};
+
+//------------------------------------------
+// SMA
+//------------------------------------------
+template <size_t N = kDynamicWindow>
+class Sma {
+public:
+    explicit Sma(size_t period = N) : window_(period) {}
+
+    double update(double x)
+    {
+        sum_ += x - window_.push(x);
+        if (++sinceResum_ == window_.capacity()) {
+            sinceResum_ = 0;
+            sum_ = 0.0;
+            window_.forEach([this](double v) { sum_ += v; });
+        }
+        return value();
+    }
+
+    double value() const { return window_.size() ? sum_ / static_cast<double>(window_.size()) : 0.0; }
+    bool ready() const { return window_.full(); }
+    size_t period() const { return window_.capacity(); }
+    void reset() { window_.clear(); sum_ = 0.0; sinceResum_ = 0; }
+
+private:
+    RingBuffer<double, N> window_;
+    double sum_ = 0.0;
+    size_t sinceResum_ = 0;
+};
+
+//------------------------------------------
+// EMA
+//------------------------------------------
+// alpha = 2 / (period + 1), seeded with the SMA of the first `period` inputs.
+// Needs no window, so the template parameter only fixes alpha at compile time.
+template <size_t N = kDynamicWindow>
+class Ema {
+public:
+    explicit Ema(size_t period = N)
+        : period_(std::max<size_t>(period, 1)), alpha_(2.0 / (static_cast<double>(period_) + 1.0)) {}
+
+    double update(double x)
+    {
+        if (count_ < period_) {
+            seedSum_ += x;
+            count_++;
+            value_ = seedSum_ / static_cast<double>(count_);
+        } else {
+            value_ += alpha_ * (x - value_);
+        }
+        return value_;
+    }
+
+    double value() const { return value_; }
+    bool ready() const { return count_ >= period_; }
+    size_t period() const { return period_; }
+    void reset() { count_ = 0; seedSum_ = 0.0; value_ = 0.0; }
+
+private:
+    size_t period_;
+    double alpha_;
+    size_t count_ = 0;
+    double seedSum_ = 0.0;
+    double value_ = 0.0;
+};
+
+//------------------------------------------
+// VWAP
+//------------------------------------------
+// Session VWAP: cumulative since the last reset() (call at session start).
+class Vwap {
+public:
+    double update(double price, double volume)
+    {
+        pv_ += price * volume;
+        volume_ += volume;
+        return value();
+    }
+
+    // Typical price (H+L+C)/3 weighted by bar volume
+    double update(const Bar& bar) { return update((bar.high + bar.low + bar.close) / 3.0, bar.volume); }
+
+    double value() const { return volume_ > 0.0 ? pv_ / volume_ : 0.0; }
+    bool ready() const { return volume_ > 0.0; }
+    double volume() const { return volume_; }
+    void reset() { pv_ = 0.0; volume_ = 0.0; }
+
+private:
+    double pv_ = 0.0;
+    double volume_ = 0.0;
+};
+
+// VWAP over the last N updates
+template <size_t N = kDynamicWindow>
+class RollingVwap {
+public:
+    explicit RollingVwap(size_t period = N) : window_(period) {}
+
+    double update(double price, double volume)
+    {
+        Entry in{price * volume, volume};
+        Entry out = window_.push(in);
+        pv_ += in.pv - out.pv;
+        volume_ += in.volume - out.volume;
+        if (++sinceResum_ == window_.capacity()) {
+            sinceResum_ = 0;
+            pv_ = 0.0;
+            volume_ = 0.0;
+            window_.forEach([this](const Entry& e) { pv_ += e.pv; volume_ += e.volume; });
+        }
+        return value();
+    }
+
+    double update(const Bar& bar) { return update((bar.high + bar.low + bar.close) / 3.0, bar.volume); }
+
+    double value() const { return volume_ > 0.0 ? pv_ / volume_ : 0.0; }
+    bool ready() const { return window_.full(); }
+    void reset() { window_.clear(); pv_ = 0.0; volume_ = 0.0; sinceResum_ = 0; }
+
+private:
+    struct Entry {
+        double pv = 0.0;
+        double volume = 0.0;
+    };
+
+    RingBuffer<Entry, N> window_;
+    double pv_ = 0.0;
+    double volume_ = 0.0;
+    size_t sinceResum_ = 0;
+};
+
+//------------------------------------------
+// RSI (WILDER)
+//------------------------------------------
+// Average gain/loss seeded with the simple mean of the first `period` changes, then
+// smoothed with alpha = 1 / period.
+template <size_t N = kDynamicWindow>
+class Rsi {
+public:
+    explicit Rsi(size_t period = N) : period_(std::max<size_t>(period, 1)) {}
+
+    double update(double close)
+    {
+        if (!havePrev_) {
+            prev_ = close;
+            havePrev_ = true;
+            return value();
+        }
+        double change = close - prev_;
+        prev_ = close;
+        double gain = change > 0.0 ? change : 0.0;
+        double loss = change < 0.0 ? -change : 0.0;
+
+        double n = static_cast<double>(period_);
+        if (count_ < period_) {
+            avgGain_ += gain / n;
+            avgLoss_ += loss / n;
+            count_++;
+        } else {
+            avgGain_ += (gain - avgGain_) / n;
+            avgLoss_ += (loss - avgLoss_) / n;
+        }
+        return value();
+    }
+
+    double value() const
+    {
+        if (count_ < period_) {
+            return 50.0;
+        }
+        if (avgLoss_ == 0.0) {
+            return avgGain_ == 0.0 ? 50.0 : 100.0;
+        }
+        return 100.0 - 100.0 / (1.0 + avgGain_ / avgLoss_);
+    }
+
+    bool ready() const { return count_ >= period_; }
+    void reset() { havePrev_ = false; count_ = 0; avgGain_ = 0.0; avgLoss_ = 0.0; }
+
+private:
+    size_t period_;
+    size_t count_ = 0;
+    bool havePrev_ = false;
+    double prev_ = 0.0;
+    double avgGain_ = 0.0;
+    double avgLoss_ = 0.0;
+};
+
+//------------------------------------------
+// BOLLINGER BANDS
+//------------------------------------------
+// Rolling mean and population standard deviation over N closes, bands at mean +/- k*stddev.
+// Mean and sum of squared deviations are updated for the value that enters and the one
+// that leaves (Welford add/remove), which avoids the cancellation of sum(x^2) - n*mean^2.
+// The add/remove steps still drift (the variance is small next to the price), so both are
+// recomputed with two passes over the window once per N updates.
+template <size_t N = kDynamicWindow>
+class Bollinger {
+public:
+    explicit Bollinger(size_t period = N, double k = 2.0) : window_(period), k_(k) {}
+
+    void update(double x)
+    {
+        bool wasFull = window_.full();
+        double out = window_.push(x);
+        if (wasFull) {
+            // Replace `out` by `x`: n stays the same
+            double n = static_cast<double>(window_.size());
+            double oldMean = mean_;
+            mean_ += (x - out) / n;
+            m2_ += (x - out) * (x - mean_ + out - oldMean);
+        } else {
+            double n = static_cast<double>(window_.size());
+            double delta = x - mean_;
+            mean_ += delta / n;
+            m2_ += delta * (x - mean_);
+        }
+        if (m2_ < 0.0) {
+            m2_ = 0.0; // Rounding
+        }
+        if (++sinceResum_ == window_.capacity()) {
+            sinceResum_ = 0;
+            resum();
+        }
+    }
+
+    double middle() const { return mean_; }
+    double stddev() const { return window_.size() ? std::sqrt(m2_ / static_cast<double>(window_.size())) : 0.0; }
+    double upper() const { return mean_ + k_ * stddev(); }
+    double lower() const { return mean_ - k_ * stddev(); }
+    // Where x sits in the band: 0 = lower, 1 = upper
+    double percentB(double x) const
+    {
+        double width = upper() - lower();
+        return width > 0.0 ? (x - lower()) / width : 0.5;
+    }
+
+    bool ready() const { return window_.full(); }
+    void reset() { window_.clear(); mean_ = 0.0; m2_ = 0.0; sinceResum_ = 0; }
+
+private:
+    void resum()
+    {
+        double sum = 0.0;
+        window_.forEach([&](double v) { sum += v; });
+        mean_ = sum / static_cast<double>(window_.size());
+        m2_ = 0.0;
+        window_.forEach([&](double v) { m2_ += (v - mean_) * (v - mean_); });
+    }
+
+    RingBuffer<double, N> window_;
+    double k_;
+    double mean_ = 0.0;
+    double m2_ = 0.0;
+    size_t sinceResum_ = 0;
+};
+
+//------------------------------------------
+// ATR (WILDER)
+//------------------------------------------
+// True range = max(high - low, |high - prevClose|, |low - prevClose|), seeded with the
+// mean of the first `period` true ranges, then smoothed with alpha = 1 / period.
+template <size_t N = kDynamicWindow>
+class Atr {
+public:
+    explicit Atr(size_t period = N) : period_(std::max<size_t>(period, 1)) {}
+
+    double update(const Bar& bar)
+    {
+        double tr = bar.high - bar.low;
+        if (havePrev_) {
+            tr = std::max({tr, std::fabs(bar.high - prevClose_), std::fabs(bar.low - prevClose_)});
+        }
+        prevClose_ = bar.close;
+        havePrev_ = true;
+
+        double n = static_cast<double>(period_);
+        if (count_ < period_) {
+            count_++;
+            value_ += (tr - value_) / static_cast<double>(count_); // Running mean while seeding
+        } else {
+            value_ += (tr - value_) / n;
+        }
+        return value_;
+    }
+
+    double value() const { return value_; }
+    bool ready() const { return count_ >= period_; }
+    void reset() { havePrev_ = false; count_ = 0; value_ = 0.0; prevClose_ = 0.0; }
+
+private:
+    size_t period_;
+    size_t count_ = 0;
+    bool havePrev_ = false;
+    double prevClose_ = 0.0;
+    double value_ = 0.0;
+};
+
+#endif // INDICATORS_H
@@ -0,0 +1,133 @@
+// key_pool.h
+#ifndef KEY_POOL_H
+#define KEY_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rate_limiter.h"
+
+//------------------------------------------
+// API KEY POOL
+//------------------------------------------
+// Coinbase rate-limits per API key. With several keys, market-data requests are spread
+// across all of them so the aggregate budget is the sum of the keys' budgets; order
+// traffic stays pinned to the key of the portfolio it trades for, because orders can only
+// be placed (and looked up) with a key that belongs to that portfolio.
+//
+// Each key has its own token bucket. JWTs are signed with the key they are sent under.
+struct ApiCredential {
+    std::string keyName;
+    std::string privateKeyPem;
+    std::string portfolio;   // Label from KEY_PORTFOLIO[_n]; empty = default portfolio
+    RateLimiter limiter;
+
+    ApiCredential(std::string name, std::string pem, std::string portfolioName, double requestsPerSecond)
+        : keyName(std::move(name)), privateKeyPem(std::move(pem)), portfolio(std::move(portfolioName)),
+          limiter(requestsPerSecond, requestsPerSecond) {}
+};
+
+class KeyPool {
+public:
+    // Startup only
+    void add(std::string keyName, std::string privateKeyPem, std::string portfolio, double requestsPerSecond)
+    {
+        keys_.push_back(std::make_unique<ApiCredential>(std::move(keyName), std::move(privateKeyPem),
+                                                        std::move(portfolio), requestsPerSecond));
+    }
+
+    // KEY_NAME / PRIVATE_KEY_PEM / KEY_PORTFOLIO, then KEY_NAME_1 / PRIVATE_KEY_PEM_1 / KEY_PORTFOLIO_1, ...
+    // up to the first missing index. PEMs may use literal "\n" for line breaks.
+    bool loadFromEnv(double requestsPerSecond)
+    {
+        if (!(requestsPerSecond > 0)) {
+            std::cerr << "[ERROR] The per-key request rate (API_KEY_RPS) must be positive.\n";
+            return false;
+        }
+        for (int i = 0;; i++) {
+            std::string suffix = i == 0 ? "" : "_" + std::to_string(i);
+            const char* name = std::getenv(("KEY_NAME" + suffix).c_str());
+            const char* pem = std::getenv(("PRIVATE_KEY_PEM" + suffix).c_str());
+            if (!name || !pem) {
+                if (i == 0) {
+                    std::cerr << "[ERROR] KEY_NAME and PRIVATE_KEY_PEM must be set.\n";
+                    return false;
+                }
+                break;
+            }
+            const char* portfolio = std::getenv(("KEY_PORTFOLIO" + suffix).c_str());
+            add(name, unescapePem(pem), portfolio ? portfolio : "", requestsPerSecond);
+        }
+        return true;
+    }
+
+    // Market data: the next key in rotation that has a token, or wait on the next one
+    ApiCredential& acquireMarketData()
+    {
+        size_t start = cursor_.fetch_add(1, std::memory_order_relaxed);
+        for (size_t i = 0; i < keys_.size(); i++) {
+            ApiCredential& key = *keys_[(start + i) % keys_.size()];
+            if (key.limiter.tryAcquire()) {
+                return key;
+            }
+        }
+        ApiCredential& key = *keys_[start % keys_.size()];
+        key.limiter.acquire();
+        return key;
+    }
+
+    // Non-blocking version for event loops: a key with a token, or nullptr and the time
+    // until the first key has one
+    ApiCredential* tryAcquireMarketData(std::chrono::nanoseconds& wait)
+    {
+        size_t start = cursor_.fetch_add(1, std::memory_order_relaxed);
+        wait = std::chrono::nanoseconds::max();
+        for (size_t i = 0; i < keys_.size(); i++) {
+            ApiCredential& key = *keys_[(start + i) % keys_.size()];
+            std::chrono::nanoseconds keyWait{};
+            if (key.limiter.tryAcquire(keyWait)) {
+                return &key;
+            }
+            wait = std::min(wait, keyWait);
+        }
+        return nullptr;
+    }
+
+    // Orders: the first key tagged with `portfolio`, or KEY_NAME when no portfolio is asked
+    // for. nullptr if no key belongs to the portfolio: orders must never go to another account.
+    ApiCredential* orderKey(const std::string& portfolio)
+    {
+        if (portfolio.empty()) {
+            return keys_.empty() ? nullptr : keys_.front().get();
+        }
+        for (auto& key : keys_) {
+            if (key->portfolio == portfolio) {
+                return key.get();
+            }
+        }
+        return nullptr;
+    }
+
+    size_t size() const { return keys_.size(); }
+
+private:
+    static std::string unescapePem(std::string pem)
+    {
+        size_t pos = 0;
+        while ((pos = pem.find("\\n", pos)) != std::string::npos) {
+            pem.replace(pos, 2, "\n");
+        }
+        return pem;
+    }
+
+    std::vector<std::unique_ptr<ApiCredential>> keys_;
+    std::atomic<size_t> cursor_{0};
+};
+
+#endif // KEY_POOL_H
@@ -5,6 +5,45 @@
 #include <vector>
 #include <algorithm>
 #include <numeric>
+#include <memory_resource>
+#include <charconv>
+#include <string_view>
+#include <atomic>
+#include <new>
+#include <cstdlib>
+#include <cstdio>
+#include <climits>
+#include <filesystem>
+#include <memory>
+#include <map>
+#include <ctime>
+#include <csignal>
+
+#include "tick_arena.h"
+#include "rate_limiter.h"
+#include "candle_store.h"
+#include "risk_engine.h"
+#include "metrics.h"
+#include "replay_log.h"
+#include "threading.h"
+#include "exchange_clock.h"
+#include "request_control.h"
+#include "order_id.h"
+#include "order_tracker.h"
+#include "user_channel.h"
+#include "order_book.h"
+#include "strategy.h"
+#include "state_journal.h"
+#include "paper_exchange.h"
+#include "key_pool.h"
+#include "market_capture.h"
+#include "market_bus.h"
+#ifdef COINBASEBOT_ASYNC_CLIENT
+#include "async_client.h"
+#endif
+#ifdef COINBASEBOT_BEAST_HTTP
+#include "beast_transport.h"
+#endif
 
 // External dependencies:
 // - OpenSSL RAND_bytes
@@ -17,95 +56,494 @@
 #include <curl/curl.h>
 #include <nlohmann/json.hpp>
 
+//------------------------------------------
+// 0) HEAP ALLOCATION COUNTER (OPTIONAL)
+//------------------------------------------
+// Build with -DCOUNT_HEAP_ALLOCATIONS to count every operator new call.
+// The main loop then prints the per-tick delta so the effect of the tick arena can be measured.
+static std::atomic<size_t> g_heapAllocations{0};
+
+#ifdef COUNT_HEAP_ALLOCATIONS
+void* operator new(std::size_t size)
+{
+    g_heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+#endif
+
+size_t heapAllocationCount()
+{
+    return g_heapAllocations.load(std::memory_order_relaxed);
+}
+
+// Monotonic timestamp for rate windows and latency measurement
+int64_t monotonicNanos()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Capture (CAPTURE_FILE) and replay (REPLAY_FILE) of every REST exchange; both null in normal runs
+static std::unique_ptr<EventRecorder> g_recorder;
+static std::unique_ptr<EventReplayer> g_replayer;
+// Paper trading (PAPER_TRADING=1): order endpoints answered by a local matching simulator
+static std::unique_ptr<PaperExchange> g_paper;
+
+// Set by SIGINT/SIGTERM; the bot loops see it and shut down cleanly (CANCEL_ON_EXIT then runs)
+static std::atomic<bool> g_stopRequested{false};
+static_assert(std::atomic<bool>::is_always_lock_free, "stop flag must be lock-free to be set from a signal handler");
+
+extern "C" void onStopSignal(int sig)
+{
+    g_stopRequested.store(true);
+    std::signal(sig, SIG_DFL); // A second Ctrl-C kills the process outright
+}
+
+// Transport for single REST requests: libcurl, or pooled Boost.Beast connections in a
+// HTTP_TRANSPORT=beast build. Batches always go through curl's multiplexed multi handle.
+enum class HttpTransport : uint8_t { Curl, Beast };
+#ifdef COINBASEBOT_BEAST_HTTP
+static HttpTransport g_httpTransport = HttpTransport::Beast;
+#else
+static HttpTransport g_httpTransport = HttpTransport::Curl;
+#endif
+
 //------------------------------------------
 // 1) CREATE_JWT FUNCTION
 //------------------------------------------
 std::string create_jwt(
         const std::string& keyName, // Key ID
         const std::string& privateKeyPem, // Private Key
-        const std::string& httpMethod, // "Delete" (not used), "Get", "Post"
-        const std::string& requestPath // Relative Path to Endpoint
+        std::string_view httpMethod, // "Delete" (not used), "Get", "Post"
+        std::string_view requestPath, // Relative Path to Endpoint
+        std::pmr::memory_resource* mr = std::pmr::get_default_resource() // Scratch memory for transient strings
 ) {
     // Creating URI
     // The domain for advanced trade is always "api.coinbase.com"
-    std::string url = "api.coinbase.com";
-    std::string uri = httpMethod + " " + url + requestPath;
+    constexpr std::string_view url = "api.coinbase.com";
+    std::pmr::string uri(mr);
+    uri.reserve(httpMethod.size() + 1 + url.size() + requestPath.size());
+    uri.append(httpMethod).append(" ").append(url).append(requestPath);
 
     // Generate Random 16-byte Nonce
     // Ensuring Each JWT is Unique
     unsigned char nonce_raw[16];
     RAND_bytes(nonce_raw, sizeof(nonce_raw));
-    std::string nonce(reinterpret_cast<char*>(nonce_raw), sizeof(nonce_raw));
+    std::pmr::string nonce(reinterpret_cast<char*>(nonce_raw), sizeof(nonce_raw), mr);
 
     // Create the JWT (expires in 120 seconds)
     // Signing with ES256 Elliptical Curve
+    // nbf/exp use exchange time so local clock skew can't make the token look early or expired
+    ScopedTimer signTimer(metrics().jwtSignTime);
+    auto issuedAt = exchangeClock().now();
     auto token = jwt::create()
             .set_subject(keyName)
             .set_issuer("cdp")
-            .set_not_before(std::chrono::system_clock::now())
-            .set_expires_at(std::chrono::system_clock::now() + std::chrono::seconds{120})
-            .set_payload_claim("uri", jwt::claim(uri))
+            .set_not_before(issuedAt)
+            .set_expires_at(issuedAt + std::chrono::seconds{120})
+            .set_payload_claim("uri", jwt::claim(std::string(uri))) // jwt-cpp only accepts std::string claims
             .set_header_claim("kid", jwt::claim(keyName))
-            .set_header_claim("nonce", jwt::claim(nonce))
+            .set_header_claim("nonce", jwt::claim(std::string(nonce)))
             .sign(jwt::algorithm::es256(keyName, privateKeyPem));
 
     return token;
 }
 
+// JWT for the WebSocket user channel: same key and claims, but no "uri"
+std::string create_ws_jwt(
+        const std::string& keyName, // Key ID
+        const std::string& privateKeyPem // Private Key
+) {
+    unsigned char nonce_raw[16];
+    RAND_bytes(nonce_raw, sizeof(nonce_raw));
+    std::string nonce(reinterpret_cast<char*>(nonce_raw), sizeof(nonce_raw));
+
+    auto issuedAt = exchangeClock().now();
+    return jwt::create()
+            .set_subject(keyName)
+            .set_issuer("cdp")
+            .set_not_before(issuedAt)
+            .set_expires_at(issuedAt + std::chrono::seconds{120})
+            .set_header_claim("kid", jwt::claim(keyName))
+            .set_header_claim("nonce", jwt::claim(nonce))
+            .sign(jwt::algorithm::es256(keyName, privateKeyPem));
+}
+
 //------------------------------------------
 // 2) HTTP REQUEST FUNCTION (LIBCURL)
 //------------------------------------------
+template <typename StringT>
 static size_t WriteCallback(void* contents, size_t size, size_t nmemb, void* userp)
 {
-    ((std::string*)userp)->append((char*)contents, size * nmemb); // Appends Received Response JSON in String format to readBuffer (httpRequest) or userp
+    ((StringT*)userp)->append((char*)contents, size * nmemb); // Appends Received Response JSON in String format to readBuffer (httpRequest) or userp
     return size * nmemb; // Returns size Total Number of Bytes or the actual length of data received
 }
 
-std::string httpRequest(
-        const std::string& method, // "Delete" (Not Used), "Get", "Post"
-        const std::string& url, // Full Url
-        const std::string& bearerToken, // Signed JWT
-        const std::string& postData = "" // JSON Body for Post
+// Headers for one attempt: JWT as Bearer token (omitted for public endpoints) + JSON content type
+static curl_slist* makeRequestHeaders(std::string_view bearerToken)
+{
+    struct curl_slist* headers = nullptr;
+    if (!bearerToken.empty()) {
+        std::string authHeader = "Authorization: Bearer ";
+        authHeader.append(bearerToken);
+        headers = curl_slist_append(headers, authHeader.c_str()); // curl copies the string
+    }
+    return curl_slist_append(headers, "Content-Type: application/json"); // Specify JSON to Curl
+}
+
+// A hedged attempt only wins with an answer worth keeping: 5xx and 429 let the other one finish
+static bool usableHttpStatus(long status)
+{
+    return status > 0 && status < 500 && status != 429;
+}
+
+// One easy handle per attempt, bounded by the request deadline
+template <typename StringT>
+static CURL* makeRequestHandle(
+        const std::string& method,
+        const char* url,
+        curl_slist* headers,
+        const std::string& postData,
+        StringT& readBuffer,
+        int64_t deadlineNanos
 ) {
-    // Creating a new Curl Session
-    // Initializing our return output (String type, JSON format)
     CURL* curl = curl_easy_init();
-    std::string readBuffer;
+    if (!curl) {
+        return nullptr;
+    }
+
+    curl_easy_setopt(curl, CURLOPT_URL, url); // Add full Url
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers); // Add the JWT
+
+    if (method == "POST") {
+        curl_easy_setopt(curl, CURLOPT_POST, 1L);
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, postData.c_str()); // Post Specified Data
+    } else if (method == "DELETE") {
+        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "DELETE"); // Not used in this
+    }
+    // "GET" is default, so no special setup needed.
+
+    // Call WriteCallback When Return Data Received
+    // Pass readBuffer as "userp" and Gather Return Data (As string type, in JSON format)
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback<StringT>);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &readBuffer);
+
+    // Hard limits so one slow response can't stall its thread; no signals since we are multi-threaded
+    long remainingMs = static_cast<long>(std::max<int64_t>(1, (deadlineNanos - monotonicNanos()) / 1'000'000));
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, remainingMs);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, std::min(remainingMs, kConnectTimeoutMs));
+    return curl;
+}
+
+// Performs the request and appends the response body to readBuffer.
+// StringT is std::string or std::pmr::string (arena-backed).
+// The request is abandoned at opts.deadlineNanos or when opts.cancel fires. For GETs with
+// opts.hedge set, a duplicate is sent once the endpoint's p95 latency has passed and the
+// first usable answer (not a transport error, 5xx or 429) wins.
+template <typename StringT>
+HttpResult httpRequestInto(
+        const std::string& method, // "Delete" (Not Used), "Get", "Post"
+        const char* url, // Full Url
+        std::string_view bearerToken, // Signed JWT
+        const std::string& postData, // JSON Body for Post
+        StringT& readBuffer, // Response Output
+        const RequestOptions& opts = {} // Deadline, cancellation, hedging
+) {
+    HttpResult result;
+
+    // Replay mode: serve the recorded response instead of going to the network
+    if (g_replayer) {
+        if (const EventReplayer::Record* r = g_replayer->nextHttpResponse(method, url)) {
+            readBuffer.append(r->payload);
+            result.httpStatus = r->httpStatus;
+        } else {
+            std::cerr << "[REPLAY] No recorded response left for " << method << " " << url << std::endl;
+            result.code = CURLE_COULDNT_CONNECT;
+        }
+        return result;
+    }
+    // Paper mode: orders never leave the process; market data still comes from the exchange
+    if (g_paper && PaperExchange::handles(url)) {
+        std::string body;
+        result.httpStatus = g_paper->handle(method, url, postData, body);
+        readBuffer.append(body);
+        return result;
+    }
 
-    if (curl) {
-        struct curl_slist* headers = nullptr;
+    int64_t startNanos = monotonicNanos();
+    int64_t deadline = opts.deadlineNanos ? opts.deadlineNanos : startNanos + kDefaultRequestTimeoutNanos;
+    Endpoint endpoint = endpointFromUrl(url);
+#ifdef COINBASEBOT_BEAST_HTTP
+    if (g_httpTransport == HttpTransport::Beast && BeastHttpsClient::handles(url)) {
+        // Pooled keep-alive TLS connection; GETs are not hedged on this transport
+        result = beastHttps().request(method, url, bearerToken, postData, readBuffer, deadline, opts.cancel);
+    } else
+#endif
+    {
+        bool canHedge = opts.hedge && opts.hedgeToken && method == "GET";
+        int64_t hedgeAt = canHedge ? startNanos + latencyWindow(endpoint).hedgeDelayNanos() : INT64_MAX;
+
+        // Attempt 0 writes straight into readBuffer; the hedge gets its own buffer
+        size_t initialSize = readBuffer.size();
+        StringT hedgeBuffer(readBuffer.get_allocator());
+        std::array<CURL*, 2> easy = {nullptr, nullptr};
+        std::array<curl_slist*, 2> headers = {nullptr, nullptr};
+
+        CURLM* multi = curl_multi_init();
+        headers[0] = makeRequestHeaders(bearerToken);
+        easy[0] = makeRequestHandle(method, url, headers[0], postData, readBuffer, deadline);
+        if (!multi || !easy[0]) {
+            result.code = CURLE_FAILED_INIT;
+        } else {
+            curl_multi_add_handle(multi, easy[0]);
+            int inFlight = 1;
+            CURL* winner = nullptr;
+
+            while (!winner) {
+                int running = 0;
+                curl_multi_perform(multi, &running);
+
+                // Take the first usable answer; a failed attempt (transport error, 5xx, 429) only
+                // ends the request if nothing else is in flight
+                int left = 0;
+                while (CURLMsg* msg = curl_multi_info_read(multi, &left)) {
+                    if (msg->msg != CURLMSG_DONE) {
+                        continue;
+                    }
+                    inFlight--;
+                    result.code = msg->data.result;
+                    long status = 0;
+                    curl_easy_getinfo(msg->easy_handle, CURLINFO_RESPONSE_CODE, &status);
+                    if ((result.code == CURLE_OK && usableHttpStatus(status)) || inFlight == 0) {
+                        winner = msg->easy_handle;
+                        break;
+                    }
+                }
+                if (winner) {
+                    break;
+                }
+
+                int64_t now = monotonicNanos();
+                if (opts.cancel && opts.cancel->isCancelled()) {
+                    result.cancelled = true;
+                    result.code = CURLE_ABORTED_BY_CALLBACK;
+                    break;
+                }
+                if (now >= deadline) {
+                    result.code = CURLE_OPERATION_TIMEDOUT;
+                    break;
+                }
+                if (now >= hedgeAt && !result.hedged) {
+                    std::string hedgeToken = opts.hedgeToken();
+                    headers[1] = makeRequestHeaders(hedgeToken);
+                    easy[1] = makeRequestHandle(method, url, headers[1], postData, hedgeBuffer, deadline);
+                    if (easy[1]) {
+                        curl_multi_add_handle(multi, easy[1]);
+                        inFlight++;
+                    }
+                    result.hedged = true;
+                    continue;
+                }
+
+                // Wake at least every 50ms to notice cancellation
+                int64_t wakeAt = result.hedged ? deadline : std::min(deadline, hedgeAt);
+                int timeoutMs = static_cast<int>(std::clamp<int64_t>((wakeAt - now) / 1'000'000, 1, 50));
+                curl_multi_poll(multi, nullptr, 0, timeoutMs, nullptr);
+            }
+
+            if (winner) {
+                curl_easy_getinfo(winner, CURLINFO_RESPONSE_CODE, &result.httpStatus);
+                if (winner == easy[1]) {
+                    result.hedgeWon = true;
+                    readBuffer.resize(initialSize);
+                    readBuffer.append(hedgeBuffer.data(), hedgeBuffer.size());
+                }
+            }
+        }
+        result.timedOut = (result.code == CURLE_OPERATION_TIMEDOUT);
+
+        // Wrap up (removing an unfinished handle cancels its transfer)
+        for (size_t i = 0; i < easy.size(); i++) {
+            if (easy[i]) {
+                curl_multi_remove_handle(multi, easy[i]);
+                curl_easy_cleanup(easy[i]);
+            }
+            curl_slist_free_all(headers[i]);
+        }
+        if (multi) {
+            curl_multi_cleanup(multi);
+        }
+    }
+
+    int64_t elapsed = monotonicNanos() - startNanos;
+    if (result.code != CURLE_OK) {
+        std::cerr << "[ERROR] " << method << " " << endpointName(endpoint) << " failed after "
+                  << elapsed / 1'000'000 << "ms: " << curl_easy_strerror(result.code)
+                  << (result.cancelled ? " (cancelled)" : "") << std::endl;
+    } else {
+        latencyWindow(endpoint).add(elapsed);
+        if (result.hedgeWon) {
+            std::cout << "[HTTP] Hedged " << endpointName(endpoint) << " request won after "
+                      << elapsed / 1'000'000 << "ms\n";
+        }
+    }
+    metrics().recordRequest(endpoint, result.code == CURLE_OK ? result.httpStatus : 0, elapsed);
+
+    if (g_recorder) {
+        g_recorder->recordHttp(method, url, postData, result.httpStatus, std::string_view(readBuffer.data(), readBuffer.size()));
+    }
+
+    return result;
+}
 
-        std::string authHeader = "Authorization: Bearer " + bearerToken;
-        headers = curl_slist_append(headers, authHeader.c_str()); // JWT as Bearer Token
-        headers = curl_slist_append(headers, "Content-Type: application/json"); // Specify JSON to Curl
+// One request of a batch
+struct HttpCall {
+    std::string method;
+    std::string url;
+    std::string bearerToken;
+    std::string postData;
+};
 
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str()); // Add full Url
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers); // Add the JWT
+// Sends every call at once on one multi handle (HTTP/2 multiplexed over a shared
+// connection where the server allows it), so N requests cost about one round trip.
+// responses[i] / the returned results[i] belong to calls[i].
+std::vector<HttpResult> httpRequestBatch(
+        const std::vector<HttpCall>& calls,
+        std::vector<std::string>& responses,
+        const RequestOptions& opts = {} // Deadline and cancellation for the whole batch
+) {
+    std::vector<HttpResult> results(calls.size());
+    responses.assign(calls.size(), std::string());
+
+    // Replay mode: recorded responses in call order
+    if (g_replayer) {
+        for (size_t i = 0; i < calls.size(); i++) {
+            if (const EventReplayer::Record* r = g_replayer->nextHttpResponse(calls[i].method, calls[i].url)) {
+                responses[i] = r->payload;
+                results[i].httpStatus = r->httpStatus;
+            } else {
+                results[i].code = CURLE_COULDNT_CONNECT;
+            }
+        }
+        return results;
+    }
+    if (g_paper) {
+        bool allPaper = std::all_of(calls.begin(), calls.end(),
+                                    [](const HttpCall& c) { return PaperExchange::handles(c.url); });
+        if (allPaper) {
+            for (size_t i = 0; i < calls.size(); i++) {
+                results[i].httpStatus = g_paper->handle(calls[i].method, calls[i].url, calls[i].postData, responses[i]);
+            }
+            return results;
+        }
+    }
+
+    int64_t startNanos = monotonicNanos();
+    int64_t deadline = opts.deadlineNanos ? opts.deadlineNanos : startNanos + kDefaultRequestTimeoutNanos;
+    std::vector<CURL*> easy(calls.size(), nullptr);
+    std::vector<curl_slist*> headers(calls.size(), nullptr);
+    std::vector<bool> done(calls.size(), false);
+
+    CURLM* multi = curl_multi_init();
+    if (!multi) {
+        for (HttpResult& r : results) {
+            r.code = CURLE_FAILED_INIT;
+        }
+        return results;
+    }
+    curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+
+    size_t inFlight = 0;
+    for (size_t i = 0; i < calls.size(); i++) {
+        headers[i] = makeRequestHeaders(calls[i].bearerToken);
+        easy[i] = makeRequestHandle(calls[i].method, calls[i].url.c_str(), headers[i], calls[i].postData, responses[i], deadline);
+        if (!easy[i]) {
+            results[i].code = CURLE_FAILED_INIT;
+            done[i] = true;
+            continue;
+        }
+        curl_easy_setopt(easy[i], CURLOPT_PRIVATE, reinterpret_cast<char*>(i));
+        curl_multi_add_handle(multi, easy[i]);
+        inFlight++;
+    }
+
+    while (inFlight > 0) {
+        int running = 0;
+        curl_multi_perform(multi, &running);
 
-        if (method == "POST") {
-            curl_easy_setopt(curl, CURLOPT_POST, 1L);
-            curl_easy_setopt(curl, CURLOPT_POSTFIELDS, postData.c_str()); // Post Specified Data
-        } else if (method == "DELETE") {
-            curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "DELETE"); // Not used in this
+        int left = 0;
+        while (CURLMsg* msg = curl_multi_info_read(multi, &left)) {
+            if (msg->msg != CURLMSG_DONE) {
+                continue;
+            }
+            char* priv = nullptr;
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &priv);
+            size_t i = reinterpret_cast<size_t>(priv);
+            results[i].code = msg->data.result;
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_RESPONSE_CODE, &results[i].httpStatus);
+            done[i] = true;
+            inFlight--;
+        }
+        if (inFlight == 0) {
+            break;
         }
-        // "GET" is default, so no special setup needed.
 
-        // Call WriteCallback When Return Data Received
-        // Pass readBuffer as "userp" and Gather Return Data (As string type, in JSON format)
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &readBuffer);
+        int64_t now = monotonicNanos();
+        bool cancelled = opts.cancel && opts.cancel->isCancelled();
+        if (cancelled || now >= deadline) {
+            for (size_t i = 0; i < calls.size(); i++) {
+                if (!done[i]) {
+                    results[i].cancelled = cancelled;
+                    results[i].code = cancelled ? CURLE_ABORTED_BY_CALLBACK : CURLE_OPERATION_TIMEDOUT;
+                    results[i].timedOut = !cancelled;
+                }
+            }
+            break;
+        }
+        int timeoutMs = static_cast<int>(std::clamp<int64_t>((deadline - now) / 1'000'000, 1, 50));
+        curl_multi_poll(multi, nullptr, 0, timeoutMs, nullptr);
+    }
 
-        // Execute
-        CURLcode res = curl_easy_perform(curl);
-        if (res != CURLE_OK) {
-            std::cerr << "[ERROR] curl_easy_perform() failed: "
-                      << curl_easy_strerror(res) << std::endl;
+    for (size_t i = 0; i < calls.size(); i++) {
+        if (easy[i]) {
+            curl_multi_remove_handle(multi, easy[i]);
+            curl_easy_cleanup(easy[i]);
         }
+        curl_slist_free_all(headers[i]);
+    }
+    curl_multi_cleanup(multi);
 
-        // Wrap up
-        curl_slist_free_all(headers);
-        curl_easy_cleanup(curl);
+    int64_t elapsed = monotonicNanos() - startNanos;
+    for (size_t i = 0; i < calls.size(); i++) {
+        Endpoint endpoint = endpointFromUrl(calls[i].url.c_str());
+        if (results[i].code != CURLE_OK) {
+            std::cerr << "[ERROR] " << calls[i].method << " " << endpointName(endpoint) << " (batch item " << i
+                      << ") failed: " << curl_easy_strerror(results[i].code) << std::endl;
+        }
+        metrics().recordRequest(endpoint, results[i].code == CURLE_OK ? results[i].httpStatus : 0, elapsed);
+        if (g_recorder) {
+            g_recorder->recordHttp(calls[i].method, calls[i].url, calls[i].postData, results[i].httpStatus, responses[i]);
+        }
     }
+    return results;
+}
+
+std::string httpRequest(
+        const std::string& method, // "Delete" (Not Used), "Get", "Post"
+        const std::string& url, // Full Url
+        const std::string& bearerToken, // Signed JWT
+        const std::string& postData = "" // JSON Body for Post
+) {
+    // Initializing our return output (String type, JSON format)
+    std::string readBuffer;
+    httpRequestInto(method, url.c_str(), bearerToken, postData, readBuffer);
 
     // All Returned Data, String type, JSON format
     return readBuffer;
@@ -135,25 +573,34 @@ double computeMovingAverage(const nlohmann::json& candleData, int numCandles)
     return sum / static_cast<double>(numCandles);
 }
 
+// Same as above over closes already extracted by getCandleCloses() (most recent first)
+double computeMovingAverage(const std::pmr::vector<double>& closes, int numCandles)
+{
+    if (closes.size() < static_cast<size_t>(numCandles)) {
+        return 0.0; // Not enough data
+    }
+
+    double sum = std::accumulate(closes.begin(), closes.begin() + numCandles, 0.0);
+    return sum / static_cast<double>(numCandles);
+}
+
 //------------------------------------------
 // 4) FETCH CANDLE DATA
 //------------------------------------------
-nlohmann::json getCandles(
+// Fetch candles for an explicit [startTime, endTime] window (epoch seconds)
+nlohmann::json getCandlesRange(
         const std::string& keyName, // Key ID
         const std::string& privateKeyPem, // Private Key
         const std::string& productId, // "BTC-USD"
         const std::string& granularity, // "ONE_MINUTE" or "FIVE_MINUTE"
-        int secondsToFetch // 300 for 5 minutes if you want ~5 candles
+        time_t startTime, // Window Start
+        time_t endTime // Window End
 )
 {
-    // Get current time
-    time_t now = time(nullptr);
-    time_t startTime = now - secondsToFetch;
-
     // Construct URL
     std::string path = "/api/v3/brokerage/market/products/" + productId +
                        "/candles?start=" + std::to_string(startTime) +
-                       "&end=" + std::to_string(now) +
+                       "&end=" + std::to_string(endTime) +
                        "&granularity=" + granularity;
 
     std::string method = "GET";
@@ -168,6 +615,7 @@ nlohmann::json getCandles(
     // Parse JSON
     nlohmann::json jsonResp;
     try {
+        ScopedTimer parseTimer(metrics().parseTime);
         jsonResp = nlohmann::json::parse(resp);
     } catch (...) {
         std::cerr << "[ERROR] JSON parse error for candle response." << std::endl;
@@ -181,25 +629,193 @@ nlohmann::json getCandles(
     return {};
 }
 
-//------------------------------------------
-// 5) PLACE LIMIT ORDER (MAKER)
-//------------------------------------------
-bool placeLimitOrder(
+nlohmann::json getCandles(
         const std::string& keyName, // Key ID
         const std::string& privateKeyPem, // Private Key
         const std::string& productId, // "BTC-USD"
-        const std::string& side,     // "BUY" or "SELL"
-        double limitPrice,           // Price to Put the Limit Order at
-        double quoteAmountUsd,       // How much USD to Use ("$5" Right Now)
-        const std::string& clientOrderId // Unique Order ID you create
+        const std::string& granularity, // "ONE_MINUTE" or "FIVE_MINUTE"
+        int secondsToFetch // 300 for 5 minutes if you want ~5 candles
 )
 {
-    // Endpoint
-    // Construct URL
-    std::string path = "/api/v3/brokerage/orders";
-    std::string method = "POST";
-    std::string fullUrl = "https://api.coinbase.com" + path;
+    // Get current exchange time
+    time_t now = exchangeClock().nowSeconds();
+    time_t startTime = now - secondsToFetch;
+
+    return getCandlesRange(keyName, privateKeyPem, productId, granularity, startTime, now);
+}
+
+// SAX handler that pulls "close" out of each candle without building a DOM.
+// Closes are written into an arena-backed vector, in the order Coinbase returns them.
+class CandleCloseHandler : public nlohmann::json_sax<nlohmann::json> {
+public:
+    explicit CandleCloseHandler(std::pmr::vector<double>& closes) : closes_(closes) {}
+
+    bool null() override { return true; }
+    bool boolean(bool) override { return true; }
+    bool number_integer(number_integer_t) override { return true; }
+    bool number_unsigned(number_unsigned_t) override { return true; }
+    bool number_float(number_float_t, const string_t&) override { return true; }
+    bool binary(binary_t&) override { return true; }
+
+    bool string(string_t& val) override {
+        if (inCandles_ && depth_ == 3 && isCloseKey_) {
+            double close = 0.0;
+            std::from_chars(val.data(), val.data() + val.size(), close);
+            closes_.push_back(close);
+        }
+        isCloseKey_ = false;
+        return true;
+    }
+
+    bool key(string_t& val) override {
+        if (depth_ == 1) {
+            candlesKey_ = (val == "candles");
+        }
+        isCloseKey_ = (val == "close");
+        return true;
+    }
+
+    bool start_object(std::size_t) override { ++depth_; return true; }
+    bool end_object() override { --depth_; return true; }
+
+    bool start_array(std::size_t) override {
+        ++depth_;
+        if (depth_ == 2 && candlesKey_) {
+            inCandles_ = true;
+        }
+        return true;
+    }
+
+    bool end_array() override {
+        if (depth_ == 2) {
+            inCandles_ = false;
+        }
+        --depth_;
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception&) override {
+        return false;
+    }
+
+private:
+    std::pmr::vector<double>& closes_;
+    int depth_ = 0;
+    bool candlesKey_ = false;
+    bool inCandles_ = false;
+    bool isCloseKey_ = false;
+};
+
+// Arena-backed variant of getCandles() used by the main loop.
+// URL, JWT uri, auth header and response body all live in mr, and only the close prices are kept.
+std::pmr::vector<double> getCandleCloses(
+        const std::string& keyName, // Key ID
+        const std::string& privateKeyPem, // Private Key
+        std::string_view productId, // "BTC-USD"
+        std::string_view granularity, // "ONE_MINUTE" or "FIVE_MINUTE"
+        int secondsToFetch, // 300 for 5 minutes if you want ~5 candles
+        std::pmr::memory_resource* mr, // Per-tick arena
+        RequestOptions opts = {} // Deadline, cancellation, hedging
+)
+{
+    // Get current exchange time
+    time_t now = exchangeClock().nowSeconds();
+    time_t startTime = now - secondsToFetch;
+
+    char startBuf[24];
+    char endBuf[24];
+    auto startEnd = std::to_chars(startBuf, startBuf + sizeof(startBuf), static_cast<long long>(startTime)).ptr;
+    auto endEnd = std::to_chars(endBuf, endBuf + sizeof(endBuf), static_cast<long long>(now)).ptr;
+
+    // Construct URL ("https://api.coinbase.com" + path) in one buffer; path is the suffix
+    constexpr std::string_view host = "https://api.coinbase.com";
+    std::pmr::string fullUrl(mr);
+    fullUrl.reserve(160);
+    fullUrl.append(host)
+           .append("/api/v3/brokerage/market/products/").append(productId)
+           .append("/candles?start=").append(startBuf, startEnd)
+           .append("&end=").append(endBuf, endEnd)
+           .append("&granularity=").append(granularity);
+    std::string_view path = std::string_view(fullUrl).substr(host.size());
+
+    // Create a signed JWT used as a Bearer token for Coinbase Advanced Trade API authentication
+    std::string jwt = create_jwt(keyName, privateKeyPem, "GET", path, mr);
+    if (opts.hedge) {
+        // The duplicate is signed only if it is actually sent
+        opts.hedgeToken = [&]() { return create_jwt(keyName, privateKeyPem, "GET", path, mr); };
+    }
+
+    std::pmr::string resp(mr);
+    resp.reserve(16 * 1024);
+    HttpResult result = httpRequestInto("GET", fullUrl.c_str(), jwt, std::string(), resp, opts);
+    if (result.code != CURLE_OK) {
+        return std::pmr::vector<double>(mr);
+    }
+
+    // Parse JSON straight into the closes array
+    std::pmr::vector<double> closes(mr);
+    closes.reserve(350); // Coinbase returns at most 350 candles per request
+    CandleCloseHandler handler(closes);
+    ScopedTimer parseTimer(metrics().parseTime);
+    if (!nlohmann::json::sax_parse(resp.begin(), resp.end(), &handler)) {
+        std::cerr << "[ERROR] JSON parse error for candle response." << std::endl;
+        closes.clear();
+    }
+
+    return closes;
+}
+
+//------------------------------------------
+// 4b) EXCHANGE CLOCK SYNC
+//------------------------------------------
+// Times one request to the public server-time endpoint and feeds the sample to exchangeClock().
+// TIME_URL can point at a local stand-in returning the same {"epochMillis": "..."} shape.
+bool syncExchangeClock()
+{
+    const char* timeUrl = std::getenv("TIME_URL");
+    std::string url = timeUrl ? timeUrl : "https://api.coinbase.com/api/v3/brokerage/time";
+
+    int64_t sendWall = ExchangeClock::wallNanos();
+    int64_t sendMono = monotonicNanos();
+    std::string resp = httpRequest("GET", url, "");
+    int64_t rtt = monotonicNanos() - sendMono;
+
+    try {
+        auto j = nlohmann::json::parse(resp);
+        int64_t serverMillis = std::stoll(j.at("epochMillis").get<std::string>());
+        exchangeClock().addSample(sendWall, rtt, serverMillis * 1'000'000);
+    } catch (...) {
+        std::cerr << "[WARN] Clock sync failed, keeping previous offset.\n";
+        return false;
+    }
+
+    metrics().clockOffsetNanos.set(exchangeClock().offsetNanos());
+    metrics().clockRttNanos.set(exchangeClock().rttNanos());
+    return true;
+}
+
+//------------------------------------------
+// 5) PLACE LIMIT ORDER (MAKER)
+//------------------------------------------
+// Price as string (Type Required by Coinbase, to Two Decimal Places)
+// Manually Rounding
+std::string formatUsdPrice(double price)
+{
+    double rounded = std::floor(price * 100.0 + 0.5) / 100.0;
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(2) << rounded;
+    return oss.str();
+}
 
+// Body of a post-only GTC limit order
+std::string limitOrderBody(
+        const std::string& productId,
+        const std::string& side,
+        double limitPrice,
+        double quoteAmountUsd,
+        const std::string& clientOrderId
+)
+{
     // JSON body
     nlohmann::json orderBody;
     orderBody["client_order_id"] = clientOrderId;
@@ -208,13 +824,7 @@ bool placeLimitOrder(
 
     // We want a limit order with GTC (Good Til Canceled)
     nlohmann::json limitGtc;
-    // Price as string (Type Required by Coinbase, to Two Decimal Places)
-    // Manually Rounding
-    double limitPriceRounded = std::floor(limitPrice * 100.0 + 0.5) / 100.0;
-    std::ostringstream oss;
-    oss << std::fixed << std::setprecision(2) << limitPriceRounded;
-    std::string limitPriceStr = oss.str();
-    limitGtc["limit_price"] = limitPriceStr;
+    limitGtc["limit_price"] = formatUsdPrice(limitPrice);
 
     // For a limit order, we can do "base_size" or "quote_size".
     // We'll do quote_size for both sides
@@ -228,155 +838,2037 @@ bool placeLimitOrder(
     nlohmann::json config;
     config["limit_limit_gtc"] = limitGtc;
     orderBody["order_configuration"] = config;
+    return orderBody.dump();
+}
+
+constexpr int kOrderSendAttempts = 3;
+constexpr int64_t kOrderAttemptTimeoutNanos = 3'000'000'000LL;
+
+bool placeLimitOrder(
+        const std::string& keyName, // Key ID
+        const std::string& privateKeyPem, // Private Key
+        const std::string& productId, // "BTC-USD"
+        const std::string& side,     // "BUY" or "SELL"
+        double limitPrice,           // Price to Put the Limit Order at
+        double quoteAmountUsd,       // How much USD to Use ("$5" Right Now)
+        const std::string& clientOrderId, // Unique Order ID you create
+        std::string* exchangeOrderId = nullptr // Receives Coinbase's order_id on success
+)
+{
+    // Endpoint
+    // Construct URL
+    std::string path = "/api/v3/brokerage/orders";
+    std::string method = "POST";
+    std::string fullUrl = "https://api.coinbase.com" + path;
 
     // Dump JSON
     // Convert JSON Object to String for HTTP POST Body
-    std::string postData = orderBody.dump();
+    std::string postData = limitOrderBody(productId, side, limitPrice, quoteAmountUsd, clientOrderId);
 
-    // Create and Sign JWT (Required Bearer Token)
-    std::string jwt = create_jwt(keyName, privateKeyPem, method, path);
 
     // Make request
-    std::string response = httpRequest(method, fullUrl, jwt, postData);
-    std::cout << "[placeLimitOrder] side=" << side << " response: " << response << std::endl;
+    // On a transport failure or 5xx the identical body (same client_order_id) is resent right away.
+    // Coinbase returns the existing order for a duplicate client_order_id, so a retry can
+    // never open a second order, and we skip a slow "did it go through?" query.
+    std::string response;
+    for (int attempt = 1; attempt <= kOrderSendAttempts; attempt++) {
+        // Create and Sign JWT (Required Bearer Token); fresh nonce per attempt
+        std::string jwt = create_jwt(keyName, privateKeyPem, method, path);
+
+        RequestOptions opts;
+        opts.deadlineNanos = monotonicNanos() + kOrderAttemptTimeoutNanos;
+        response.clear();
+        HttpResult result = httpRequestInto(method, fullUrl.c_str(), jwt, postData, response, opts);
+        if (result.code == CURLE_OK && result.httpStatus < 500) {
+            break;
+        }
+        if (attempt < kOrderSendAttempts) {
+            std::cerr << "[WARN] Order " << clientOrderId << " attempt " << attempt
+                      << " failed, resending with the same client_order_id\n";
+            metrics().orderRetries.inc();
+        }
+    }
+    std::cout << "[placeLimitOrder] side=" << side << " id=" << clientOrderId << " response: " << response << std::endl;
 
     // Basic check
     try {
+        ScopedTimer parseTimer(metrics().parseTime);
         auto jresp = nlohmann::json::parse(response);
         if (jresp.contains("success") && jresp["success"].get<bool>() == true) {
             std::cout << "[INFO] Limit order placed successfully.\n";
+            metrics().ordersPlaced.inc();
+            if (exchangeOrderId && jresp.contains("success_response")) {
+                *exchangeOrderId = jresp["success_response"].value("order_id", "");
+            }
             return true;
         }
     } catch (...) {
         std::cerr << "[ERROR] placeLimitOrder parse error.\n";
     }
 
+    metrics().ordersRejectedExchange.inc();
     return false;
 }
 
 //------------------------------------------
-// MAIN BOT
+// 5a) ORDER EDIT (REPRICE IN PLACE)
 //------------------------------------------
-int main()
+// Amends price and size of a resting GTC limit order in one signed request, instead of
+// cancel + place (two round trips, two JWTs, and a window with no order on the book).
+// Size is the new total base size and must stay above what has already filled.
+// Not retried: a lost amend is simply re-decided on the next snapshot.
+bool editLimitOrder(
+        const std::string& keyName, // Key ID
+        const std::string& privateKeyPem, // Private Key
+        const std::string& exchangeOrderId, // Coinbase order_id
+        double newLimitPrice,
+        double newBaseSize
+)
 {
-    // Your Key ID and Private Key
-    std::string keyName       = std::getenv("KEY_NAME");
-    std::string privateKeyPem = std::getenv("PRIVATE_KEY_PEM");
+    std::string path = "/api/v3/brokerage/orders/edit";
+    std::string method = "POST";
+    std::string fullUrl = "https://api.coinbase.com" + path;
 
-    // Re-format Private Key
-    // Replace \n with real line breaks
-    size_t pos = 0;
-    while ((pos = privateKeyPem.find("\\n", pos)) != std::string::npos)
-        privateKeyPem.replace(pos, 2, "\n");
+    std::ostringstream size;
+    size << std::fixed << std::setprecision(8) << newBaseSize;
 
-    // What are you trading
-    std::string productId = "BTC-USD";
+    nlohmann::json editBody;
+    editBody["order_id"] = exchangeOrderId;
+    editBody["price"] = formatUsdPrice(newLimitPrice);
+    editBody["size"] = size.str();
 
-    // For storing the last known state of the short vs long MA
-    bool shortWasAbove = false;
-    bool shortWasBelow = false;
-    bool havePosition = false;  // Are we currently in a long position?
+    std::string jwt = create_jwt(keyName, privateKeyPem, method, path);
 
-    // Track the fill price of last buy
-    double lastBuyPrice = 0.0;
+    RequestOptions opts;
+    opts.deadlineNanos = monotonicNanos() + kOrderAttemptTimeoutNanos;
+    std::string response;
+    httpRequestInto(method, fullUrl.c_str(), jwt, editBody.dump(), response, opts);
+    std::cout << "[editLimitOrder] id=" << exchangeOrderId << " price=" << editBody["price"].get<std::string>()
+              << " response: " << response << std::endl;
 
-    // We'll run an infinite loop, checking MAs every ~30 seconds
-    while (true)
-    {
-        try {
-            // Get short-term MA (1-minute candles)
-            // Need at least 5 minutes of 1-minute data. We get ~10 minutes to be safe:
-            auto oneMinCandles = getCandles(keyName, privateKeyPem, productId, "ONE_MINUTE", 600 /* 10 min in seconds*/);
-            double shortMA = computeMovingAverage(oneMinCandles, 5);
-
-            // Get long-term MA (5-minute candles)
-            // Need at least 25 minutes if we wanted 5 periods of 5-minute. We get ~30 minutes to be safe:
-            auto fiveMinCandles = getCandles(keyName, privateKeyPem, productId, "FIVE_MINUTE", 1800 /* 30 min in seconds*/);
-            double longMA = computeMovingAverage(fiveMinCandles, 5);
-
-            // Error Check
-            if (shortMA <= 0.0 || longMA <= 0.0) {
-                std::cerr << "[WARN] Could not compute MAs. shortMA=" << shortMA << ", longMA=" << longMA << "\n";
-                std::this_thread::sleep_for(std::chrono::seconds(30));
-                continue;
-            }
+    try {
+        ScopedTimer parseTimer(metrics().parseTime);
+        auto jresp = nlohmann::json::parse(response);
+        if (jresp.value("success", false)) {
+            metrics().ordersAmended.inc();
+            return true;
+        }
+    } catch (...) {
+        std::cerr << "[ERROR] editLimitOrder parse error.\n";
+    }
+
+    metrics().amendsRejected.inc();
+    return false;
+}
+
+//------------------------------------------
+// 5b) ORDER STATUS (POLLING)
+//------------------------------------------
+struct OrderStatus {
+    bool ok = false;            // Request and parse succeeded
+    std::string clientOrderId;
+    std::string status;         // OPEN, FILLED, CANCELLED, EXPIRED, FAILED, PENDING, ...
+    double filledBase = 0.0;    // Cumulative "filled_size"
+    double filledQuote = 0.0;   // Cumulative "filled_value"
+};
+
+OrderStatus getOrderStatus(
+        const std::string& keyName, // Key ID
+        const std::string& privateKeyPem, // Private Key
+        const std::string& exchangeOrderId // Coinbase order_id
+)
+{
+    std::string path = "/api/v3/brokerage/orders/historical/" + exchangeOrderId;
+    std::string method = "GET";
+    std::string fullUrl = "https://api.coinbase.com" + path;
+
+    std::string jwt = create_jwt(keyName, privateKeyPem, method, path);
+    std::string response = httpRequest(method, fullUrl, jwt);
+
+    OrderStatus st;
+    try {
+        ScopedTimer parseTimer(metrics().parseTime);
+        auto jresp = nlohmann::json::parse(response);
+        const auto& order = jresp.at("order");
+        st.clientOrderId = order.value("client_order_id", "");
+        st.status = order.value("status", "");
+        st.filledBase = std::stod(order.value("filled_size", "0"));
+        st.filledQuote = std::stod(order.value("filled_value", "0"));
+        st.ok = true;
+    } catch (...) {
+        std::cerr << "[ERROR] getOrderStatus parse error for " << exchangeOrderId << ".\n";
+    }
+    return st;
+}
+
+//------------------------------------------
+// 5c) BATCH SUBMIT AND BATCH CANCEL
+//------------------------------------------
+// For multi-product rebalances and emergency flattening.
+// Advanced Trade has no batch create endpoint, so the orders are sent concurrently in one
+// multiplexed round trip, each with its own JWT. Items that fail in transport or with a 5xx are
+// resent with the same client_order_id, which makes the retry idempotent.
+// Cancels use the real batch endpoint: up to kMaxCancelsPerRequest order IDs per signed request.
+// Every POST, retries included, takes a token from the order key's bucket first.
+struct BatchOrder {
+    std::string productId;
+    std::string side;           // "BUY" or "SELL"
+    double limitPrice = 0.0;
+    double quoteUsd = 0.0;
+    std::string clientOrderId;
+};
+
+struct BatchItemResult {
+    bool ok = false;
+    std::string orderId;        // Exchange order_id (placed or cancelled)
+    std::string error;          // Failure reason reported by the exchange, or transport error
+};
 
-            std::cout << "[INFO] shortMA=" << shortMA << ", longMA=" << longMA << std::endl;
-
-            // Check Crossovers
-            bool shortAbove = (shortMA > longMA);
-            bool shortBelow = (shortMA < longMA);
-
-            // Short MA Below and Stayed Below Long MA
-            if (shortBelow && shortWasAbove == false && shortWasBelow == true) {
-
-            }
-
-            // Short MA Above and Was Below Long MA -> BUY (And Wasn't Already in a Position)
-            if (shortWasBelow && shortAbove && !havePosition) {
-                // Place buy limit order with quote_size = 5 USD, limit price ~ slightly below shortMA
-
-                double limitPrice = shortMA * 0.999; // Multiply by 0.999 to Help Ensure a Maker Order (post_only ensures this)
-                double fixedQuoteUsd = 5.0;
-
-                bool ok = placeLimitOrder(
-                        keyName,
-                        privateKeyPem,
-                        productId,
-                        "BUY",
-                        limitPrice,
-                        fixedQuoteUsd,
-                        "bot-buy-order"
-                );
-                if (ok) {
-                    havePosition = true;
-                    lastBuyPrice = shortMA;
-                    std::cout << "[STRATEGY] Placed BUY order at limit=" << limitPrice << "\n";
-                }
-            }
-
-            // If we Have a Position and Short MA < Long MA -> SELL
-            if (havePosition && shortMA < longMA) {
-                /*
-                 * Change coefficient of 'lastBuyPrice' to determine amount profit you want before triggering a sell
-                 * This program assumes you are only accounting for the net fees on the trade made.
-                 * Note:
-                 * Coefficient >= 1
-                 * Higher the coefficient higher the profits however,
-                 * your position may take longer to sell depending on the market.
-                 */
-
-                double minSellPrice = lastBuyPrice * 1.013; // Multiply by 1.013 to cover fees
-                if (shortMA >= minSellPrice) {
-                    // place SELL
-                    double limitPrice = shortMA * 1.001; // Multiply by 1.001 to Help Ensure a Maker Order (post_only ensures this)
-                    double quoteUsd   = 5.0;
-
-                    bool ok = placeLimitOrder(
-                            keyName, privateKeyPem,
-                            productId, "SELL",
-                            limitPrice, quoteUsd,
-                            "bot-sell-order"
-                    );
-                    if (ok) {
-                        havePosition = false;
-                        std::cout << "[STRATEGY] Placed SELL order at limit=" << limitPrice << "\n";
+constexpr size_t kMaxCancelsPerRequest = 100;
+
+std::vector<BatchItemResult> placeLimitOrders(
+        ApiCredential& key, // Order key; its bucket is the order rate limit
+        const std::vector<BatchOrder>& orders
+)
+{
+    std::string path = "/api/v3/brokerage/orders";
+    std::string method = "POST";
+    std::string fullUrl = "https://api.coinbase.com" + path;
+
+    std::vector<BatchItemResult> results(orders.size());
+    std::vector<HttpCall> calls;
+    std::vector<size_t> pending(orders.size());
+    std::iota(pending.begin(), pending.end(), 0);
+
+    for (int attempt = 1; attempt <= kOrderSendAttempts && !pending.empty(); attempt++) {
+        calls.clear();
+        for (size_t i : pending) {
+            const BatchOrder& o = orders[i];
+            key.limiter.acquire();
+            calls.push_back({method, fullUrl, create_jwt(key.keyName, key.privateKeyPem, method, path),
+                             limitOrderBody(o.productId, o.side, o.limitPrice, o.quoteUsd, o.clientOrderId)});
+        }
+
+        RequestOptions opts;
+        opts.deadlineNanos = monotonicNanos() + kOrderAttemptTimeoutNanos;
+        std::vector<std::string> responses;
+        std::vector<HttpResult> http = httpRequestBatch(calls, responses, opts);
+
+        std::vector<size_t> retry;
+        for (size_t k = 0; k < pending.size(); k++) {
+            size_t i = pending[k];
+            if (http[k].code != CURLE_OK || http[k].httpStatus >= 500) {
+                results[i].error = http[k].code != CURLE_OK ? curl_easy_strerror(http[k].code) : "HTTP 5xx";
+                retry.push_back(i);
+                continue;
+            }
+            try {
+                auto jresp = nlohmann::json::parse(responses[k]);
+                results[i].ok = jresp.value("success", false);
+                if (results[i].ok && jresp.contains("success_response")) {
+                    results[i].orderId = jresp["success_response"].value("order_id", "");
+                } else if (jresp.contains("error_response")) {
+                    results[i].error = jresp["error_response"].value("error", "UNKNOWN");
+                }
+            } catch (...) {
+                results[i].error = "parse error";
+            }
+            if (results[i].ok) {
+                metrics().ordersPlaced.inc();
+            } else {
+                metrics().ordersRejectedExchange.inc();
+            }
+        }
+        if (!retry.empty() && attempt < kOrderSendAttempts) {
+            std::cerr << "[WARN] " << retry.size() << " batch orders failed, resending with the same client_order_id\n";
+            metrics().orderRetries.inc(retry.size());
+        }
+        pending.swap(retry);
+    }
+    metrics().ordersRejectedExchange.inc(pending.size()); // Gave up after kOrderSendAttempts
+
+    size_t placed = std::count_if(results.begin(), results.end(), [](const BatchItemResult& r) { return r.ok; });
+    std::cout << "[placeLimitOrders] " << placed << "/" << orders.size() << " orders placed\n";
+    return results;
+}
+
+std::vector<BatchItemResult> cancelOrders(
+        ApiCredential& key, // Order key; its bucket is the order rate limit
+        const std::vector<std::string>& exchangeOrderIds
+)
+{
+    std::string path = "/api/v3/brokerage/orders/batch_cancel";
+    std::string method = "POST";
+    std::string fullUrl = "https://api.coinbase.com" + path;
+
+    std::vector<BatchItemResult> results(exchangeOrderIds.size());
+    for (size_t begin = 0; begin < exchangeOrderIds.size(); begin += kMaxCancelsPerRequest) {
+        size_t end = std::min(exchangeOrderIds.size(), begin + kMaxCancelsPerRequest);
+
+        nlohmann::json body;
+        body["order_ids"] = std::vector<std::string>(exchangeOrderIds.begin() + begin, exchangeOrderIds.begin() + end);
+
+        key.limiter.acquire();
+        std::string jwt = create_jwt(key.keyName, key.privateKeyPem, method, path);
+        RequestOptions opts;
+        opts.deadlineNanos = monotonicNanos() + kOrderAttemptTimeoutNanos;
+        std::string response;
+        httpRequestInto(method, fullUrl.c_str(), jwt, body.dump(), response, opts);
+
+        // Results are matched back by order_id; anything not mentioned stays failed
+        for (size_t i = begin; i < end; i++) {
+            results[i].orderId = exchangeOrderIds[i];
+            results[i].error = "no result";
+        }
+        try {
+            auto jresp = nlohmann::json::parse(response);
+            for (const auto& item : jresp.at("results")) {
+                std::string id = item.value("order_id", "");
+                for (size_t i = begin; i < end; i++) {
+                    if (exchangeOrderIds[i] == id) {
+                        results[i].ok = item.value("success", false);
+                        results[i].error = results[i].ok ? "" : item.value("failure_reason", "UNKNOWN");
+                        break;
                     }
+                }
+            }
+        } catch (...) {
+            std::cerr << "[ERROR] cancelOrders parse error: " << response << "\n";
+        }
+    }
+
+    size_t cancelled = 0;
+    for (const BatchItemResult& r : results) {
+        if (r.ok) {
+            cancelled++;
+            metrics().ordersCancelled.inc();
+        } else {
+            std::cerr << "[WARN] Cancel " << r.orderId << " failed: " << r.error << "\n";
+        }
+    }
+    std::cout << "[cancelOrders] " << cancelled << "/" << exchangeOrderIds.size() << " orders cancelled\n";
+    return results;
+}
+
+#ifdef COINBASEBOT_ASYNC_CLIENT
+//------------------------------------------
+// 5d) COROUTINE CLIENT (ASYNC_CLIENT=ON)
+//------------------------------------------
+// co_await versions of the REST calls above, for an EventLoop (async_client.h). They send
+// the same requests and JWTs and go through the same replay, paper and metrics paths as
+// the blocking versions, so they can be mixed freely. GETs are not hedged here.
+// Coroutine parameters are taken by value: a suspended call must not point into its caller
+// (the loop, the key pool and API keys live for the whole process).
+// Order calls take a token from the key's bucket first, as the order gateway does; waiting
+// for a token is a timer on the loop, never a blocking sleep.
+
+// Awaitable limiter.acquire()
+Task<void> acquireTokenAsync(EventLoop& loop, RateLimiter& limiter)
+{
+    std::chrono::nanoseconds wait{};
+    while (!limiter.tryAcquire(wait)) {
+        co_await loop.sleepFor(wait.count());
+    }
+}
+
+// Awaitable keys.acquireMarketData()
+Task<ApiCredential*> acquireMarketDataAsync(EventLoop& loop, KeyPool& keys)
+{
+    std::chrono::nanoseconds wait{};
+    for (;;) {
+        if (ApiCredential* key = keys.tryAcquireMarketData(wait)) {
+            co_return key;
+        }
+        co_await loop.sleepFor(wait.count());
+    }
+}
+
+struct HttpResponse {
+    HttpResult result;
+    std::string body;
+};
+
+Task<HttpResponse> httpRequestAsync(
+        EventLoop& loop,
+        std::string method, // "GET", "POST", "DELETE"
+        std::string url, // Full Url
+        std::string bearerToken, // Signed JWT
+        std::string postData = "", // JSON Body for Post
+        RequestOptions opts = {} // Deadline and cancellation
+) {
+    HttpResponse r;
+    if (g_replayer) {
+        if (const EventReplayer::Record* rec = g_replayer->nextHttpResponse(method, url)) {
+            r.body = rec->payload;
+            r.result.httpStatus = rec->httpStatus;
+        } else {
+            std::cerr << "[REPLAY] No recorded response left for " << method << " " << url << std::endl;
+            r.result.code = CURLE_COULDNT_CONNECT;
+        }
+        co_return r;
+    }
+    if (g_paper && PaperExchange::handles(url)) {
+        r.result.httpStatus = g_paper->handle(method, url, postData, r.body);
+        co_return r;
+    }
+
+    int64_t startNanos = monotonicNanos();
+    int64_t deadline = opts.deadlineNanos ? opts.deadlineNanos : startNanos + kDefaultRequestTimeoutNanos;
+    Endpoint endpoint = endpointFromUrl(url.c_str());
+
+    // r lives in the coroutine frame, so curl can write into r.body while we are suspended
+    curl_slist* headers = makeRequestHeaders(bearerToken);
+    CURL* easy = makeRequestHandle(method, url.c_str(), headers, postData, r.body, deadline);
+    if (!easy) {
+        r.result.code = CURLE_FAILED_INIT;
+    } else {
+        r.result.code = co_await loop.perform(easy, opts.cancel);
+        curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &r.result.httpStatus);
+        curl_easy_cleanup(easy);
+    }
+    curl_slist_free_all(headers);
+    r.result.cancelled = (r.result.code == CURLE_ABORTED_BY_CALLBACK);
+    r.result.timedOut = (r.result.code == CURLE_OPERATION_TIMEDOUT);
+
+    int64_t elapsed = monotonicNanos() - startNanos;
+    if (r.result.code != CURLE_OK) {
+        std::cerr << "[ERROR] " << method << " " << endpointName(endpoint) << " failed after "
+                  << elapsed / 1'000'000 << "ms: " << curl_easy_strerror(r.result.code)
+                  << (r.result.cancelled ? " (cancelled)" : "") << std::endl;
+    } else {
+        latencyWindow(endpoint).add(elapsed);
+    }
+    metrics().recordRequest(endpoint, r.result.code == CURLE_OK ? r.result.httpStatus : 0, elapsed);
+    if (g_recorder) {
+        g_recorder->recordHttp(method, url, postData, r.result.httpStatus, r.body);
+    }
+    co_return r;
+}
+
+// getCandles(): the candle array for the last secondsToFetch, most recent first
+Task<nlohmann::json> getCandlesAsync(
+        EventLoop& loop,
+        std::string keyName, // Key ID
+        std::string privateKeyPem, // Private Key
+        std::string productId, // "BTC-USD"
+        std::string granularity, // "ONE_MINUTE" or "FIVE_MINUTE"
+        int secondsToFetch,
+        RequestOptions opts = {}
+) {
+    time_t now = exchangeClock().nowSeconds();
+    std::string path = "/api/v3/brokerage/market/products/" + productId +
+                       "/candles?start=" + std::to_string(now - secondsToFetch) +
+                       "&end=" + std::to_string(now) +
+                       "&granularity=" + granularity;
+    std::string jwt = create_jwt(keyName, privateKeyPem, "GET", path);
+    HttpResponse r = co_await httpRequestAsync(loop, "GET", "https://api.coinbase.com" + path, jwt, "", opts);
+
+    nlohmann::json jsonResp = nlohmann::json::parse(r.body, nullptr, false);
+    if (jsonResp.is_discarded()) {
+        std::cerr << "[ERROR] JSON parse error for candle response." << std::endl;
+    } else if (jsonResp.contains("candles")) {
+        co_return jsonResp["candles"];
+    }
+    co_return nlohmann::json{};
+}
+
+// placeLimitOrder(): post-only GTC limit order, resent with the same client_order_id on a
+// transport failure or 5xx
+Task<BatchItemResult> placeLimitOrderAsync(
+        EventLoop& loop,
+        ApiCredential& key, // Order key; its bucket is the order rate limit
+        std::string productId, // "BTC-USD"
+        std::string side, // "BUY" or "SELL"
+        double limitPrice,
+        double quoteAmountUsd,
+        std::string clientOrderId
+) {
+    const std::string path = "/api/v3/brokerage/orders";
+    std::string postData = limitOrderBody(productId, side, limitPrice, quoteAmountUsd, clientOrderId);
+
+    HttpResponse r;
+    for (int attempt = 1; attempt <= kOrderSendAttempts; attempt++) {
+        co_await acquireTokenAsync(loop, key.limiter); // One token per send, retries included
+        RequestOptions opts;
+        opts.deadlineNanos = monotonicNanos() + kOrderAttemptTimeoutNanos;
+        r = co_await httpRequestAsync(loop, "POST", "https://api.coinbase.com" + path,
+                                      create_jwt(key.keyName, key.privateKeyPem, "POST", path), postData, opts);
+        if (r.result.code == CURLE_OK && r.result.httpStatus < 500) {
+            break;
+        }
+        if (attempt < kOrderSendAttempts) {
+            std::cerr << "[WARN] Order " << clientOrderId << " attempt " << attempt
+                      << " failed, resending with the same client_order_id\n";
+            metrics().orderRetries.inc();
+        }
+    }
+
+    BatchItemResult item;
+    nlohmann::json jresp = nlohmann::json::parse(r.body, nullptr, false);
+    if (!jresp.is_discarded() && jresp.value("success", false)) {
+        item.ok = true;
+        if (jresp.contains("success_response")) {
+            item.orderId = jresp["success_response"].value("order_id", "");
+        }
+        metrics().ordersPlaced.inc();
+    } else {
+        if (r.result.code != CURLE_OK) {
+            item.error = curl_easy_strerror(r.result.code);
+        } else if (jresp.is_discarded()) {
+            item.error = "parse error";
+        } else if (jresp.contains("error_response")) {
+            item.error = jresp["error_response"].value("error", "UNKNOWN");
+        } else {
+            item.error = "HTTP " + std::to_string(r.result.httpStatus);
+        }
+        metrics().ordersRejectedExchange.inc();
+    }
+    std::cout << "[placeLimitOrderAsync] side=" << side << " id=" << clientOrderId
+              << (item.ok ? " placed " + item.orderId : " failed: " + item.error) << std::endl;
+    co_return item;
+}
+
+// getOrderStatus()
+Task<OrderStatus> getOrderStatusAsync(
+        EventLoop& loop,
+        ApiCredential& key, // Order key; its bucket is the order rate limit
+        std::string exchangeOrderId // Coinbase order_id
+) {
+    std::string path = "/api/v3/brokerage/orders/historical/" + exchangeOrderId;
+    co_await acquireTokenAsync(loop, key.limiter);
+    HttpResponse r = co_await httpRequestAsync(loop, "GET", "https://api.coinbase.com" + path,
+                                               create_jwt(key.keyName, key.privateKeyPem, "GET", path));
+    OrderStatus st;
+    try {
+        ScopedTimer parseTimer(metrics().parseTime);
+        auto jresp = nlohmann::json::parse(r.body);
+        const auto& order = jresp.at("order");
+        st.clientOrderId = order.value("client_order_id", "");
+        st.status = order.value("status", "");
+        st.filledBase = std::stod(order.value("filled_size", "0"));
+        st.filledQuote = std::stod(order.value("filled_value", "0"));
+        st.ok = true;
+    } catch (...) {
+        std::cerr << "[ERROR] getOrderStatus parse error for " << exchangeOrderId << ".\n";
+    }
+    co_return st;
+}
+
+// Polls the order every pollNanos until it is filled, cancelled, expired or failed, or
+// until deadlineNanos (then returns the last status seen). Other coroutines on the loop
+// keep running while it waits.
+Task<OrderStatus> awaitOrderDoneAsync(
+        EventLoop& loop,
+        ApiCredential& key, // Order key
+        std::string exchangeOrderId, // Coinbase order_id
+        int64_t pollNanos,
+        int64_t deadlineNanos
+) {
+    OrderStatus st;
+    for (;;) {
+        st = co_await getOrderStatusAsync(loop, key, exchangeOrderId);
+        bool terminal = st.status == "FILLED" || st.status == "CANCELLED" || st.status == "EXPIRED"
+                        || st.status == "FAILED";
+        if (terminal || monotonicNanos() + pollNanos >= deadlineNanos) {
+            co_return st;
+        }
+        co_await loop.sleepFor(pollNanos);
+    }
+}
+#endif // COINBASEBOT_ASYNC_CLIENT
+
+// Sleep between iterations. Replay as fast as possible skips it; original-speed replay
+// is paced by the recorded response times instead.
+void loopSleep(std::chrono::seconds duration, const std::atomic<bool>& running)
+{
+    if (g_replayer) {
+        return;
+    }
+    // Short slices, so a stop request does not wait out the whole interval
+    auto wakeAt = std::chrono::steady_clock::now() + duration;
+    while (running.load(std::memory_order_relaxed) && !g_stopRequested.load(std::memory_order_relaxed)
+           && std::chrono::steady_clock::now() < wakeAt) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+}
+
+//------------------------------------------
+// 6) HISTORICAL CANDLE DOWNLOADER
+//------------------------------------------
+// Coinbase returns at most 350 candles per candles request
+constexpr int64_t kMaxCandlesPerRequest = 350;
+
+// "BTC-USD,ETH-USD" -> {"BTC-USD", "ETH-USD"}
+std::vector<std::string> splitProductList(const std::string& list)
+{
+    std::vector<std::string> products;
+    for (size_t start = 0, comma; start <= list.size(); start = comma + 1) {
+        comma = list.find(',', start);
+        if (comma == std::string::npos) comma = list.size();
+        if (comma > start) products.push_back(list.substr(start, comma - start));
+    }
+    return products;
+}
+
+int64_t granularitySeconds(const std::string& granularity)
+{
+    if (granularity == "ONE_MINUTE") return 60;
+    if (granularity == "FIVE_MINUTE") return 300;
+    if (granularity == "FIFTEEN_MINUTE") return 900;
+    if (granularity == "THIRTY_MINUTE") return 1800;
+    if (granularity == "ONE_HOUR") return 3600;
+    if (granularity == "TWO_HOUR") return 7200;
+    if (granularity == "SIX_HOUR") return 21600;
+    if (granularity == "ONE_DAY") return 86400;
+    return 0;
+}
+
+// Splits [rangeStart, rangeEnd) into max-size chunks for every product, fetches them on
+// numThreads workers spread over every key in `keys` (each with its own rate limit), and appends each chunk to
+// <outDir>/<product>_<granularity>.cbc. Chunks already in the file are skipped, so rerunning
+// the same command resumes an interrupted download.
+bool downloadHistoricalCandles(
+        KeyPool& keys, // API keys to spread the requests over
+        const std::vector<std::string>& productIds, // {"BTC-USD", "ETH-USD"}
+        const std::string& granularity, // "ONE_MINUTE" etc.
+        int64_t rangeStart, // Epoch seconds, inclusive
+        int64_t rangeEnd, // Epoch seconds, exclusive
+        const std::string& outDir, // Output directory
+        int numThreads // Concurrent requests
+)
+{
+    int64_t step = granularitySeconds(granularity);
+    if (step == 0 || rangeEnd <= rangeStart) {
+        std::cerr << "[ERROR] Invalid granularity or range for download.\n";
+        return false;
+    }
+    if (numThreads <= 0) {
+        std::cerr << "[ERROR] Download needs at least one thread.\n";
+        return false;
+    }
+    int64_t chunkSeconds = step * kMaxCandlesPerRequest;
+    uint32_t numChunks = static_cast<uint32_t>((rangeEnd - rangeStart + chunkSeconds - 1) / chunkSeconds);
+
+    std::filesystem::create_directories(outDir);
+
+    // One writer per product, and the list of chunks still to fetch
+    struct Job { size_t product; uint32_t chunk; };
+    std::vector<std::unique_ptr<CandleFileWriter>> writers;
+    std::vector<Job> jobs;
+    for (size_t p = 0; p < productIds.size(); p++) {
+        CandleFileHeader header;
+        header.granularitySeconds = step;
+        header.rangeStart = rangeStart;
+        header.rangeEnd = rangeEnd;
+        header.chunkSeconds = chunkSeconds;
+        std::strncpy(header.productId, productIds[p].c_str(), sizeof(header.productId) - 1);
+
+        std::string path = outDir + "/" + productIds[p] + "_" + granularity + ".cbc";
+        std::set<uint32_t> done;
+        writers.push_back(std::make_unique<CandleFileWriter>());
+        if (!writers.back()->open(path, header, done)) {
+            std::cerr << "[ERROR] Could not open " << path << "\n";
+            return false;
+        }
+        std::cout << "[DOWNLOAD] " << path << ": " << done.size() << "/" << numChunks << " chunks already on disk\n";
+
+        for (uint32_t c = 0; c < numChunks; c++) {
+            if (!done.count(c)) {
+                jobs.push_back({p, c});
+            }
+        }
+    }
+
+    std::atomic<size_t> nextJob{0};
+    std::atomic<size_t> completed{0};
+    std::atomic<size_t> failed{0};
+
+    auto worker = [&]() {
+        CandleColumns columns;
+        for (size_t j = nextJob.fetch_add(1); j < jobs.size(); j = nextJob.fetch_add(1)) {
+            const Job& job = jobs[j];
+            // Coinbase treats end as inclusive, so stop one candle short of the next chunk
+            // (a tail shorter than one candle still asks for the candle at chunkStart)
+            int64_t chunkStart = rangeStart + job.chunk * chunkSeconds;
+            int64_t chunkEnd = std::max(chunkStart, std::min(chunkStart + chunkSeconds, rangeEnd) - step);
+
+            bool ok = false;
+            for (int attempt = 0; attempt < 5 && !ok; attempt++) {
+                if (attempt > 0) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(500 << attempt)); // Back off on errors/429s
+                }
+                ApiCredential& key = keys.acquireMarketData();
+                nlohmann::json candles;
+                try {
+                    candles = getCandlesRange(key.keyName, key.privateKeyPem, productIds[job.product], granularity, chunkStart, chunkEnd);
+                } catch (const std::exception& e) {
+                    std::cerr << "[ERROR] " << e.what() << std::endl;
+                    continue;
+                }
+                if (!candles.is_array()) {
+                    continue;
+                }
+
+                columns.clear();
+                try {
+                    for (const auto& c : candles) {
+                        columns.push_back(std::stoll(c["start"].get<std::string>()),
+                                          std::stod(c["open"].get<std::string>()),
+                                          std::stod(c["high"].get<std::string>()),
+                                          std::stod(c["low"].get<std::string>()),
+                                          std::stod(c["close"].get<std::string>()),
+                                          std::stod(c["volume"].get<std::string>()));
+                    }
+                } catch (const std::exception& e) {
+                    std::cerr << "[ERROR] Bad candle in response: " << e.what() << std::endl;
+                    continue;
+                }
+                ok = writers[job.product]->appendBlock(job.chunk, columns);
+            }
+
+            if (ok) {
+                size_t n = ++completed;
+                if (n % 100 == 0 || n == jobs.size()) {
+                    std::cout << "[DOWNLOAD] " << n << "/" << jobs.size() << " chunks\n";
+                }
+            } else {
+                ++failed;
+                std::cerr << "[ERROR] Giving up on " << productIds[job.product] << " chunk " << job.chunk << " (rerun to resume)\n";
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; t++) {
+        threads.emplace_back(worker);
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    std::cout << "[DOWNLOAD] Done. fetched=" << completed << ", failed=" << failed << "\n";
+    return failed == 0;
+}
+
+//------------------------------------------
+// 6b) SHARED MARKET DATA FEED
+//------------------------------------------
+// CoinBaseBot feed <BTC-USD,ETH-USD> [busName]: one process holds the level2/market_trades
+// connection and polls the candles for every product, and publishes them on a shared-memory
+// bus (market_bus.h). Bots on the same host started with MARKET_BUS=<busName> follow the bus
+// instead of polling and subscribing themselves, so the exchange sees one client however
+// many strategies run.
+
+// The bars behind the bot's MAs: the last 10 one-minute and 6 five-minute candles,
+// published oldest first and closed by a BarsDone. A refresh where any bar set could not be
+// fetched gets no BarsDone, so subscribers don't turn stale bars into a fresh snapshot.
+void publishBars(MarketBusPublisher& bus, KeyPool& keys, uint16_t product, const std::string& productId)
+{
+    static const std::pair<const char*, int> kBarSets[] = {{"ONE_MINUTE", 600}, {"FIVE_MINUTE", 1800}};
+    static const char* kFields[] = {"open", "high", "low", "close", "volume"};
+
+    bool complete = true;
+    for (const auto& [granularity, seconds] : kBarSets) {
+        ApiCredential& key = keys.acquireMarketData();
+        nlohmann::json candles = getCandles(key.keyName, key.privateKeyPem, productId, granularity, seconds);
+        if (!candles.is_array()) {
+            std::cerr << "[WARN] No " << granularity << " candles for " << productId << ", skipping this refresh\n";
+            complete = false;
+            continue;
+        }
+        for (size_t k = candles.size(); k-- > 0;) {
+            const auto& c = candles[k];
+            BusEvent e;
+            e.type = BusEventType::Bar;
+            e.product = product;
+            e.granularitySeconds = static_cast<uint32_t>(granularitySeconds(granularity));
+            e.timeNanos = std::atoll(c.value("start", "0").c_str()) * 1'000'000'000LL;
+            for (int f = 0; f < 5; f++) {
+                e.v[f] = std::atof(c.value(kFields[f], "0").c_str());
+            }
+            bus.publish(e);
+        }
+    }
+    if (!complete) {
+        return;
+    }
+    BusEvent done;
+    done.type = BusEventType::BarsDone;
+    done.product = product;
+    done.timeNanos = monotonicNanos();
+    bus.publish(done);
+}
+
+// Runs until the process is killed; subscribers notice the heartbeat stop and re-attach
+// when a new feed comes up under the same name
+int runMarketFeed(KeyPool& keys, const std::vector<std::string>& products, const std::string& busName)
+{
+    for (int i = 0; i < 3; i++) {
+        syncExchangeClock();
+    }
+    MarketBusPublisher bus;
+    if (products.empty() || !bus.create(busName, products, monotonicNanos())) {
+        return 1;
+    }
+    std::cout << "[FEED] Publishing " << products.size() << " products on market bus " << busName << "\n";
+
+    // Quotes and trades, published from the websocket thread. A quote goes out whenever a
+    // product's top of book changes; all zeros means its book is resyncing.
+    Level2Feed level2;
+    std::vector<TopOfBookCell> tops(products.size());
+    std::vector<TopOfBook> quoted(products.size());
+    for (size_t i = 0; i < products.size(); i++) {
+        level2.addProduct(products[i], &tops[i]);
+    }
+    CoinbaseWsClient ws(
+            "advanced-trade-ws.coinbase.com",
+            std::vector<std::string>{"level2", "market_trades", "heartbeats"},
+            products,
+            nullptr, // Market data needs no JWT
+            [&](const std::string& msg) {
+                int64_t now = monotonicNanos();
+                if (!level2.onMessage(msg, now)) {
+                    std::cerr << "[BOOK] Sequence gap, resubscribing\n";
+                    metrics().bookResyncs.inc();
+                    return false;
+                }
+                if (msg.find("\"market_trades\"") != std::string::npos) {
+                    forEachMarketTrade(msg, [&](const std::string& productId, int64_t time, double price,
+                                                double size, int side) {
+                        int index = bus.productIndex(productId);
+                        if (index < 0) {
+                            return;
+                        }
+                        BusEvent e;
+                        e.type = BusEventType::Trade;
+                        e.side = static_cast<int8_t>(side);
+                        e.product = static_cast<uint16_t>(index);
+                        e.timeNanos = time;
+                        e.v[0] = price;
+                        e.v[1] = size;
+                        bus.publish(e);
+                    });
+                    return true;
+                }
+                for (size_t i = 0; i < products.size(); i++) {
+                    TopOfBook top = tops[i].read();
+                    if (!top.valid) {
+                        top = TopOfBook{};
+                    }
+                    TopOfBook& last = quoted[i];
+                    if (top.bidPrice == last.bidPrice && top.bidSize == last.bidSize
+                        && top.askPrice == last.askPrice && top.askSize == last.askSize) {
+                        continue;
+                    }
+                    last = top;
+                    BusEvent e;
+                    e.type = BusEventType::Quote;
+                    e.product = static_cast<uint16_t>(i);
+                    e.timeNanos = now;
+                    e.v[0] = top.bidPrice;
+                    e.v[1] = top.bidSize;
+                    e.v[2] = top.askPrice;
+                    e.v[3] = top.askSize;
+                    bus.publish(e);
+                }
+                return true;
+            });
+    ws.setOnConnect([&level2] { level2.reset(); });
+    std::thread wsThread = startPinnedThread("level2", coreFromEnv("PIN_L2_CORE"), [&ws] { ws.run(); });
+
+    // Bars, refreshed on the bot's 30 second cadence
+    std::thread barsThread = startPinnedThread("feed-bars", coreFromEnv("PIN_MD_CORE"), [&] {
+        for (;;) {
+            for (size_t i = 0; i < products.size(); i++) {
+                try {
+                    publishBars(bus, keys, static_cast<uint16_t>(i), products[i]);
+                } catch (const std::exception& e) {
+                    std::cerr << "[ERROR] " << products[i] << " bars: " << e.what() << std::endl;
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::seconds(30));
+        }
+    });
+
+    uint64_t lastPublished = 0;
+    for (int64_t beats = 0;; beats++) {
+        bus.heartbeat(monotonicNanos());
+        if (beats % 240 == 0 && beats > 0) {
+            uint64_t published = bus.published();
+            std::cout << "[FEED] " << (published - lastPublished) / 60 << " events/s\n";
+            lastPublished = published;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    }
+}
+
+//------------------------------------------
+// 6c) HTTP TRANSPORT BENCHMARK
+//------------------------------------------
+// CoinBaseBot bench-http [requests] [url]: sequential GETs of a public endpoint on every
+// transport built in (curl, plus beast with HTTP_TRANSPORT=beast). Reports latency
+// percentiles and process CPU time per request, to pick the transport per deployment.
+void benchHttpTransport(HttpTransport transport, const std::string& url, int requests)
+{
+    g_httpTransport = transport;
+    const char* name = transport == HttpTransport::Beast ? "beast" : "curl";
+    std::string body;
+
+    // Warm-up: DNS, connection pool, TLS session
+    for (int i = 0; i < 3; i++) {
+        body.clear();
+        httpRequestInto("GET", url.c_str(), "", std::string(), body);
+    }
+
+    std::vector<int64_t> latencies;
+    latencies.reserve(static_cast<size_t>(requests));
+    int failures = 0;
+    std::clock_t cpuStart = std::clock();
+    for (int i = 0; i < requests; i++) {
+        body.clear();
+        int64_t start = monotonicNanos();
+        HttpResult r = httpRequestInto("GET", url.c_str(), "", std::string(), body);
+        latencies.push_back(monotonicNanos() - start);
+        if (!r.ok()) {
+            failures++;
+        }
+    }
+    double cpuMicros = static_cast<double>(std::clock() - cpuStart) * 1e6 / CLOCKS_PER_SEC / std::max(requests, 1);
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentileMicros = [&latencies](double q) {
+        if (latencies.empty()) return int64_t{0};
+        size_t i = std::min(latencies.size() - 1, static_cast<size_t>(q * static_cast<double>(latencies.size())));
+        return latencies[i] / 1000;
+    };
+    std::cout << "[BENCH] " << name << ": " << requests << " requests, p50=" << percentileMicros(0.50)
+              << "us p90=" << percentileMicros(0.90) << "us p99=" << percentileMicros(0.99)
+              << "us max=" << percentileMicros(1.0) << "us, cpu=" << cpuMicros << "us/request, failures="
+              << failures << "\n";
+}
+
+#ifdef COINBASEBOT_ASYNC_CLIENT
+// One candle request, sent once a market-data key has a token
+Task<nlohmann::json> fetchCandlesAsync(EventLoop& loop, KeyPool& keys, std::string productId, std::string granularity,
+                                       int secondsToFetch)
+{
+    ApiCredential* key = co_await acquireMarketDataAsync(loop, keys);
+    co_return co_await getCandlesAsync(loop, key->keyName, key->privateKeyPem, productId, granularity, secondsToFetch);
+}
+
+// CoinBaseBot scan <BTC-USD,ETH-USD,...>: the bot's short/long MAs for every product, with
+// all candle requests in flight at once on one thread (as fast as the keys' buckets allow)
+Task<void> scanProductsAsync(EventLoop& loop, KeyPool& keys, std::vector<std::string> products)
+{
+    std::vector<Task<nlohmann::json>> fetches;
+    for (const std::string& productId : products) {
+        fetches.push_back(fetchCandlesAsync(loop, keys, productId, "ONE_MINUTE", 600));
+        fetches.push_back(fetchCandlesAsync(loop, keys, productId, "FIVE_MINUTE", 1800));
+    }
+    int64_t start = monotonicNanos();
+    std::vector<nlohmann::json> candles = co_await whenAll(loop, std::move(fetches));
+    std::cout << "[SCAN] " << candles.size() << " requests in " << (monotonicNanos() - start) / 1'000'000 << "ms\n";
+
+    for (size_t i = 0; i < products.size(); i++) {
+        double shortMA = computeMovingAverage(candles[2 * i], 5);
+        double longMA = computeMovingAverage(candles[2 * i + 1], 5);
+        std::cout << "[SCAN] " << products[i] << " shortMA=" << shortMA << " longMA=" << longMA
+                  << (shortMA <= 0.0 || longMA <= 0.0 ? " (no data)" : shortMA > longMA ? " above" : " below") << "\n";
+    }
+}
+#endif
+
+//------------------------------------------
+// 7) BOT THREADS
+//------------------------------------------
+// market data -> strategy -> order gateway, plus a housekeeping thread.
+// Threads only talk through SPSC queues; each can be pinned to a core
+// (PIN_MD_CORE, PIN_STRATEGY_CORE, PIN_GATEWAY_CORE, PIN_HOUSEKEEPING_CORE) and the
+// strategy thread can busy-poll its inputs (STRATEGY_BUSY_POLL=1).
+
+// Moving averages computed by the market-data thread
+struct MarketSnapshot {
+    double shortMA = 0.0;
+    double longMA = 0.0;
+    int64_t timestampNanos = 0;
+};
+
+// Order the strategy wants sent (already passed the risk check)
+struct OrderRequest {
+    int sideSign = 0;          // +1 BUY, -1 SELL
+    double limitPrice = 0.0;
+    double quoteUsd = 0.0;
+    double referencePrice = 0.0; // shortMA at decision time
+    int64_t snapshotNanos = 0;   // Monotonic time of the snapshot behind the decision
+    int64_t decidedNanos = 0;    // Monotonic time the strategy emitted the order
+    ClientOrderId clientOrderId; // Assigned once; reused on every retry
+
+    // Edit: amend the resting order clientOrderId to limitPrice / baseSize
+    enum class Kind : uint8_t { Place, Edit };
+    Kind kind = Kind::Place;
+    double baseSize = 0.0;
+};
+
+// What the gateway reports back to the strategy: the outcome of a submission,
+// or the latest cumulative fill/status of a live order
+struct OrderUpdate {
+    enum class Kind : uint8_t { Ack, Reject, Status, Edited, EditRejected };
+
+    Kind kind = Kind::Status;
+    ClientOrderId clientOrderId;
+    char exchangeOrderId[48] = {};
+    double cumulativeBase = 0.0;
+    double cumulativeQuote = 0.0;
+    bool filled = false;         // Status: fully filled
+    bool cancelled = false;      // Status: cancelled or expired
+    bool failed = false;         // Status: failed/rejected after acceptance
+    double limitPrice = 0.0;     // Edited: the new resting price
+    int64_t timestampNanos = 0;  // Monotonic time the update was observed
+};
+
+// Maps a Coinbase order status (REST poll or user channel) onto an update
+inline OrderUpdate statusUpdate(const ClientOrderId& id, const std::string& status,
+                                double cumulativeBase, double cumulativeQuote, int64_t nowNanos)
+{
+    OrderUpdate u;
+    u.kind = OrderUpdate::Kind::Status;
+    u.clientOrderId = id;
+    u.cumulativeBase = cumulativeBase;
+    u.cumulativeQuote = cumulativeQuote;
+    u.filled = (status == "FILLED");
+    u.cancelled = (status == "CANCELLED" || status == "EXPIRED");
+    u.failed = (status == "FAILED");
+    u.timestampNanos = nowNanos;
+    return u;
+}
+
+struct BotContext {
+    KeyPool* keys = nullptr;          // Market data rotates over every key
+    ApiCredential* orderKey = nullptr; // Orders stay on the trading portfolio's key
+    std::string productId;
+
+    RiskEngine risk;          // Owned by the strategy thread after startup
+    int productSlot = -1;
+
+    SpscQueue<MarketSnapshot, 64> snapshots;
+    SpscQueue<OrderRequest, 64> orders;
+    SpscQueue<OrderUpdate, 256> updates;        // From the order gateway
+    SpscQueue<OrderUpdate, 1024> streamUpdates; // From the WebSocket user channel
+    TopOfBookCell topOfBook;                    // From the level2 book thread (or the market bus)
+    bool useOrderBook = false;
+
+    // Market data from a feed process (MARKET_BUS) instead of our own polling and level2
+    // connection. busQuotes: its quotes feed topOfBook (no local book owns it).
+    MarketBusSubscriber* bus = nullptr;
+    std::string busName;
+    bool busQuotes = false;
+    WaitStrategy busWait = WaitStrategy::Sleep;
+
+    // Strategy state journal (JOURNAL_FILE); written by the strategy thread only.
+    // Its recovered() state is read-only once the threads start.
+    StateJournal* journal = nullptr;
+
+    WaitStrategy strategyWait = WaitStrategy::Sleep;
+    std::atomic<bool> running{true};
+
+    // Reprice a resting order once its price drifts this far from the new target
+    // (REPRICE_BPS, 0 disables), at most once per repriceIntervalNanos
+    double repriceThreshold = 0.001;
+    int64_t repriceIntervalNanos = 10'000'000'000LL;
+
+    // Cancel all live orders when the bot stops (CANCEL_ON_EXIT=1)
+    bool cancelOnExit = false;
+
+    // How often the gateway polls live orders for fills (ORDER_POLL_SECONDS)
+    int64_t orderPollNanos = 5'000'000'000LL;
+
+    // REST behaviour for market data
+    bool hedgeGets = false;
+    int64_t candleTimeoutNanos = 5'000'000'000LL;
+    CancelToken shutdown; // Aborts in-flight requests when the bot stops
+};
+
+// Every loop calls this each iteration: turns a SIGINT/SIGTERM into an orderly stop.
+// Returns false once the bot is stopping.
+bool keepRunning(BotContext& ctx)
+{
+    if (g_stopRequested.load(std::memory_order_relaxed) && ctx.running.exchange(false)) {
+        std::cout << "[INFO] Stop requested, shutting down\n";
+        ctx.shutdown.cancel(); // Abort in-flight market data requests
+    }
+    return ctx.running.load(std::memory_order_relaxed);
+}
+
+// Blocks (politely) until the queue accepts the item or the bot stops
+template <typename Queue, typename T>
+bool pushOrWait(BotContext& ctx, Queue& queue, const T& item)
+{
+    while (!queue.tryPush(item)) {
+        if (!ctx.running.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        idleWait(WaitStrategy::Sleep);
+    }
+    return true;
+}
+
+// Polls candles every ~30 seconds and publishes the MAs
+void marketDataLoop(BotContext& ctx)
+{
+    // Scratch memory for everything allocated during one iteration
+    TickArena arena;
+
+    // When the loop is supposed to wake up next (for loop lag)
+    int64_t scheduledWakeNanos = 0;
+
+    while (keepRunning(ctx))
+    {
+        // A replay run ends when the capture has been fully consumed
+        if (g_replayer && g_replayer->httpExhausted()) {
+            std::cout << "[REPLAY] Capture exhausted, exiting.\n";
+            break;
+        }
+
+        if (scheduledWakeNanos != 0) {
+            metrics().loopLag.observeNanos(monotonicNanos() - scheduledWakeNanos);
+        }
+
+        {
+            // Released in one shot when the iteration ends
+            TickArena::Scope tickScope(arena);
+#ifdef COUNT_HEAP_ALLOCATIONS
+            size_t heapAllocsAtStart = heapAllocationCount();
+#endif
+
+            try {
+                // Both candle requests share one tick deadline
+                RequestOptions opts;
+                opts.deadlineNanos = monotonicNanos() + ctx.candleTimeoutNanos;
+                opts.cancel = &ctx.shutdown;
+                opts.hedge = ctx.hedgeGets;
+
+                // Get short-term MA (1-minute candles)
+                // Need at least 5 minutes of 1-minute data. We get ~10 minutes to be safe:
+                ApiCredential* key = &ctx.keys->acquireMarketData();
+                auto oneMinCloses = getCandleCloses(key->keyName, key->privateKeyPem, ctx.productId, "ONE_MINUTE", 600 /* 10 min in seconds*/, arena.resource(), opts);
+                double shortMA = computeMovingAverage(oneMinCloses, 5);
+
+                // Get long-term MA (5-minute candles)
+                // Need at least 25 minutes if we wanted 5 periods of 5-minute. We get ~30 minutes to be safe:
+                key = &ctx.keys->acquireMarketData();
+                auto fiveMinCloses = getCandleCloses(key->keyName, key->privateKeyPem, ctx.productId, "FIVE_MINUTE", 1800 /* 30 min in seconds*/, arena.resource(), opts);
+                double longMA = computeMovingAverage(fiveMinCloses, 5);
+
+                // Error Check
+                if (shortMA <= 0.0 || longMA <= 0.0) {
+                    std::cerr << "[WARN] Could not compute MAs. shortMA=" << shortMA << ", longMA=" << longMA << "\n";
+                } else {
+                    std::cout << "[INFO] shortMA=" << shortMA << ", longMA=" << longMA << std::endl;
+#ifdef COUNT_HEAP_ALLOCATIONS
+                    std::cout << "[ARENA] arena_upstream_allocs=" << arena.upstreamAllocations()
+                              << ", heap_allocs=" << (heapAllocationCount() - heapAllocsAtStart) << std::endl;
+#endif
+                    pushOrWait(ctx, ctx.snapshots, MarketSnapshot{shortMA, longMA, monotonicNanos()});
+                }
+            } catch (const std::exception& e) {
+                std::cerr << "[ERROR] " << e.what() << std::endl;
+            }
+        }
+
+        // Wait 30 seconds before next iteration
+        scheduledWakeNanos = monotonicNanos() + 30'000'000'000LL;
+        loopSleep(std::chrono::seconds(30), ctx.running);
+    }
+
+    ctx.running.store(false);
+    ctx.shutdown.cancel();
+}
+
+// A feed whose heartbeat is older than this is treated as gone
+constexpr int64_t kBusStaleNanos = 5'000'000'000LL;
+
+// MARKET_BUS counterpart of marketDataLoop: follows the feed process's bus. Each bar refresh
+// (BarsDone) becomes a MarketSnapshot with the same 5-bar MAs marketDataLoop computes, and
+// quotes are folded into ctx.topOfBook when busQuotes is set.
+void busMarketDataLoop(BotContext& ctx)
+{
+    MarketBusSubscriber& bus = *ctx.bus;
+    int product = bus.isAttached() ? bus.productIndex(ctx.productId) : -1;
+    std::map<int64_t, double> oneMinCloses;  // Candle start -> close
+    std::map<int64_t, double> fiveMinCloses;
+    uint64_t lostSeen = 0;
+    int64_t lastAttachNanos = monotonicNanos();
+    bool feedDown = false;
+
+    // Average of the newest numCandles closes, 0 when there are fewer
+    auto movingAverage = [](const std::map<int64_t, double>& closes, int numCandles) {
+        if (closes.size() < static_cast<size_t>(numCandles)) {
+            return 0.0;
+        }
+        double sum = 0.0;
+        auto it = closes.rbegin();
+        for (int i = 0; i < numCandles; i++, ++it) {
+            sum += it->second;
+        }
+        return sum / static_cast<double>(numCandles);
+    };
+
+    BusEvent e;
+    while (keepRunning(ctx))
+    {
+        if (!bus.isAttached() || !bus.poll(e)) {
+            int64_t now = monotonicNanos();
+            if (!bus.isAttached() || !bus.publisherAlive(now, kBusStaleNanos)) {
+                if (!feedDown) {
+                    std::cerr << "[BUS] No live feed on " << ctx.busName << ", waiting for it\n";
+                    feedDown = true;
+                }
+                // A restarted feed creates a new segment under the same name
+                if (now - lastAttachNanos >= 1'000'000'000LL) {
+                    lastAttachNanos = now;
+                    if (bus.attach(ctx.busName) && bus.publisherAlive(now, kBusStaleNanos)) {
+                        product = bus.productIndex(ctx.productId);
+                        if (product < 0) {
+                            std::cerr << "[BUS] " << ctx.busName << " does not carry " << ctx.productId << "\n";
+                        }
+                    }
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            } else {
+                if (feedDown) {
+                    std::cout << "[BUS] Following feed on " << ctx.busName << "\n";
+                    feedDown = false;
+                }
+                idleWait(ctx.busWait);
+            }
+            continue;
+        }
+
+        metrics().busEvents.inc();
+        if (bus.lost() != lostSeen) {
+            std::cerr << "[BUS] Fell behind the feed, " << bus.lost() - lostSeen << " events lost\n";
+            metrics().busEventsLost.inc(bus.lost() - lostSeen);
+            lostSeen = bus.lost();
+        }
+        if (static_cast<int>(e.product) != product) {
+            continue;
+        }
+
+        switch (e.type) {
+            case BusEventType::Quote:
+                if (ctx.busQuotes) {
+                    TopOfBook t;
+                    t.bidPrice = e.v[0];
+                    t.bidSize = e.v[1];
+                    t.askPrice = e.v[2];
+                    t.askSize = e.v[3];
+                    t.timestampNanos = e.timeNanos; // Feed's monotonic clock, same host
+                    t.valid = t.bidPrice > 0.0 && t.askPrice > 0.0;
+                    ctx.topOfBook.publish(t);
+                }
+                break;
+            case BusEventType::Bar: {
+                if (e.granularitySeconds != 60 && e.granularitySeconds != 300) {
+                    break;
+                }
+                auto& closes = e.granularitySeconds == 60 ? oneMinCloses : fiveMinCloses;
+                closes[e.timeNanos] = e.v[3];
+                while (closes.size() > 64) {
+                    closes.erase(closes.begin());
+                }
+                break;
+            }
+            case BusEventType::BarsDone: {
+                double shortMA = movingAverage(oneMinCloses, 5);
+                double longMA = movingAverage(fiveMinCloses, 5);
+                if (shortMA <= 0.0 || longMA <= 0.0) {
+                    std::cerr << "[WARN] Could not compute MAs. shortMA=" << shortMA << ", longMA=" << longMA << "\n";
+                } else {
+                    std::cout << "[INFO] shortMA=" << shortMA << ", longMA=" << longMA << std::endl;
+                    pushOrWait(ctx, ctx.snapshots, MarketSnapshot{shortMA, longMA, monotonicNanos()});
+                }
+                break;
+            }
+            case BusEventType::Trade:
+                break;
+        }
+    }
+
+    ctx.running.store(false);
+    ctx.shutdown.cancel();
+}
+
+// Crossover decisions; never touches the network
+// A book older than this is ignored (feed down or resyncing)
+constexpr int64_t kMaxBookAgeNanos = 5'000'000'000LL;
+
+// Post-only limit price: join the touch (best bid for a BUY, best ask for a SELL) when the
+// local book is live, otherwise fall back to a small offset from the short MA
+double makerLimitPrice(const BotContext& ctx, int sideSign, double shortMA)
+{
+    if (ctx.useOrderBook) {
+        TopOfBook top = ctx.topOfBook.read();
+        if (top.valid && monotonicNanos() - top.timestampNanos < kMaxBookAgeNanos) {
+            return sideSign > 0 ? top.bidPrice : top.askPrice;
+        }
+    }
+    // Multiply by 0.999 / 1.001 to Help Ensure a Maker Order (post_only ensures this)
+    return sideSign > 0 ? shortMA * 0.999 : shortMA * 1.001;
+}
+
+void strategyLoop(BotContext& ctx)
+{
+    // Signal, entry, exit and sizing rules (strategy.h); the MA history lives in its signal
+    MaCrossoverStrategy strategy;
+    bool havePosition = false;  // Are we currently in a long position? (set by real fills)
+
+    // Track the fill price of last buy
+    double lastBuyPrice = 0.0;
+
+    // Every order we've sent that hasn't reached a terminal state
+    OrderTracker tracker;
+
+    // Journal: what a restart needs to resume without re-deriving anything
+    static_assert(std::is_trivially_copyable<MaCrossoverStrategy::SignalType>::value, "signal must be trivially copyable to journal");
+    static_assert(sizeof(MaCrossoverStrategy::SignalType) <= JournalStrategyState::kMaxSignalBytes, "signal too large to journal");
+    auto currentState = [&] {
+        JournalStrategyState st;
+        st.havePosition = havePosition ? 1 : 0;
+        st.lastBuyPrice = lastBuyPrice;
+        st.positionUsd = ctx.risk.positionUsd(ctx.productSlot);
+        st.signalBytes = sizeof(strategy.signal());
+        std::memcpy(st.signal, &strategy.signal(), sizeof(strategy.signal()));
+        return st;
+    };
+    auto journalOrder = [&](const TrackedOrder& o) {
+        if (!ctx.journal) {
+            return;
+        }
+        int64_t now = monotonicNanos();
+        if (isTerminal(o.state)) {
+            ctx.journal->appendOrderRemoved(o.clientOrderId, now);
+        } else {
+            ctx.journal->appendOrder(o, now);
+        }
+    };
+    JournalStrategyState lastJournaled;
+    auto appendStateIfChanged = [&](const JournalStrategyState& st) {
+        if (st != lastJournaled) {
+            ctx.journal->appendStrategyState(st, monotonicNanos());
+            lastJournaled = st;
+        }
+    };
+    auto journalState = [&] {
+        if (!ctx.journal) {
+            return;
+        }
+        JournalStrategyState st = currentState();
+        appendStateIfChanged(st);
+        if (ctx.journal->needsCompaction()) {
+            std::vector<TrackedOrder> open;
+            tracker.forEachOpen([&](TrackedOrder& o) { open.push_back(o); });
+            ctx.journal->compact(st, open);
+        }
+    };
+
+    // Resume from the journal: position, signal and working orders
+    if (ctx.journal) {
+        const JournalRecovery& rec = ctx.journal->recovered();
+        if (rec.haveState && rec.state.signalBytes == sizeof(strategy.signal())) {
+            havePosition = rec.state.havePosition != 0;
+            lastBuyPrice = rec.state.lastBuyPrice;
+            MaCrossoverStrategy::SignalType signal;
+            std::memcpy(&signal, rec.state.signal, sizeof(signal));
+            strategy.restoreSignal(signal);
+            lastJournaled = rec.state;
+        }
+        double pendingUsd = 0.0;
+        for (const TrackedOrder& o : rec.orders) {
+            if (o.state != OrderState::New && o.exchangeOrderId[0] == '\0') {
+                std::cerr << "[WARN] Journaled order " << o.clientOrderId.view() << " has no exchange id; not resuming it\n";
+                continue; // The gateway could never poll or cancel it
+            }
+            tracker.restore(o);
+            pendingUsd += o.sideSign * std::max(0.0, o.quoteSize - o.filledQuote);
+            // Never acked: resend with the same client_order_id, which the exchange deduplicates
+            if (o.state == OrderState::New) {
+                OrderRequest req{o.sideSign, o.limitPrice, o.quoteSize, 0.0,
+                                 monotonicNanos(), monotonicNanos(), o.clientOrderId};
+                pushOrWait(ctx, ctx.orders, req);
+            }
+        }
+        ctx.risk.restore(ctx.productSlot, rec.haveState ? rec.state.positionUsd : 0.0, pendingUsd);
+        std::cout << "[JOURNAL] Resumed: position=" << (havePosition ? "LONG" : "FLAT") << " lastBuy=" << lastBuyPrice
+                  << " workingOrders=" << rec.orders.size() << " (" << rec.records << " records)\n";
+    }
+
+    // Apply one gateway update to the tracker, risk engine and position
+    auto applyUpdate = [&](const OrderUpdate& u) {
+        TrackedOrder* o = tracker.find(u.clientOrderId.view());
+        if (!o) {
+            return;
+        }
+        int64_t now = monotonicNanos();
+
+        switch (u.kind) {
+            case OrderUpdate::Kind::Ack:
+                tracker.onAccepted(u.clientOrderId.view(), u.exchangeOrderId, now);
+                std::cout << "[STRATEGY] Placed " << (o->sideSign > 0 ? "BUY" : "SELL")
+                          << " order at limit=" << o->limitPrice << " id=" << u.clientOrderId.view() << "\n";
+                break;
+            case OrderUpdate::Kind::Reject:
+                tracker.onClosed(u.clientOrderId.view(), false, now);
+                break;
+            case OrderUpdate::Kind::Edited:
+            case OrderUpdate::Kind::EditRejected: {
+                bool accepted = (u.kind == OrderUpdate::Kind::Edited);
+                tracker.onEditResult(u.clientOrderId.view(), accepted, u.limitPrice, now);
+                std::cout << "[STRATEGY] Reprice " << (accepted ? "accepted" : "rejected")
+                          << " id=" << u.clientOrderId.view() << " limit=" << o->limitPrice << "\n";
+                break;
+            }
+            case OrderUpdate::Kind::Status: {
+                FillDelta d = tracker.onFill(u.clientOrderId.view(), u.cumulativeBase, u.cumulativeQuote, u.filled, now);
+                if (d.quote > 0.0) {
+                    ctx.risk.onFill(ctx.productSlot, o->sideSign, d.quote);
+                    if (o->sideSign > 0) {
+                        havePosition = true;
+                        lastBuyPrice = o->averageFillPrice();
+                    }
+                    std::cout << "[FILL] " << u.clientOrderId.view() << " +" << d.base << " @ "
+                              << d.quote / d.base << " (" << orderStateName(o->state) << ")\n";
+                }
+                if (o->sideSign < 0 && o->state == OrderState::Filled) {
+                    havePosition = false;
+                }
+                if (u.cancelled || u.failed) {
+                    tracker.onClosed(u.clientOrderId.view(), u.cancelled, now);
+                }
+                break;
+            }
+        }
+
+        // A fill moves the position: journal the new state before the order record (above all
+        // before OrderRemoved), so a crash in between never loses both the order and the position
+        if (ctx.journal) {
+            appendStateIfChanged(currentState());
+        }
+        journalOrder(*o);
+        if (isTerminal(o->state)) {
+            // Whatever did not fill no longer counts against the position limit
+            double unfilled = o->quoteSize - o->filledQuote;
+            if (unfilled > 0.0) {
+                ctx.risk.onOrderReleased(ctx.productSlot, o->sideSign, unfilled);
+            }
+            std::cout << "[ORDER] " << u.clientOrderId.view() << " " << orderStateName(o->state) << "\n";
+            tracker.release(u.clientOrderId.view());
+        }
+    };
+
+    while (keepRunning(ctx))
+    {
+        // Updates from the gateway and the user channel first, so decisions see the latest position
+        while (auto update = ctx.updates.tryPop()) {
+            applyUpdate(*update);
+        }
+        while (auto update = ctx.streamUpdates.tryPop()) {
+            applyUpdate(*update);
+        }
+        // Don't stack orders while one is still working
+        bool orderInFlight = tracker.trackedOrders() > 0;
+
+        auto snapshot = ctx.snapshots.tryPop();
+        if (!snapshot) {
+            idleWait(ctx.strategyWait);
+            continue;
+        }
+
+        double shortMA = snapshot->shortMA;
+        double longMA = snapshot->longMA;
+        ctx.risk.updateReferencePrice(ctx.productSlot, shortMA);
+
+        // Chase the market with resting orders: amend in place once the price has drifted
+        if (ctx.repriceThreshold > 0.0) {
+            int64_t now = monotonicNanos();
+            tracker.forEachOpen([&](TrackedOrder& o) {
+                if (o.state == OrderState::New || o.editPending || o.exchangeOrderId[0] == '\0'
+                    || now - o.lastEditNanos < ctx.repriceIntervalNanos) {
+                    return;
+                }
+                // Chase within the price band, so the amend is not rejected on every snapshot
+                double target = ctx.risk.clampToPriceBand(ctx.productSlot, makerLimitPrice(ctx, o.sideSign, shortMA));
+                if (o.sideSign < 0) {
+                    // Never chase below the fee-covering price; if that is above the band, stay put
+                    double floor = strategy.minExitPrice(PositionView{havePosition, lastBuyPrice, true});
+                    if (floor > ctx.risk.clampToPriceBand(ctx.productSlot, floor)) {
+                        return;
+                    }
+                    target = std::max(target, floor);
+                }
+                if (std::fabs(target / o.limitPrice - 1.0) < ctx.repriceThreshold) {
+                    return;
+                }
+                RiskResult verdict = ctx.risk.checkAmend(ctx.productSlot, target, now);
+                if (verdict != RiskResult::Accept) {
+                    std::cerr << "[RISK] Reprice rejected: " << riskResultName(verdict) << "\n";
+                    metrics().ordersRejectedRisk.inc();
+                    o.lastEditNanos = now; // Throttled like a sent amend, so it is not retried every snapshot
+                    return;
+                }
+                // Keep the requested notional: whatever is still unfilled, at the new price
+                double remainingQuote = std::max(0.0, o.quoteSize - o.filledQuote);
+                OrderRequest req;
+                req.kind = OrderRequest::Kind::Edit;
+                req.sideSign = o.sideSign;
+                req.limitPrice = target;
+                req.baseSize = o.filledBase + remainingQuote / target;
+                req.referencePrice = shortMA;
+                req.snapshotNanos = snapshot->timestampNanos;
+                req.decidedNanos = now;
+                req.clientOrderId = o.clientOrderId;
+                tracker.onEditSent(o.clientOrderId.view(), now);
+                journalOrder(o);
+                pushOrWait(ctx, ctx.orders, req);
+            });
+        }
+
+        Decision decision = strategy.decide(StrategyInput{shortMA, longMA, snapshot->timestampNanos},
+                                            PositionView{havePosition, lastBuyPrice, orderInFlight});
+        if (decision.exitBlocked) {
+            std::cout << "[STRATEGY] shortMA < longMA but not enough profit to cover fees.\n";
+        }
+        journalState();
+        if (decision.action == Decision::Action::None) {
+            continue;
+        }
+
+        int sideSign = static_cast<int>(decision.side);
+        const char* sideName = sideSign > 0 ? "BUY" : "SELL";
+        // Join the touch, but never below the exit rule's floor (fees) on the way out
+        double limitPrice = std::max(makerLimitPrice(ctx, sideSign, shortMA), decision.minPrice);
+
+        RiskResult verdict = ctx.risk.check(ctx.productSlot, sideSign, limitPrice, decision.quoteUsd, monotonicNanos());
+        if (verdict != RiskResult::Accept) {
+            std::cerr << "[RISK] " << sideName << " rejected: " << riskResultName(verdict) << "\n";
+            metrics().ordersRejectedRisk.inc();
+            continue;
+        }
+        OrderRequest req{sideSign, limitPrice, decision.quoteUsd, shortMA,
+                         snapshot->timestampNanos, monotonicNanos(), clientOrderIds().next()};
+        if (TrackedOrder* o = tracker.onSubmitted(req.clientOrderId, req.sideSign, req.limitPrice, req.quoteUsd, req.decidedNanos)) {
+            journalOrder(*o); // Journaled before it can reach the exchange
+        }
+        pushOrWait(ctx, ctx.orders, req);
+    }
+}
+
+// Sends orders and polls live ones for fills; the only thread that blocks on order round trips
+void orderGatewayLoop(BotContext& ctx)
+{
+    ApiCredential& key = *ctx.orderKey; // Every order request waits on this key's bucket
+    // Orders acked by the exchange and not yet terminal: client id -> exchange order id
+    std::vector<std::pair<ClientOrderId, std::string>> liveOrders;
+    if (ctx.journal) {
+        for (const TrackedOrder& o : ctx.journal->recovered().orders) {
+            if (o.exchangeOrderId[0] != '\0') {
+                liveOrders.emplace_back(o.clientOrderId, o.exchangeOrderId);
+            }
+        }
+    }
+    int64_t lastPollNanos = monotonicNanos();
+
+    while (keepRunning(ctx))
+    {
+        // Poll live orders for fills/cancellations
+        if (!liveOrders.empty() && monotonicNanos() - lastPollNanos >= ctx.orderPollNanos) {
+            lastPollNanos = monotonicNanos();
+            for (size_t i = 0; i < liveOrders.size();) {
+                key.limiter.acquire();
+                OrderStatus st = getOrderStatus(key.keyName, key.privateKeyPem, liveOrders[i].second);
+                if (!st.ok) {
+                    i++;
+                    continue;
+                }
+                OrderUpdate u = statusUpdate(liveOrders[i].first, st.status, st.filledBase, st.filledQuote, monotonicNanos());
+                pushOrWait(ctx, ctx.updates, u);
+                if (u.filled || u.cancelled || u.failed) {
+                    liveOrders[i] = liveOrders.back();
+                    liveOrders.pop_back();
                 } else {
-                    std::cout << "[STRATEGY] shortMA < longMA but not enough profit to cover fees.\n";
+                    i++;
                 }
             }
+        }
+
+        auto req = ctx.orders.tryPop();
+        if (!req) {
+            idleWait(WaitStrategy::Sleep);
+            continue;
+        }
 
-            // Update old states
-            shortWasAbove = shortAbove;
-            shortWasBelow = shortBelow;
+        if (req->kind == OrderRequest::Kind::Edit) {
+            auto live = std::find_if(liveOrders.begin(), liveOrders.end(),
+                                     [&](const auto& entry) { return entry.first == req->clientOrderId; });
+            bool edited = false;
+            if (live != liveOrders.end()) {
+                key.limiter.acquire();
+                try {
+                    edited = editLimitOrder(key.keyName, key.privateKeyPem, live->second,
+                                            req->limitPrice, req->baseSize);
+                } catch (const std::exception& e) {
+                    std::cerr << "[ERROR] " << e.what() << std::endl;
+                }
+            }
+            OrderUpdate u;
+            u.kind = edited ? OrderUpdate::Kind::Edited : OrderUpdate::Kind::EditRejected;
+            u.clientOrderId = req->clientOrderId;
+            u.limitPrice = req->limitPrice;
+            u.timestampNanos = monotonicNanos();
+            pushOrWait(ctx, ctx.updates, u);
+            continue;
+        }
 
+        bool ok = false;
+        std::string exchangeOrderId;
+        key.limiter.acquire();
+        try {
+            ok = placeLimitOrder(
+                    key.keyName, key.privateKeyPem,
+                    ctx.productId, req->sideSign > 0 ? "BUY" : "SELL",
+                    req->limitPrice, req->quoteUsd,
+                    req->clientOrderId.str(),
+                    &exchangeOrderId
+            );
         } catch (const std::exception& e) {
             std::cerr << "[ERROR] " << e.what() << std::endl;
         }
+        // Without an exchange id the order can be neither polled nor cancelled, and tracking it
+        // would block the strategy forever: close it on our side instead
+        if (ok && exchangeOrderId.empty()) {
+            std::cerr << "[WARN] Order " << req->clientOrderId.view()
+                      << " acknowledged without an order_id; treating it as rejected\n";
+            ok = false;
+        }
+        int64_t ackNanos = monotonicNanos();
+        metrics().snapshotToOrderAck.observeNanos(ackNanos - req->snapshotNanos);
+        std::cout << "[LATENCY] decide=" << (req->decidedNanos - req->snapshotNanos) / 1000
+                  << "us, queue+send+ack=" << (ackNanos - req->decidedNanos) / 1000 << "us\n";
 
-        // Wait 30 seconds before next iteration
-        std::this_thread::sleep_for(std::chrono::seconds(30));
+        OrderUpdate u;
+        u.kind = ok ? OrderUpdate::Kind::Ack : OrderUpdate::Kind::Reject;
+        u.clientOrderId = req->clientOrderId;
+        std::strncpy(u.exchangeOrderId, exchangeOrderId.c_str(), sizeof(u.exchangeOrderId) - 1);
+        u.timestampNanos = ackNanos;
+        pushOrWait(ctx, ctx.updates, u);
+
+        if (ok) {
+            liveOrders.emplace_back(req->clientOrderId, exchangeOrderId);
+        }
+    }
+
+    // Leave nothing resting on the book: one batch cancel for everything still live
+    if (ctx.cancelOnExit && !liveOrders.empty() && !g_replayer) {
+        std::vector<std::string> ids;
+        for (const auto& live : liveOrders) {
+            ids.push_back(live.second);
+        }
+        cancelOrders(key, ids);
+    }
+}
+
+// Periodic low-priority work off the trading path
+void housekeepingLoop(BotContext& ctx)
+{
+    int64_t lastReportNanos = monotonicNanos();
+    int64_t lastClockSyncNanos = monotonicNanos();
+    while (keepRunning(ctx))
+    {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+
+        // The capture log buffers its writes; push them out at least once a second
+        if (g_recorder) {
+            g_recorder->flush();
+        }
+
+        // Re-measure the exchange clock offset every minute
+        if (monotonicNanos() - lastClockSyncNanos >= 60'000'000'000LL) {
+            lastClockSyncNanos = monotonicNanos();
+            syncExchangeClock();
+        }
+
+        if (monotonicNanos() - lastReportNanos >= 60'000'000'000LL) {
+            lastReportNanos = monotonicNanos();
+            std::cout << "[HOUSEKEEPING] queues: snapshots=" << ctx.snapshots.sizeApprox()
+                      << ", orders=" << ctx.orders.sizeApprox()
+                      << ", updates=" << ctx.updates.sizeApprox() << std::endl;
+        }
+    }
+}
+
+//------------------------------------------
+// MAIN BOT
+//------------------------------------------
+int main(int argc, char* argv[])
+{
+    // Your Key IDs and Private Keys: KEY_NAME / PRIVATE_KEY_PEM, plus KEY_NAME_1 / PRIVATE_KEY_PEM_1, ...
+    // for more rate-limit budget. API_KEY_RPS is the per-key request rate.
+    const char* keyRps = std::getenv("API_KEY_RPS");
+    KeyPool keys;
+
+    // Bulk history mode:
+    // CoinBaseBot download <BTC-USD,ETH-USD> <startEpoch> <endEpoch> [granularity] [outDir] [threads] [requestsPerSecond]
+    if (argc >= 5 && std::string(argv[1]) == "download") {
+        std::vector<std::string> products = splitProductList(argv[2]);
+        std::string granularity = argc > 5 ? argv[5] : "ONE_MINUTE";
+        std::string outDir = argc > 6 ? argv[6] : "candles";
+        int threads = argc > 7 ? std::atoi(argv[7]) : 8;
+        double rps = argc > 8 ? std::atof(argv[8]) : 10.0; // Per key
+        if (threads <= 0 || !(rps > 0)) {
+            std::cerr << "[ERROR] threads and requestsPerSecond must be positive.\n";
+            return 1;
+        }
+
+        if (!keys.loadFromEnv(rps)) {
+            return 1;
+        }
+        bool ok = downloadHistoricalCandles(keys, products, granularity,
+                                            std::atoll(argv[3]), std::atoll(argv[4]),
+                                            outDir, threads);
+        return ok ? 0 : 1;
+    }
+
+    // Compressed copy of a downloaded candle file, for backtests:
+    // CoinBaseBot compress <in.cbc> <out.cbz>
+    if (argc >= 4 && std::string(argv[1]) == "compress") {
+        return compressCandleFile(argv[2], argv[3]) ? 0 : 1;
+    }
+
+    // Shared market data for every bot on this host (bots then run with MARKET_BUS=<busName>):
+    // CoinBaseBot feed <BTC-USD,ETH-USD> [busName]
+    if (argc >= 3 && std::string(argv[1]) == "feed") {
+        if (!keys.loadFromEnv(keyRps ? std::atof(keyRps) : 30.0)) {
+            return 1;
+        }
+        return runMarketFeed(keys, splitProductList(argv[2]), argc > 3 ? argv[3] : "coinbasebot-md");
+    }
+
+    // REST transport comparison: CoinBaseBot bench-http [requests] [url]
+    if (argc >= 2 && std::string(argv[1]) == "bench-http") {
+        int requests = argc > 2 ? std::atoi(argv[2]) : 200;
+        std::string url = argc > 3 ? argv[3] : "https://api.coinbase.com/api/v3/brokerage/time";
+        benchHttpTransport(HttpTransport::Curl, url, requests);
+#ifdef COINBASEBOT_BEAST_HTTP
+        benchHttpTransport(HttpTransport::Beast, url, requests);
+#endif
+        return 0;
+    }
+
+#ifdef COINBASEBOT_ASYNC_CLIENT
+    // Coroutine client: CoinBaseBot scan <BTC-USD,ETH-USD,...>
+    if (argc >= 3 && std::string(argv[1]) == "scan") {
+        if (!keys.loadFromEnv(keyRps ? std::atof(keyRps) : 30.0)) {
+            return 1;
+        }
+        syncExchangeClock();
+        EventLoop loop;
+        loop.runUntilComplete(scanProductsAsync(loop, keys, splitProductList(argv[2])));
+        return 0;
+    }
+#endif
+
+    // What are you trading
+    if (!keys.loadFromEnv(keyRps ? std::atof(keyRps) : 30.0)) {
+        return 1;
+    }
+    // ORDER_PORTFOLIO picks the key orders go out on (matched against KEY_PORTFOLIO[_n])
+    const char* orderPortfolio = std::getenv("ORDER_PORTFOLIO");
+    auto ctx = std::make_unique<BotContext>();
+    ctx->keys = &keys;
+    ctx->orderKey = keys.orderKey(orderPortfolio ? orderPortfolio : "");
+    if (!ctx->orderKey) {
+        std::cerr << "[ERROR] ORDER_PORTFOLIO=" << orderPortfolio << " matches no KEY_PORTFOLIO[_n].\n";
+        return 1;
+    }
+    if (keys.size() > 1) {
+        std::cout << "[KEYS] " << keys.size() << " API keys; orders on " << ctx->orderKey->keyName << "\n";
+    }
+    ctx->productId = "BTC-USD";
+
+    // Pre-trade risk limits, loaded once; every order is checked before it is sent
+    RiskLimits limits;
+    ctx->productSlot = ctx->risk.addProduct(ctx->productId, limits);
+    if (ctx->productSlot < 0) {
+        return 1;
+    }
+
+    // CAPTURE_FILE=run.cbrl records every REST exchange and level2/user channel message.
+    // REPLAY_FILE=run.cbrl serves them back instead of the network (REPLAY_SPEED=max skips the waits).
+    if (const char* replayFile = std::getenv("REPLAY_FILE")) {
+        const char* speed = std::getenv("REPLAY_SPEED");
+        bool fast = speed && std::string(speed) == "max";
+        g_replayer = std::make_unique<EventReplayer>();
+        if (!g_replayer->open(replayFile, fast ? ReplaySpeed::AsFastAsPossible : ReplaySpeed::Original)) {
+            return 1;
+        }
+    } else if (const char* captureFile = std::getenv("CAPTURE_FILE")) {
+        g_recorder = std::make_unique<EventRecorder>();
+        if (!g_recorder->open(captureFile)) {
+            return 1;
+        }
+    }
+
+    // PAPER_TRADING=1: live market data, simulated post-only order matching (nothing is sent)
+    const char* paperTrading = std::getenv("PAPER_TRADING");
+    if (paperTrading && std::string(paperTrading) == "1" && !g_replayer) {
+        g_paper = std::make_unique<PaperExchange>();
+        BotContext* c = ctx.get();
+        // Runs on the level2 thread only (deliverEvents() in its message handler)
+        g_paper->setOrderCallback([c](const UserOrderEvent& e) {
+            OrderUpdate u = statusUpdate(ClientOrderId::from(e.clientOrderId), e.status,
+                                         e.cumulativeBase, e.cumulativeQuote, monotonicNanos());
+            pushOrWait(*c, c->streamUpdates, u);
+        });
+        std::cout << "[PAPER] Paper trading: orders are matched locally against the live book\n";
+    }
+
+    // Optional Prometheus endpoint: METRICS_PORT=9100 serves http://127.0.0.1:9100/metrics
+    std::unique_ptr<MetricsServer> metricsServer;
+    if (const char* metricsPort = std::getenv("METRICS_PORT")) {
+        try {
+            metricsServer = std::make_unique<MetricsServer>("127.0.0.1", static_cast<unsigned short>(std::atoi(metricsPort)));
+            metricsServer->start();
+            std::cout << "[INFO] Metrics listening on 127.0.0.1:" << metricsPort << "/metrics\n";
+        } catch (const std::exception& e) {
+            std::cerr << "[ERROR] Could not start metrics listener: " << e.what() << std::endl;
+        }
+    }
+
+    // Measure the exchange clock before the first candle window / JWT is computed
+    for (int i = 0; i < 3; i++) {
+        syncExchangeClock();
+    }
+    std::cout << "[CLOCK] exchange offset=" << exchangeClock().offsetNanos() / 1000
+              << "us, rtt=" << exchangeClock().rttNanos() / 1000 << "us\n";
+
+    // HEDGE_GETS=1 sends a duplicate candle request when the first is slower than p95
+    // CANDLE_TIMEOUT_MS bounds both candle requests of one tick (default 5000)
+    const char* hedgeGets = std::getenv("HEDGE_GETS");
+    ctx->hedgeGets = hedgeGets && std::string(hedgeGets) == "1";
+    if (const char* candleTimeout = std::getenv("CANDLE_TIMEOUT_MS")) {
+        ctx->candleTimeoutNanos = std::atoll(candleTimeout) * 1'000'000LL;
+    }
+
+    // Fills stream in over the user channel (USER_CHANNEL=0 disables it); REST polling
+    // then only acts as a slow safety net. A replay uses it when the capture recorded it.
+    const char* userChannelEnv = std::getenv("USER_CHANNEL");
+    bool useUserChannel = (g_replayer ? g_replayer->hasUserEvents() : !g_paper)
+                          && !(userChannelEnv && std::string(userChannelEnv) == "0");
+    if (useUserChannel || g_paper) {
+        ctx->orderPollNanos = 60'000'000'000LL;
+    }
+    // Strategy state journal: JOURNAL_FILE=path, JOURNAL_FSYNC=always|interval|never, JOURNAL_FSYNC_MS
+    StateJournal journal;
+    const char* journalFile = std::getenv("JOURNAL_FILE");
+    if (journalFile && !g_replayer) {
+        JournalSyncPolicy policy = JournalSyncPolicy::Interval;
+        if (const char* fsync = std::getenv("JOURNAL_FSYNC")) {
+            std::string mode(fsync);
+            policy = mode == "always" ? JournalSyncPolicy::Always
+                   : mode == "never" ? JournalSyncPolicy::Never : JournalSyncPolicy::Interval;
+        }
+        const char* fsyncMs = std::getenv("JOURNAL_FSYNC_MS");
+        int64_t intervalNanos = (fsyncMs ? std::atoll(fsyncMs) : 1000) * 1'000'000LL;
+        int64_t openStart = monotonicNanos();
+        if (journal.open(journalFile, policy, intervalNanos)) {
+            ctx->journal = &journal;
+            std::cout << "[JOURNAL] " << journalFile << ": " << journal.recovered().records << " records recovered in "
+                      << (monotonicNanos() - openStart) / 1000 << "us\n";
+        }
+    }
+
+    // Place at the real top of book from a local level2 book (ORDER_BOOK=0 disables it).
+    // A replay uses it when the capture recorded level2 messages.
+    const char* orderBookEnv = std::getenv("ORDER_BOOK");
+    ctx->useOrderBook = (!g_replayer || g_replayer->hasMarketEvents())
+                        && !(orderBookEnv && std::string(orderBookEnv) == "0");
+    if (g_paper && !ctx->useOrderBook) {
+        std::cerr << "[WARN] PAPER_TRADING needs the level2 book; ignoring ORDER_BOOK=0\n";
+        ctx->useOrderBook = true;
+    }
+
+    // MARKET_CAPTURE_FILE=trades.cbz records every public trade in the compressed capture
+    // format (appends across restarts). Trades arrive on the level2 connection.
+    std::unique_ptr<CaptureWriter> tradeCapture;
+    if (const char* marketCapture = std::getenv("MARKET_CAPTURE_FILE"); marketCapture && !g_replayer) {
+        tradeCapture = std::make_unique<CaptureWriter>();
+        if (!tradeCapture->open(marketCapture, CaptureKind::Trades, ctx->productId)) {
+            return 1;
+        }
+        tradeCapture->setMaxBlockSpan(60'000'000'000LL); // Write at least once a minute
+        if (!ctx->useOrderBook) {
+            std::cerr << "[WARN] MARKET_CAPTURE_FILE needs the level2 connection; ignoring ORDER_BOOK=0\n";
+            ctx->useOrderBook = true;
+        }
+        std::cout << "[INFO] Capturing public trades to " << marketCapture << "\n";
+    }
+    // MARKET_BUS=coinbasebot-md: candles and quotes from a `CoinBaseBot feed` process on this
+    // host instead of our own polling and level2 connection (BUS_BUSY_POLL=1 spins on the bus)
+    MarketBusSubscriber bus;
+    if (const char* busName = std::getenv("MARKET_BUS"); busName && !g_replayer) {
+        ctx->bus = &bus;
+        ctx->busName = busName;
+        const char* busBusyPoll = std::getenv("BUS_BUSY_POLL");
+        ctx->busWait = (busBusyPoll && std::string(busBusyPoll) == "1") ? WaitStrategy::BusyPoll : WaitStrategy::Sleep;
+        if (!bus.attach(busName)) {
+            std::cerr << "[WARN] Market bus " << busName << " is not up yet; waiting for the feed\n";
+        } else if (bus.productIndex(ctx->productId) < 0) {
+            std::cerr << "[ERROR] Market bus " << busName << " does not carry " << ctx->productId << "\n";
+            return 1;
+        }
+        std::cout << "[BUS] Market data from bus " << busName << "\n";
+    }
+    // Paper trading and trade capture need the raw level2/market_trades messages, so they
+    // keep a connection of their own; its book then owns ctx->topOfBook
+    const bool ownLevel2 = ctx->useOrderBook && (!ctx->bus || g_paper || tradeCapture);
+    ctx->busQuotes = ctx->bus && ctx->useOrderBook && !ownLevel2;
+
+    const char* cancelOnExit = std::getenv("CANCEL_ON_EXIT");
+    ctx->cancelOnExit = (cancelOnExit && std::string(cancelOnExit) == "1");
+    if (const char* repriceBps = std::getenv("REPRICE_BPS")) {
+        ctx->repriceThreshold = std::atof(repriceBps) / 10'000.0;
+    }
+    if (const char* pollSeconds = std::getenv("ORDER_POLL_SECONDS")) {
+        ctx->orderPollNanos = std::atoll(pollSeconds) * 1'000'000'000LL;
+    }
+
+    // Ctrl-C / SIGTERM stop the loops instead of killing the process, so the gateway
+    // still gets to cancel resting orders (CANCEL_ON_EXIT) and the journal is left consistent
+    std::signal(SIGINT, onStopSignal);
+    std::signal(SIGTERM, onStopSignal);
+
+    // Threading model
+    const char* busyPoll = std::getenv("STRATEGY_BUSY_POLL");
+    ctx->strategyWait = (busyPoll && std::string(busyPoll) == "1") ? WaitStrategy::BusyPoll : WaitStrategy::Sleep;
+
+    std::vector<std::thread> threads;
+    threads.push_back(startPinnedThread("market-data", coreFromEnv("PIN_MD_CORE"), [&ctx] {
+        if (ctx->bus) {
+            busMarketDataLoop(*ctx);
+        } else {
+            marketDataLoop(*ctx);
+        }
+    }));
+    threads.push_back(startPinnedThread("strategy", coreFromEnv("PIN_STRATEGY_CORE"), [&ctx] { strategyLoop(*ctx); }));
+    threads.push_back(startPinnedThread("order-gateway", coreFromEnv("PIN_GATEWAY_CORE"), [&ctx] { orderGatewayLoop(*ctx); }));
+    threads.push_back(startPinnedThread("housekeeping", coreFromEnv("PIN_HOUSEKEEPING_CORE"), [&ctx] { housekeepingLoop(*ctx); }));
+
+    std::unique_ptr<UserChannelClient> userChannel;
+    std::thread userChannelThread;
+    if (useUserChannel) {
+        BotContext* c = ctx.get();
+        userChannel = std::make_unique<UserChannelClient>(
+                std::vector<std::string>{c->productId},
+                [c] { return create_ws_jwt(c->orderKey->keyName, c->orderKey->privateKeyPem); },
+                [c](const UserOrderEvent& e) {
+                    OrderUpdate u = statusUpdate(ClientOrderId::from(e.clientOrderId), e.status,
+                                                 e.cumulativeBase, e.cumulativeQuote, monotonicNanos());
+                    pushOrWait(*c, c->streamUpdates, u);
+                });
+        if (g_recorder) {
+            userChannel->setRawCallback([](const std::string& msg) { g_recorder->recordUserEvent(msg); });
+        }
+        if (!g_replayer) {
+            userChannelThread = startPinnedThread("user-channel", coreFromEnv("PIN_USER_WS_CORE"),
+                                                  [&userChannel] { userChannel->run(); });
+        }
+    }
+
+    // Local L2 book from the level2 channel (plus public trades when paper trading or capturing)
+    Level2Feed level2;
+    std::unique_ptr<CoinbaseWsClient> level2Channel;
+    std::thread level2Thread;
+    CoinbaseWsClient::MessageCallback onLevel2Message;
+    if (ownLevel2) {
+        level2.addProduct(ctx->productId, &ctx->topOfBook);
+        std::vector<std::string> channels{"level2", "heartbeats"};
+        if (g_paper || tradeCapture) {
+            channels.push_back("market_trades");
+        }
+        const std::string productId = ctx->productId;
+        onLevel2Message = [&level2, &tradeCapture, productId](const std::string& msg) {
+            if (g_recorder) {
+                g_recorder->recordMarketEvent(msg);
+            }
+            if (!level2.onMessage(msg, monotonicNanos())) {
+                std::cerr << "[BOOK] Sequence gap, resubscribing\n";
+                metrics().bookResyncs.inc();
+                return false;
+            }
+            const bool trades = msg.find("\"market_trades\"") != std::string::npos;
+            if (trades && tradeCapture) {
+                captureMarketTrades(*tradeCapture, msg);
+            }
+            if (g_paper) {
+                if (trades) {
+                    g_paper->onMarketMessage(msg);
+                } else if (const OrderBook* book = level2.book(productId); book && book->valid) {
+                    g_paper->onBook(productId, *book);
+                }
+                // Fills from above plus OPEN/CANCELLED from the gateway thread: this
+                // thread is the only producer of paper events on streamUpdates
+                g_paper->deliverEvents();
+            }
+            return true;
+        };
+        if (!g_replayer) {
+            level2Channel = std::make_unique<CoinbaseWsClient>(
+                    "advanced-trade-ws.coinbase.com",
+                    channels,
+                    std::vector<std::string>{ctx->productId},
+                    nullptr, // Market data needs no JWT
+                    onLevel2Message);
+            level2Channel->setOnConnect([&level2] { level2.reset(); });
+            level2Thread = startPinnedThread("level2", coreFromEnv("PIN_L2_CORE"),
+                                             [&level2Channel] { level2Channel->run(); });
+        }
+    }
+
+    // Replay: the recorded level2 and user channel messages stand in for both connections
+    std::thread replayThread;
+    if (g_replayer) {
+        replayThread = startPinnedThread("replay-events", -1, [&onLevel2Message, &userChannel] {
+            g_replayer->replayEvents([&](const EventReplayer::Record& r) {
+                if (r.type == ReplayRecordType::UserEvent) {
+                    if (userChannel) {
+                        userChannel->onMessage(r.payload);
+                    }
+                } else if (onLevel2Message) {
+                    onLevel2Message(r.payload); // A gap resyncs on the recorded resubscribe
+                }
+            });
+        });
+    }
+
+    for (auto& t : threads) {
+        t.join();
+    }
+    if (replayThread.joinable()) {
+        g_replayer->stop();
+        replayThread.join();
+    }
+    if (level2Channel) {
+        level2Channel->stop();
+        level2Thread.join();
+    }
+    if (tradeCapture) {
+        tradeCapture->close();
+    }
+    if (userChannelThread.joinable()) {
+        userChannel->stop();
+        userChannelThread.join();
+    }
+    if (g_recorder) {
+        g_recorder->close();
     }
 
     return 0;
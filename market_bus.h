@@ -0,0 +1,388 @@
+// market_bus.h
+#ifndef MARKET_BUS_H
+#define MARKET_BUS_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//------------------------------------------
+// SHARED-MEMORY MARKET DATA BUS
+//------------------------------------------
+// One feed process (`CoinBaseBot feed`) owns the exchange connections and publishes
+// normalized events into a POSIX shared-memory ring; any number of bot processes on the
+// same host map it read-only and follow it with their own cursor. Subscribers never write
+// to the segment, so adding one costs the feed nothing and readers do not contend with
+// each other.
+//
+// Segment layout: MarketBusHeader, then `capacity` 64-byte slots. Event n lives in slot
+// n % capacity, guarded by that slot's sequence (a per-slot seqlock):
+//   2n + 1   the publisher is writing event n
+//   2n + 2   event n is complete
+// A reader waiting for event n that sees a smaller sequence has nothing new yet; a larger
+// one means the ring lapped it and the events in between are lost. The reader then skips
+// ahead to half a ring behind the publisher and counts the gap in lost().
+
+enum class BusEventType : uint8_t {
+    Quote = 1,    // v: bid, bidSize, ask, askSize; time: publisher's monotonic clock
+    Trade = 2,    // v: price, size; side: +1 buy / -1 sell; time: exchange time (epoch ns)
+    Bar = 3,      // v: open, high, low, close, volume; time: candle start (epoch ns)
+    BarsDone = 4  // Every bar of one refresh for `product` has been published (none if a fetch failed)
+};
+
+struct BusEvent {
+    BusEventType type = BusEventType::Quote;
+    int8_t side = 0;
+    uint16_t product = 0;             // Index into the bus product table
+    uint32_t granularitySeconds = 0;  // Bar
+    int64_t timeNanos = 0;
+    double v[5] = {};
+};
+static_assert(sizeof(BusEvent) == 56, "BusEvent must fill a slot after its sequence word");
+
+namespace market_bus_detail {
+
+constexpr uint32_t kMagic = 0x3142424D; // "MBB1"
+constexpr uint32_t kVersion = 1;
+constexpr size_t kMaxProducts = 64;
+constexpr size_t kProductIdBytes = 32;
+constexpr size_t kEventWords = sizeof(BusEvent) / sizeof(uint64_t);
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "bus atomics must be address-free");
+
+// Fields are relaxed atomics (as in TopOfBookCell) so a torn read is never undefined behaviour
+struct alignas(64) Slot {
+    std::atomic<uint64_t> seq;
+    std::atomic<uint64_t> words[kEventWords];
+};
+static_assert(sizeof(Slot) == 64, "one slot per cache line");
+
+struct MarketBusHeader {
+    std::atomic<uint32_t> magic;     // Stored last (release): the segment is initialised
+    uint32_t version;
+    uint32_t capacity;               // Slots; a power of two
+    uint32_t productCount;
+    int64_t createdNanos;            // Publisher's monotonic clock at creation
+    char products[kMaxProducts][kProductIdBytes];
+
+    alignas(64) std::atomic<uint64_t> published;      // Events completed so far
+    alignas(64) std::atomic<int64_t> heartbeatNanos;  // Publisher's monotonic clock
+};
+
+inline size_t segmentBytes(uint32_t capacity)
+{
+    return (sizeof(MarketBusHeader) + 63) / 64 * 64 + static_cast<size_t>(capacity) * sizeof(Slot);
+}
+
+inline Slot* slots(void* base)
+{
+    return reinterpret_cast<Slot*>(static_cast<char*>(base) + (sizeof(MarketBusHeader) + 63) / 64 * 64);
+}
+
+// shm_open wants "/name"
+inline std::string shmName(const std::string& name)
+{
+    return !name.empty() && name[0] == '/' ? name : "/" + name;
+}
+
+} // namespace market_bus_detail
+
+//------------------------------------------
+// PUBLISHER (FEED PROCESS)
+//------------------------------------------
+class MarketBusPublisher {
+public:
+    static constexpr uint32_t kDefaultCapacity = 1 << 16;  // 4 MiB of slots
+
+    MarketBusPublisher() = default;
+    MarketBusPublisher(const MarketBusPublisher&) = delete;
+    MarketBusPublisher& operator=(const MarketBusPublisher&) = delete;
+    ~MarketBusPublisher() { close(); }
+
+    // Replaces any bus of the same name. Subscribers still attached to the old segment see
+    // its heartbeat stop and re-attach.
+    bool create(const std::string& name, const std::vector<std::string>& productIds, int64_t nowNanos,
+                uint32_t capacity = kDefaultCapacity)
+    {
+        using namespace market_bus_detail;
+#if !defined(_WIN32)
+        close();
+        if (capacity < 64 || (capacity & (capacity - 1)) != 0) {
+            std::cerr << "[ERROR] Market bus capacity must be a power of two >= 64\n";
+            return false;
+        }
+        if (productIds.size() > kMaxProducts) {
+            std::cerr << "[ERROR] Market bus holds at most " << kMaxProducts << " products\n";
+            return false;
+        }
+        name_ = shmName(name);
+        ::shm_unlink(name_.c_str());
+        int fd = ::shm_open(name_.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+        if (fd < 0) {
+            std::cerr << "[ERROR] Cannot create market bus " << name_ << "\n";
+            return false;
+        }
+        bytes_ = segmentBytes(capacity);
+        void* base = MAP_FAILED;
+        if (::ftruncate(fd, static_cast<off_t>(bytes_)) == 0) {
+            base = ::mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        ::close(fd);
+        if (base == MAP_FAILED) {
+            std::cerr << "[ERROR] Cannot map market bus " << name_ << "\n";
+            ::shm_unlink(name_.c_str());
+            return false;
+        }
+        base_ = base;
+
+        // ftruncate zero-fills, so every slot sequence starts at 0 (nothing published)
+        header_ = static_cast<MarketBusHeader*>(base_);
+        header_->version = kVersion;
+        header_->capacity = capacity;
+        header_->productCount = static_cast<uint32_t>(productIds.size());
+        header_->createdNanos = nowNanos;
+        for (size_t i = 0; i < productIds.size(); i++) {
+            std::strncpy(header_->products[i], productIds[i].c_str(), kProductIdBytes - 1);
+        }
+        header_->published.store(0, std::memory_order_relaxed);
+        header_->heartbeatNanos.store(nowNanos, std::memory_order_relaxed);
+        header_->magic.store(kMagic, std::memory_order_release);
+        slots_ = slots(base_);
+        mask_ = capacity - 1;
+        next_ = 0;
+        return true;
+#else
+        (void)name; (void)productIds; (void)nowNanos; (void)capacity;
+        std::cerr << "[ERROR] The market bus needs POSIX shared memory\n";
+        return false;
+#endif
+    }
+
+    bool isOpen() const { return base_ != nullptr; }
+
+    // Product index for events, or -1 when the product is not on the bus
+    int productIndex(std::string_view productId) const
+    {
+        for (uint32_t i = 0; header_ && i < header_->productCount; i++) {
+            if (productId == header_->products[i]) {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+    // Safe from several threads of the feed process; the lock is process-local and only
+    // ever contended by the feed's own threads
+    void publish(const BusEvent& e)
+    {
+        using namespace market_bus_detail;
+        uint64_t words[kEventWords];
+        std::memcpy(words, &e, sizeof(words));
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint64_t n = next_++;
+        Slot& slot = slots_[n & mask_];
+        slot.seq.store(2 * n + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t w = 0; w < kEventWords; w++) {
+            slot.words[w].store(words[w], std::memory_order_relaxed);
+        }
+        slot.seq.store(2 * n + 2, std::memory_order_release);
+        header_->published.store(n + 1, std::memory_order_release);
+    }
+
+    // Subscribers treat a bus whose heartbeat stops as dead
+    void heartbeat(int64_t nowNanos)
+    {
+        header_->heartbeatNanos.store(nowNanos, std::memory_order_relaxed);
+    }
+
+    uint64_t published() const { return header_ ? header_->published.load(std::memory_order_relaxed) : 0; }
+
+    // Unlinks the name; attached subscribers keep their mapping until they detach
+    void close()
+    {
+#if !defined(_WIN32)
+        if (base_) {
+            header_->heartbeatNanos.store(0, std::memory_order_relaxed);
+            ::munmap(base_, bytes_);
+            ::shm_unlink(name_.c_str());
+        }
+#endif
+        base_ = nullptr;
+        header_ = nullptr;
+        slots_ = nullptr;
+    }
+
+private:
+    std::string name_;
+    void* base_ = nullptr;
+    size_t bytes_ = 0;
+    market_bus_detail::MarketBusHeader* header_ = nullptr;
+    market_bus_detail::Slot* slots_ = nullptr;
+    uint64_t mask_ = 0;
+    uint64_t next_ = 0;
+    std::mutex mutex_;
+};
+
+//------------------------------------------
+// SUBSCRIBER (STRATEGY PROCESSES)
+//------------------------------------------
+// Single-threaded: one cursor per subscriber. Events are copied out of the slot into the
+// caller's BusEvent (56 bytes); nothing on the read path allocates or takes a lock.
+class MarketBusSubscriber {
+public:
+    enum class Start : uint8_t { Latest, Oldest };
+
+    MarketBusSubscriber() = default;
+    MarketBusSubscriber(const MarketBusSubscriber&) = delete;
+    MarketBusSubscriber& operator=(const MarketBusSubscriber&) = delete;
+    ~MarketBusSubscriber() { detach(); }
+
+    // Fails (quietly) while no feed has created the bus yet
+    bool attach(const std::string& name, Start start = Start::Latest)
+    {
+        using namespace market_bus_detail;
+#if !defined(_WIN32)
+        detach();
+        std::string shm = shmName(name);
+        int fd = ::shm_open(shm.c_str(), O_RDONLY, 0);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st {};
+        void* base = MAP_FAILED;
+        if (::fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(MarketBusHeader)) {
+            bytes_ = static_cast<size_t>(st.st_size);
+            base = ::mmap(nullptr, bytes_, PROT_READ, MAP_SHARED, fd, 0);
+        }
+        ::close(fd);
+        if (base == MAP_FAILED) {
+            return false;
+        }
+        base_ = base;
+        header_ = static_cast<const MarketBusHeader*>(base_);
+        if (header_->magic.load(std::memory_order_acquire) != kMagic || header_->version != kVersion
+            || segmentBytes(header_->capacity) > bytes_) {
+            detach(); // Still being created, or from an incompatible build
+            return false;
+        }
+        slots_ = slots(const_cast<void*>(base_));
+        mask_ = header_->capacity - 1;
+        uint64_t published = header_->published.load(std::memory_order_acquire);
+        uint64_t capacity = header_->capacity;
+        cursor_ = start == Start::Latest ? published : (published > capacity / 2 ? published - capacity / 2 : 0);
+        return true;
+#else
+        (void)name; (void)start;
+        return false;
+#endif
+    }
+
+    bool isAttached() const { return base_ != nullptr; }
+
+    // Copies the next event into `out`; false when the subscriber is caught up
+    bool poll(BusEvent& out)
+    {
+        using namespace market_bus_detail;
+        for (;;) {
+            const Slot& slot = slots_[cursor_ & mask_];
+            const uint64_t expected = 2 * cursor_ + 2;
+            uint64_t s1 = slot.seq.load(std::memory_order_acquire);
+            if (s1 == expected) {
+                uint64_t words[kEventWords];
+                for (size_t w = 0; w < kEventWords; w++) {
+                    words[w] = slot.words[w].load(std::memory_order_relaxed);
+                }
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot.seq.load(std::memory_order_relaxed) == s1) {
+                    std::memcpy(&out, words, sizeof(words));
+                    cursor_++;
+                    return true;
+                }
+                // Overwritten while we copied: fall through to the overrun path
+            } else if (s1 < expected) {
+                return false; // Not published yet (or still being written)
+            }
+            skipAhead();
+        }
+    }
+
+    // Product index on this bus, or -1
+    int productIndex(std::string_view productId) const
+    {
+        for (uint32_t i = 0; header_ && i < header_->productCount; i++) {
+            if (productId == header_->products[i]) {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+    // The feed is alive if it has beaten within maxAgeNanos (same monotonic clock across
+    // processes on one host)
+    bool publisherAlive(int64_t nowNanos, int64_t maxAgeNanos) const
+    {
+        int64_t beat = header_ ? header_->heartbeatNanos.load(std::memory_order_relaxed) : 0;
+        return beat != 0 && nowNanos - beat < maxAgeNanos;
+    }
+
+    uint64_t lost() const { return lost_; }
+    uint64_t backlog() const
+    {
+        return header_ ? header_->published.load(std::memory_order_relaxed) - cursor_ : 0;
+    }
+
+    void detach()
+    {
+#if !defined(_WIN32)
+        if (base_) {
+            ::munmap(const_cast<void*>(base_), bytes_);
+        }
+#endif
+        base_ = nullptr;
+        header_ = nullptr;
+        slots_ = nullptr;
+    }
+
+private:
+    // Lapped by the publisher: resume half a ring behind it so the publisher does not
+    // immediately lap us again
+    void skipAhead()
+    {
+        uint64_t published = header_->published.load(std::memory_order_acquire);
+        uint64_t half = (mask_ + 1) / 2;
+        uint64_t resume = published > half ? published - half : 0;
+        if (resume > cursor_) {
+            lost_ += resume - cursor_;
+            cursor_ = resume;
+        } else {
+            // The slot is ahead of `published` (publisher mid-write of a later lap): the
+            // event we wanted is gone either way
+            lost_++;
+            cursor_++;
+        }
+    }
+
+    const void* base_ = nullptr;
+    size_t bytes_ = 0;
+    const market_bus_detail::MarketBusHeader* header_ = nullptr;
+    const market_bus_detail::Slot* slots_ = nullptr;
+    uint64_t mask_ = 0;
+    uint64_t cursor_ = 0;
+    uint64_t lost_ = 0;
+};
+
+#endif // MARKET_BUS_H
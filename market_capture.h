@@ -0,0 +1,1117 @@
+// market_capture.h
+#ifndef MARKET_CAPTURE_H
+#define MARKET_CAPTURE_H
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "candle_store.h"   // CandleColumns
+
+//------------------------------------------
+// COMPRESSED MARKET-DATA CAPTURE
+//------------------------------------------
+// Layout:
+//   CaptureFileHeader
+//   CaptureBlockHeader + column table + columns   (one block per blockRecords records)
+//   CaptureBlockHeader + column table + columns ...
+//   CaptureIndexEntry[blocks] + CaptureFooter   (written by close())
+//
+// A record is a timestamp plus `columns` doubles:
+//   Bars:   candle start (epoch seconds); open, high, low, close, volume
+//   Trades: trade time (epoch nanos);    price, size, side (+1 buy, -1 sell)
+//
+// Each block stores its columns one after another, each as four bit streams over
+// consecutive quarters of the block (so a decoder can run them side by side):
+//   time:    delta-of-delta, zigzagged into prefix buckets ('0' = same spacing as before),
+//            after dividing out the largest power of ten shared by the block's timestamps
+//   doubles: whichever is smaller of
+//            - XOR with the previous value (Gorilla): '0' = repeat, else the meaningful bits
+//              between the leading and trailing zeros, reusing the previous window if it fits
+//            - decimal: exact integer mantissa at 10^-scale (prices on a tick grid, sizes on
+//              a lot grid), deltas in the same prefix buckets. Only used if every value in the
+//              block round-trips bit for bit.
+// Both codecs are lossless. The footer index gives each block's time range and offset, so
+// a reader seeks straight to the blocks it needs; a file without one (the writer died) is
+// indexed by scanning the block headers, and a torn block at the tail is dropped on reopen.
+
+enum class CaptureKind : uint32_t { Bars = 1, Trades = 2 };
+
+inline uint32_t captureColumnCount(CaptureKind kind) { return kind == CaptureKind::Bars ? 5 : 3; }
+
+struct CaptureFileHeader {
+    char magic[4] = {'C', 'B', 'Z', '1'};
+    uint32_t version = 1;
+    uint32_t kind = 0;                 // CaptureKind
+    uint32_t columns = 0;
+    int64_t granularitySeconds = 0;    // Bars only
+    char productId[32] = {};
+};
+
+struct CaptureBlockHeader {
+    uint32_t magic = 0x314B425A;       // "ZBK1"
+    uint32_t count = 0;
+    uint32_t payloadWords = 0;
+    uint32_t reserved = 0;
+    int64_t firstTime = 0;
+    int64_t lastTime = 0;
+    uint64_t checksum = 0;             // captureChecksum over the column table
+};
+
+// Column table at the start of the payload, one entry per column (time first). Columns
+// carry their own checksums so a reader can fetch and verify just the ones it decodes.
+struct CaptureColumnHeader {
+    uint8_t codec = 0;                 // CaptureCodec
+    uint8_t scale = 0;                 // Power of ten: time divisor / decimal places
+    uint16_t reserved = 0;
+    uint32_t words = 0;                // Whole column
+    uint32_t segmentWords[4] = {};     // Each of its capture_detail::kSegments streams
+    uint64_t checksum = 0;             // captureChecksum over the column's words
+};
+
+struct CaptureIndexEntry {
+    uint64_t offset = 0;               // Of the block header
+    int64_t firstTime = 0;
+    int64_t lastTime = 0;
+    uint32_t count = 0;
+    uint32_t payloadWords = 0;
+};
+
+struct CaptureFooter {
+    uint64_t indexOffset = 0;
+    uint32_t blocks = 0;
+    uint32_t magic = 0x3158495A;       // "ZIX1"
+};
+
+enum class CaptureCodec : uint8_t { DeltaOfDelta = 0, Xor = 1, Decimal = 2 };
+
+// Decoded block(s): time plus one vector per column
+struct CaptureColumns {
+    std::vector<int64_t> time;
+    std::vector<std::vector<double>> values;
+
+    size_t size() const { return time.size(); }
+
+    void clear()
+    {
+        time.clear();
+        for (auto& v : values) {
+            v.clear();
+        }
+    }
+};
+
+namespace capture_detail {
+    constexpr size_t kReadPadWords = 4;   // Zero words after each payload: a bad stream can't read past the buffer
+
+    constexpr double kPow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+    constexpr int64_t kPow10Int[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+    constexpr unsigned kMaxScale = 9;
+
+    // 64-bit FNV-1a over whole words: one multiply per 8 bytes, so checking a block costs
+    // a fraction of decoding it
+    inline uint64_t captureChecksum(const uint64_t* words, size_t count)
+    {
+        uint64_t hash = 14695981039346656037ULL;
+        for (size_t i = 0; i < count; i++) {
+            hash ^= words[i];
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    // MSB-first bit stream. Stored as big-endian bytes, so a reader can fetch the bits at
+    // any position with one unaligned load.
+    class BitWriter {
+    public:
+        void clear()
+        {
+            words_.clear();
+            bits_ = 0;
+        }
+
+        // Low n bits of value, 1 <= n <= 64
+        void write(uint64_t value, unsigned n)
+        {
+            if (n < 64) {
+                value &= (1ULL << n) - 1;
+            }
+            unsigned off = bits_ & 63;
+            if (off == 0) {
+                words_.push_back(0);
+            }
+            words_.back() |= (value << (64 - n)) >> off;
+            if (off + n > 64) {
+                words_.push_back(value << (128 - off - n));
+            }
+            bits_ += n;
+        }
+
+        size_t wordCount() const { return words_.size(); }
+
+        void appendTo(std::vector<uint64_t>& out) const
+        {
+            for (uint64_t w : words_) {
+                out.push_back(__builtin_bswap64(w));
+            }
+        }
+
+    private:
+        std::vector<uint64_t> words_;
+        uint64_t bits_ = 0;
+    };
+
+    class BitReader {
+    public:
+        BitReader() = default;
+        BitReader(const uint64_t* words, size_t count)
+            : bytes_(reinterpret_cast<const unsigned char*>(words)), limit_(static_cast<uint64_t>(count) * 64) {}
+
+        // The next 57 or more bits, MSB-aligned, without consuming them
+        uint64_t peek() const
+        {
+            uint64_t v;
+            std::memcpy(&v, bytes_ + (pos_ >> 3), sizeof(v));
+            return __builtin_bswap64(v) << (pos_ & 7);
+        }
+
+        void skip(unsigned n) { pos_ += n; }
+
+        // 1 <= n <= 56
+        uint64_t read(unsigned n)
+        {
+            uint64_t v = peek() >> (64 - n);
+            pos_ += n;
+            return v;
+        }
+
+        // 1 <= n <= 64
+        uint64_t readWide(unsigned n)
+        {
+            if (n <= 56) {
+                return read(n);
+            }
+            uint64_t hi = read(n - 32);
+            return (hi << 32) | read(32);
+        }
+
+        bool overrun() const { return pos_ > limit_; }
+
+    private:
+        const unsigned char* bytes_ = nullptr;
+        uint64_t limit_ = 0;
+        uint64_t pos_ = 0;
+    };
+
+    inline uint64_t zigzag(uint64_t v) { return (v << 1) ^ static_cast<uint64_t>(static_cast<int64_t>(v) >> 63); }
+    inline uint64_t unzigzag(uint64_t z) { return (z >> 1) ^ (0 - (z & 1)); }
+
+    // '0' | '10'+7 | '110'+12 | '1110'+20 | '11110'+32 | '11111'+64
+    inline void writeBucketed(BitWriter& w, uint64_t z)
+    {
+        if (z == 0) {
+            w.write(0, 1);
+        } else if (z < (1ULL << 7)) {
+            w.write((0x2ULL << 7) | z, 9);
+        } else if (z < (1ULL << 12)) {
+            w.write((0x6ULL << 12) | z, 15);
+        } else if (z < (1ULL << 20)) {
+            w.write((0xEULL << 20) | z, 24);
+        } else if (z < (1ULL << 32)) {
+            w.write((0x1EULL << 32) | z, 37);
+        } else {
+            w.write(0x1F, 5);
+            w.write(z, 64);
+        }
+    }
+
+    // One peek decodes the prefix and the value. Zero (regular timestamps, repeated prices)
+    // gets its own branch, which predicts well on such runs; the other buckets are decoded
+    // without branching, since which one comes next is data-dependent and would mispredict.
+    // Only the rare 64-bit bucket takes a second branch.
+    inline uint64_t readBucketed(BitReader& r)
+    {
+        constexpr uint64_t kWidths = (7ULL << 8) | (12ULL << 16) | (20ULL << 24) | (32ULL << 32);
+        uint64_t win = r.peek();
+        if (!(win >> 63)) {
+            r.skip(1);
+            return 0;
+        }
+        unsigned ones = static_cast<unsigned>(__builtin_clzll(~win | (1ULL << 58)));   // 1..5
+        if (ones == 5) {
+            r.skip(5);
+            return r.readWide(64);
+        }
+        unsigned width = static_cast<unsigned>(kWidths >> (ones * 8)) & 0xFF;
+        r.skip(ones + 1 + width);
+        return (win << (ones + 1)) >> (64 - width);
+    }
+
+    // Delta-of-delta over integers (wrapping, so any input round-trips)
+    inline void encodeDeltas(const int64_t* v, size_t n, BitWriter& w)
+    {
+        w.write(static_cast<uint64_t>(v[0]), 64);
+        uint64_t prevDelta = 0;
+        for (size_t i = 1; i < n; i++) {
+            uint64_t delta = static_cast<uint64_t>(v[i]) - static_cast<uint64_t>(v[i - 1]);
+            writeBucketed(w, zigzag(delta - prevDelta));
+            prevDelta = delta;
+        }
+    }
+
+    // First-order deltas (prices and sizes wander; their spacing isn't regular)
+    inline void encodeFirstDeltas(const int64_t* v, size_t n, BitWriter& w)
+    {
+        w.write(static_cast<uint64_t>(v[0]), 64);
+        for (size_t i = 1; i < n; i++) {
+            writeBucketed(w, zigzag(static_cast<uint64_t>(v[i]) - static_cast<uint64_t>(v[i - 1])));
+        }
+    }
+
+    inline void encodeXor(const double* v, size_t n, BitWriter& w)
+    {
+        uint64_t prev;
+        std::memcpy(&prev, &v[0], sizeof(prev));
+        w.write(prev, 64);
+        unsigned prevLead = 64;   // No window yet
+        unsigned prevTrail = 0;
+        for (size_t i = 1; i < n; i++) {
+            uint64_t cur;
+            std::memcpy(&cur, &v[i], sizeof(cur));
+            uint64_t x = cur ^ prev;
+            prev = cur;
+            if (x == 0) {
+                w.write(0, 1);
+                continue;
+            }
+            unsigned lead = static_cast<unsigned>(__builtin_clzll(x));
+            unsigned trail = static_cast<unsigned>(__builtin_ctzll(x));
+            if (prevLead != 64 && lead >= prevLead && trail >= prevTrail) {
+                w.write(0x2, 2);
+                w.write(x >> prevTrail, 64 - prevLead - prevTrail);
+            } else {
+                unsigned len = 64 - lead - trail;
+                w.write((0x3ULL << 12) | (lead << 6) | (len - 1), 14);
+                w.write(x >> trail, len);
+                prevLead = lead;
+                prevTrail = trail;
+            }
+        }
+    }
+
+    inline bool sameBits(double a, double b)
+    {
+        uint64_t x;
+        uint64_t y;
+        std::memcpy(&x, &a, sizeof(x));
+        std::memcpy(&y, &b, sizeof(y));
+        return x == y;
+    }
+
+    // Smallest scale at which every value is an exact decimal; false if none up to kMaxScale
+    inline bool findDecimalScale(const double* v, size_t n, std::vector<int64_t>& mantissas, unsigned& scale)
+    {
+        mantissas.resize(n);
+        for (unsigned s = 0; s <= kMaxScale; s++) {
+            const double p = kPow10[s];
+            bool exact = true;
+            for (size_t i = 0; i < n && exact; i++) {
+                double scaled = v[i] * p;
+                if (!(std::fabs(scaled) < 2251799813685248.0)) {   // 2^51 (see decodeDecimal); also rejects NaN/inf
+                    return false;
+                }
+                int64_t m = std::llround(scaled);
+                exact = sameBits(static_cast<double>(m) / p, v[i]);
+                mantissas[i] = m;
+            }
+            if (exact) {
+                scale = s;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Largest power of ten (up to 10^9) dividing every timestamp
+    inline unsigned timeScale(const int64_t* t, size_t n)
+    {
+        unsigned s = kMaxScale;
+        for (size_t i = 0; i < n && s > 0; i++) {
+            while (s > 0 && t[i] % kPow10Int[s] != 0) {
+                s--;
+            }
+        }
+        return s;
+    }
+
+    // Decoder lanes: one per segment. first() reads the segment's raw seed, next() one more
+    // value; both return the value's bits
+    struct DeltaOfDeltaLane {
+        BitReader r;
+        uint64_t v = 0;
+        uint64_t delta = 0;
+        bool ok = true;
+
+        uint64_t first() { return v = r.readWide(64); }
+        uint64_t next()
+        {
+            delta += unzigzag(readBucketed(r));
+            return v += delta;
+        }
+    };
+
+    // Decimal mantissas come out as doubles biased by 2^52 + 2^51 (exact below 2^51); the
+    // division by 10^scale is a separate pass the compiler vectorizes
+    constexpr uint64_t kBiasBits = 0x4338000000000000ULL;
+    constexpr double kBias = 6755399441055744.0;
+
+    struct DecimalLane {
+        BitReader r;
+        uint64_t m = 0;
+        bool ok = true;
+
+        uint64_t first() { return (m = r.readWide(64)) + kBiasBits; }
+        uint64_t next()
+        {
+            m += unzigzag(readBucketed(r));
+            return m + kBiasBits;
+        }
+    };
+
+    struct XorLane {
+        BitReader r;
+        uint64_t prev = 0;
+        unsigned lead = 0;
+        unsigned trail = 0;
+        bool ok = true;
+
+        uint64_t first() { return prev = r.readWide(64); }
+        uint64_t next()
+        {
+            uint64_t win = r.peek();
+            if (!(win >> 63)) {
+                r.skip(1);
+                return prev;
+            }
+            if ((win >> 62) == 3) {
+                lead = static_cast<unsigned>(win >> 56) & 63;
+                unsigned len = (static_cast<unsigned>(win >> 50) & 63) + 1;
+                if (lead + len > 64) {
+                    ok = false;
+                    len = 64 - lead;
+                }
+                trail = 64 - lead - len;
+                r.skip(14);
+            } else {
+                r.skip(2);
+            }
+            return prev ^= r.readWide(64 - lead - trail) << trail;
+        }
+    };
+
+    // A column is kSegments independent bit streams over consecutive slices of the block.
+    // Each value's bit position depends on the one before it, so a single stream decodes at
+    // the latency of that chain; stepping the segments in lockstep overlaps four chains.
+    constexpr size_t kSegments = 4;
+
+    inline size_t segmentBegin(size_t s, size_t n) { return s * (n / kSegments); }
+    inline size_t segmentEnd(size_t s, size_t n) { return s + 1 == kSegments ? n : (s + 1) * (n / kSegments); }
+
+    template <typename Lane, typename T>
+    inline bool decodeSegments(const uint64_t* words, const uint32_t* segmentWords, size_t n, T* out)
+    {
+        static_assert(sizeof(T) == sizeof(uint64_t), "lanes emit 64-bit values");
+        static_assert(kSegments == 4, "lanes are unrolled by hand");
+        auto put = [out](size_t i, uint64_t bits) { std::memcpy(&out[i], &bits, sizeof(bits)); };
+
+        // Four named lanes rather than an array, so their state stays in registers
+        Lane l0, l1, l2, l3;
+        l0.r = BitReader(words, segmentWords[0]);
+        l1.r = BitReader(words + segmentWords[0], segmentWords[1]);
+        l2.r = BitReader(words + segmentWords[0] + segmentWords[1], segmentWords[2]);
+        l3.r = BitReader(words + segmentWords[0] + segmentWords[1] + segmentWords[2], segmentWords[3]);
+
+        const size_t base = n / kSegments;
+        size_t i = 0;
+        if (base > 0) {
+            put(0, l0.first());
+            put(base, l1.first());
+            put(2 * base, l2.first());
+            put(3 * base, l3.first());
+            for (i = 1; i < base; i++) {
+                put(i, l0.next());
+                put(base + i, l1.next());
+                put(2 * base + i, l2.next());
+                put(3 * base + i, l3.next());
+                if (l0.r.overrun() | l1.r.overrun() | l2.r.overrun() | l3.r.overrun()) {
+                    return false;
+                }
+            }
+            i = 4 * base;
+        } else if (n > 0) {
+            put(0, l3.first());
+            i = 1;
+        }
+        for (; i < n; i++) {   // Remainder of the last segment
+            put(i, l3.next());
+        }
+        return !(l0.r.overrun() | l1.r.overrun() | l2.r.overrun() | l3.r.overrun())
+               && l0.ok && l1.ok && l2.ok && l3.ok;
+    }
+
+    inline bool decodeTimes(const uint64_t* words, const uint32_t* segmentWords, size_t n, unsigned scale,
+                            int64_t* out)
+    {
+        if (!decodeSegments<DeltaOfDeltaLane>(words, segmentWords, n, out)) {
+            return false;
+        }
+        if (scale > 0) {
+            const uint64_t mult = static_cast<uint64_t>(kPow10Int[scale]);
+            for (size_t i = 0; i < n; i++) {
+                out[i] = static_cast<int64_t>(static_cast<uint64_t>(out[i]) * mult);
+            }
+        }
+        return true;
+    }
+
+    inline bool decodeDecimal(const uint64_t* words, const uint32_t* segmentWords, size_t n, unsigned scale,
+                              double* out)
+    {
+        if (!decodeSegments<DecimalLane>(words, segmentWords, n, out)) {
+            return false;
+        }
+        const double p = kPow10[scale];
+        size_t i = 0;
+#ifdef __SSE2__
+        const __m128d bias = _mm_set1_pd(kBias);
+        const __m128d div = _mm_set1_pd(p);
+        for (; i + 2 <= n; i += 2) {
+            _mm_storeu_pd(out + i, _mm_div_pd(_mm_sub_pd(_mm_loadu_pd(out + i), bias), div));
+        }
+#endif
+        for (; i < n; i++) {
+            out[i] = (out[i] - kBias) / p;
+        }
+        return true;
+    }
+
+    inline bool decodeXor(const uint64_t* words, const uint32_t* segmentWords, size_t n, double* out)
+    {
+        return decodeSegments<XorLane>(words, segmentWords, n, out);
+    }
+} // namespace capture_detail
+
+//------------------------------------------
+// WRITER
+//------------------------------------------
+// Buffers one block of records and encodes it when full. Not thread-safe: one writer per
+// feed thread.
+class CaptureWriter {
+public:
+    ~CaptureWriter() { close(); }
+
+    // Appends to an existing capture of the same kind and product (dropping its index and
+    // any torn block at the tail); creates the file otherwise
+    bool open(const std::string& path, CaptureKind kind, const std::string& productId,
+              int64_t granularitySeconds = 0, size_t blockRecords = 4096);
+
+    // Also flush once a block spans this much time (0 = only when full), so a quiet
+    // market doesn't keep records in memory indefinitely
+    void setMaxBlockSpan(int64_t span) { maxBlockSpan_ = span; }
+
+    // values[columns]; timestamps should not go backwards (the index assumes they don't)
+    bool append(int64_t time, const double* values)
+    {
+        pending_.time.push_back(time);
+        for (size_t c = 0; c < pending_.values.size(); c++) {
+            pending_.values[c].push_back(values[c]);
+        }
+        if (pending_.size() >= blockRecords_
+            || (maxBlockSpan_ > 0 && time - pending_.time.front() >= maxBlockSpan_)) {
+            return flush();
+        }
+        return true;
+    }
+
+    bool appendBars(const CandleColumns& bars)
+    {
+        for (size_t i = 0; i < bars.size(); i++) {
+            double v[5] = {bars.open[i], bars.high[i], bars.low[i], bars.close[i], bars.volume[i]};
+            if (!append(bars.start[i], v)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Encodes and writes the pending records as one block
+    bool flush();
+
+    // Flushes, then writes the block index and footer
+    void close();
+
+    uint64_t bytesWritten() const { return offset_; }
+
+private:
+    template <typename T, typename Encode>
+    static void encodeSegments(const T* v, size_t n, Encode encode, capture_detail::BitWriter& w,
+                               std::vector<uint64_t>& words, CaptureColumnHeader& ch);
+    void encodeColumn(const std::vector<double>& v, CaptureColumnHeader& ch, std::vector<uint64_t>& out);
+
+    std::FILE* file_ = nullptr;
+    size_t blockRecords_ = 4096;
+    int64_t maxBlockSpan_ = 0;
+    uint64_t offset_ = 0;
+    CaptureColumns pending_;
+    std::vector<CaptureIndexEntry> index_;
+    capture_detail::BitWriter bits_;
+    std::vector<uint64_t> columnWords_;
+    std::vector<uint64_t> altWords_;
+    std::vector<int64_t> mantissas_;
+    std::vector<uint64_t> payload_;
+};
+
+//------------------------------------------
+// READER (FOR BACKTESTS)
+//------------------------------------------
+// Decodes block by block into caller-owned columns: readColumn() decodes one column of one
+// block straight onto the end of a vector, so e.g. the closes of a whole capture land in
+// one contiguous array ready for smaBatch() without touching the other columns.
+class CaptureReader {
+public:
+    ~CaptureReader()
+    {
+        if (file_) {
+            std::fclose(file_);
+        }
+    }
+
+    bool open(const std::string& path);
+
+    const CaptureFileHeader& header() const { return header_; }
+    size_t columns() const { return header_.columns; }
+    const std::vector<CaptureIndexEntry>& index() const { return index_; }
+
+    // End of the last complete block (where an appending writer continues)
+    uint64_t dataEnd() const { return dataEnd_; }
+
+    // Append block b to `out` (every column, or one value column, or the timestamps)
+    bool readBlock(size_t b, CaptureColumns& out);
+    bool readColumn(size_t b, size_t column, std::vector<double>& out);
+    bool readTimes(size_t b, std::vector<int64_t>& out);
+
+    // Every block overlapping [from, to], in file order; fn(const CaptureColumns&) sees
+    // each block on its own (the columns are reused between calls)
+    template <typename Fn>
+    bool forEachBlock(Fn&& fn, int64_t from = INT64_MIN, int64_t to = INT64_MAX)
+    {
+        CaptureColumns block;
+        block.values.resize(columns());
+        for (size_t b = 0; b < index_.size(); b++) {
+            if (index_[b].lastTime < from || index_[b].firstTime > to) {
+                continue;
+            }
+            block.clear();
+            if (!readBlock(b, block)) {
+                return false;
+            }
+            fn(static_cast<const CaptureColumns&>(block));
+        }
+        return true;
+    }
+
+    // Whole capture as one set of columns
+    bool readAll(CaptureColumns& out)
+    {
+        out.values.resize(columns());
+        out.clear();
+        for (size_t b = 0; b < index_.size(); b++) {
+            if (!readBlock(b, out)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    bool loadTable(size_t b);
+    bool loadColumn(size_t b, size_t column, CaptureColumnHeader& ch);
+    bool decodeValues(size_t b, size_t column, double* dst);
+    bool decodeTimes(size_t b, int64_t* dst);
+    bool scanBlocks(uint64_t fileSize);
+
+    std::FILE* file_ = nullptr;
+    CaptureFileHeader header_;
+    std::vector<CaptureIndexEntry> index_;
+    uint64_t dataEnd_ = 0;
+    size_t tableBlock_ = SIZE_MAX;             // Block whose column table is in table_
+    std::vector<CaptureColumnHeader> table_;
+    std::vector<uint64_t> columnOffsets_;      // File offset of each column of that block
+    std::vector<uint64_t> column_;             // Words of the column being decoded, plus padding
+};
+
+inline bool CaptureReader::open(const std::string& path)
+{
+    file_ = std::fopen(path.c_str(), "rb");
+    if (!file_) {
+        std::cerr << "[ERROR] Could not open capture file " << path << "\n";
+        return false;
+    }
+    if (std::fread(&header_, sizeof(header_), 1, file_) != 1
+        || std::memcmp(header_.magic, CaptureFileHeader{}.magic, 4) != 0
+        || header_.columns != captureColumnCount(static_cast<CaptureKind>(header_.kind))) {
+        std::cerr << "[ERROR] " << path << " is not a market capture file\n";
+        return false;
+    }
+    std::error_code ec;
+    uint64_t fileSize = std::filesystem::file_size(path, ec);
+    if (ec) {
+        return false;
+    }
+
+    // Footer index if the writer closed cleanly; otherwise walk the blocks
+    CaptureFooter footer;
+    if (fileSize >= sizeof(header_) + sizeof(footer)
+        && std::fseek(file_, static_cast<long>(fileSize - sizeof(footer)), SEEK_SET) == 0
+        && std::fread(&footer, sizeof(footer), 1, file_) == 1 && footer.magic == CaptureFooter{}.magic
+        && footer.indexOffset + footer.blocks * sizeof(CaptureIndexEntry) + sizeof(footer) == fileSize) {
+        index_.resize(footer.blocks);
+        if (std::fseek(file_, static_cast<long>(footer.indexOffset), SEEK_SET) == 0
+            && std::fread(index_.data(), sizeof(CaptureIndexEntry), index_.size(), file_) == index_.size()) {
+            dataEnd_ = footer.indexOffset;
+            return true;
+        }
+        index_.clear();
+    }
+    return scanBlocks(fileSize);
+}
+
+inline bool CaptureReader::scanBlocks(uint64_t fileSize)
+{
+    uint64_t offset = sizeof(header_);
+    CaptureBlockHeader bh;
+    while (std::fseek(file_, static_cast<long>(offset), SEEK_SET) == 0
+           && std::fread(&bh, sizeof(bh), 1, file_) == 1 && bh.magic == CaptureBlockHeader{}.magic) {
+        uint64_t end = offset + sizeof(bh) + static_cast<uint64_t>(bh.payloadWords) * 8;
+        if (end > fileSize) {
+            break;   // Torn tail
+        }
+        CaptureIndexEntry e;
+        e.offset = offset;
+        e.firstTime = bh.firstTime;
+        e.lastTime = bh.lastTime;
+        e.count = bh.count;
+        e.payloadWords = bh.payloadWords;
+        index_.push_back(e);
+        offset = end;
+    }
+    dataEnd_ = offset;
+    return true;
+}
+
+inline bool CaptureReader::loadTable(size_t b)
+{
+    if (tableBlock_ == b) {
+        return true;
+    }
+    tableBlock_ = SIZE_MAX;
+    const CaptureIndexEntry& e = index_[b];
+    const size_t entries = header_.columns + 1;
+    CaptureBlockHeader bh;
+    table_.resize(entries);
+    if (std::fseek(file_, static_cast<long>(e.offset), SEEK_SET) != 0
+        || std::fread(&bh, sizeof(bh), 1, file_) != 1 || bh.magic != CaptureBlockHeader{}.magic
+        || bh.count != e.count || bh.payloadWords != e.payloadWords
+        || std::fread(table_.data(), sizeof(CaptureColumnHeader), entries, file_) != entries
+        || capture_detail::captureChecksum(reinterpret_cast<const uint64_t*>(table_.data()),
+                                           entries * sizeof(CaptureColumnHeader) / 8) != bh.checksum) {
+        std::cerr << "[ERROR] Capture block " << b << " is corrupt\n";
+        return false;
+    }
+
+    // Column offsets, checked against the block's size
+    columnOffsets_.resize(entries);
+    uint64_t at = e.offset + sizeof(bh) + entries * sizeof(CaptureColumnHeader);
+    uint64_t words = entries * sizeof(CaptureColumnHeader) / 8;
+    for (size_t c = 0; c < entries; c++) {
+        const CaptureColumnHeader& ch = table_[c];
+        uint64_t segments = 0;
+        for (uint32_t w : ch.segmentWords) {
+            segments += w;
+        }
+        if (segments != ch.words || ch.scale > capture_detail::kMaxScale) {
+            std::cerr << "[ERROR] Capture block " << b << " is corrupt\n";
+            return false;
+        }
+        columnOffsets_[c] = at;
+        at += static_cast<uint64_t>(ch.words) * 8;
+        words += ch.words;
+    }
+    if (words != e.payloadWords) {
+        std::cerr << "[ERROR] Capture block " << b << " is corrupt\n";
+        return false;
+    }
+    tableBlock_ = b;
+    return true;
+}
+
+// column 0 = time, 1.. = values. Reads only that column's words.
+inline bool CaptureReader::loadColumn(size_t b, size_t column, CaptureColumnHeader& ch)
+{
+    if (!loadTable(b)) {
+        return false;
+    }
+    ch = table_[column];
+    column_.resize(ch.words + capture_detail::kReadPadWords);
+    std::fill(column_.begin() + ch.words, column_.end(), 0);
+    if (std::fseek(file_, static_cast<long>(columnOffsets_[column]), SEEK_SET) != 0
+        || std::fread(column_.data(), 8, ch.words, file_) != ch.words
+        || capture_detail::captureChecksum(column_.data(), ch.words) != ch.checksum) {
+        std::cerr << "[ERROR] Capture block " << b << " column " << column << " is corrupt\n";
+        return false;
+    }
+    return true;
+}
+
+inline bool CaptureReader::decodeTimes(size_t b, int64_t* dst)
+{
+    CaptureColumnHeader ch;
+    if (!loadColumn(b, 0, ch)) {
+        return false;
+    }
+    return capture_detail::decodeTimes(column_.data(), ch.segmentWords, index_[b].count, ch.scale, dst);
+}
+
+inline bool CaptureReader::decodeValues(size_t b, size_t column, double* dst)
+{
+    CaptureColumnHeader ch;
+    if (column >= header_.columns || !loadColumn(b, column + 1, ch)) {
+        return false;
+    }
+    if (ch.codec == static_cast<uint8_t>(CaptureCodec::Decimal)) {
+        return capture_detail::decodeDecimal(column_.data(), ch.segmentWords, index_[b].count, ch.scale, dst);
+    }
+    return capture_detail::decodeXor(column_.data(), ch.segmentWords, index_[b].count, dst);
+}
+
+inline bool CaptureReader::readTimes(size_t b, std::vector<int64_t>& out)
+{
+    size_t n = out.size();
+    out.resize(n + index_[b].count);
+    if (!decodeTimes(b, out.data() + n)) {
+        out.resize(n);
+        return false;
+    }
+    return true;
+}
+
+inline bool CaptureReader::readColumn(size_t b, size_t column, std::vector<double>& out)
+{
+    size_t n = out.size();
+    out.resize(n + index_[b].count);
+    if (!decodeValues(b, column, out.data() + n)) {
+        out.resize(n);
+        return false;
+    }
+    return true;
+}
+
+inline bool CaptureReader::readBlock(size_t b, CaptureColumns& out)
+{
+    out.values.resize(columns());
+    if (!readTimes(b, out.time)) {
+        return false;
+    }
+    for (size_t c = 0; c < columns(); c++) {
+        if (!readColumn(b, c, out.values[c])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//------------------------------------------
+// WRITER IMPLEMENTATION
+//------------------------------------------
+inline bool CaptureWriter::open(const std::string& path, CaptureKind kind, const std::string& productId,
+                                int64_t granularitySeconds, size_t blockRecords)
+{
+    CaptureFileHeader header;
+    header.kind = static_cast<uint32_t>(kind);
+    header.columns = captureColumnCount(kind);
+    header.granularitySeconds = granularitySeconds;
+    std::snprintf(header.productId, sizeof(header.productId), "%s", productId.c_str());
+
+    blockRecords_ = blockRecords;
+    pending_.values.assign(header.columns, {});
+    index_.clear();
+
+    std::error_code ec;
+    if (std::filesystem::exists(path, ec)) {
+        CaptureReader existing;
+        if (!existing.open(path)) {
+            return false;
+        }
+        const CaptureFileHeader& h = existing.header();
+        if (h.kind != header.kind || std::strncmp(h.productId, header.productId, sizeof(h.productId)) != 0) {
+            std::cerr << "[ERROR] " << path << " holds a different capture; not appending\n";
+            return false;
+        }
+        index_ = existing.index();
+        offset_ = existing.dataEnd();
+        std::filesystem::resize_file(path, offset_, ec);   // Drop the old index / torn tail
+        if (ec) {
+            return false;
+        }
+        file_ = std::fopen(path.c_str(), "ab");
+        return file_ != nullptr;
+    }
+
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_ || std::fwrite(&header, sizeof(header), 1, file_) != 1) {
+        std::cerr << "[ERROR] Could not create capture file " << path << "\n";
+        return false;
+    }
+    offset_ = sizeof(header);
+    return true;
+}
+
+template <typename T, typename Encode>
+inline void CaptureWriter::encodeSegments(const T* v, size_t n, Encode encode, capture_detail::BitWriter& w,
+                                          std::vector<uint64_t>& words, CaptureColumnHeader& ch)
+{
+    using namespace capture_detail;
+    words.clear();
+    for (size_t s = 0; s < kSegments; s++) {
+        size_t begin = segmentBegin(s, n);
+        size_t end = segmentEnd(s, n);
+        w.clear();
+        if (end > begin) {
+            encode(v + begin, end - begin, w);
+        }
+        ch.segmentWords[s] = static_cast<uint32_t>(w.wordCount());
+        w.appendTo(words);
+    }
+    ch.words = static_cast<uint32_t>(words.size());
+    ch.checksum = capture_detail::captureChecksum(words.data(), words.size());
+}
+
+inline void CaptureWriter::encodeColumn(const std::vector<double>& v, CaptureColumnHeader& ch,
+                                        std::vector<uint64_t>& out)
+{
+    using namespace capture_detail;
+    encodeSegments(v.data(), v.size(), encodeXor, bits_, columnWords_, ch);
+    ch.codec = static_cast<uint8_t>(CaptureCodec::Xor);
+    ch.scale = 0;
+
+    unsigned scale = 0;
+    if (findDecimalScale(v.data(), v.size(), mantissas_, scale)) {
+        CaptureColumnHeader decimal;
+        encodeSegments(mantissas_.data(), mantissas_.size(), encodeFirstDeltas, bits_, altWords_, decimal);
+        if (decimal.words < ch.words) {
+            ch = decimal;
+            ch.codec = static_cast<uint8_t>(CaptureCodec::Decimal);
+            ch.scale = static_cast<uint8_t>(scale);
+            columnWords_.swap(altWords_);
+        }
+    }
+    out.insert(out.end(), columnWords_.begin(), columnWords_.end());
+}
+
+inline bool CaptureWriter::flush()
+{
+    using namespace capture_detail;
+    if (!file_) {
+        return false;
+    }
+    const size_t n = pending_.size();
+    if (n == 0) {
+        return true;
+    }
+    const size_t columns = pending_.values.size();
+    std::vector<CaptureColumnHeader> headers(columns + 1);
+    payload_.assign((columns + 1) * sizeof(CaptureColumnHeader) / 8, 0);
+
+    // Time column
+    unsigned scale = timeScale(pending_.time.data(), n);
+    mantissas_.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        mantissas_[i] = pending_.time[i] / kPow10Int[scale];
+    }
+    encodeSegments(mantissas_.data(), n, encodeDeltas, bits_, columnWords_, headers[0]);
+    headers[0].codec = static_cast<uint8_t>(CaptureCodec::DeltaOfDelta);
+    headers[0].scale = static_cast<uint8_t>(scale);
+    payload_.insert(payload_.end(), columnWords_.begin(), columnWords_.end());
+
+    for (size_t c = 0; c < columns; c++) {
+        encodeColumn(pending_.values[c], headers[c + 1], payload_);
+    }
+    std::memcpy(payload_.data(), headers.data(), headers.size() * sizeof(CaptureColumnHeader));
+
+    CaptureBlockHeader bh;
+    bh.count = static_cast<uint32_t>(n);
+    bh.payloadWords = static_cast<uint32_t>(payload_.size());
+    bh.firstTime = pending_.time.front();
+    bh.lastTime = pending_.time.back();
+    bh.checksum = captureChecksum(payload_.data(), headers.size() * sizeof(CaptureColumnHeader) / 8);
+
+    bool ok = std::fwrite(&bh, sizeof(bh), 1, file_) == 1
+              && std::fwrite(payload_.data(), 8, payload_.size(), file_) == payload_.size()
+              && std::fflush(file_) == 0;
+    if (!ok) {
+        std::cerr << "[ERROR] Capture write failed\n";
+        return false;
+    }
+
+    CaptureIndexEntry e;
+    e.offset = offset_;
+    e.firstTime = bh.firstTime;
+    e.lastTime = bh.lastTime;
+    e.count = bh.count;
+    e.payloadWords = bh.payloadWords;
+    index_.push_back(e);
+    offset_ += sizeof(bh) + payload_.size() * 8;
+    pending_.clear();
+    return true;
+}
+
+inline void CaptureWriter::close()
+{
+    if (!file_) {
+        return;
+    }
+    flush();
+    CaptureFooter footer;
+    footer.indexOffset = offset_;
+    footer.blocks = static_cast<uint32_t>(index_.size());
+    std::fwrite(index_.data(), sizeof(CaptureIndexEntry), index_.size(), file_);
+    std::fwrite(&footer, sizeof(footer), 1, file_);
+    std::fclose(file_);
+    file_ = nullptr;
+}
+
+//------------------------------------------
+// TRADE CAPTURE (MARKET_TRADES CHANNEL)
+//------------------------------------------
+// RFC 3339 UTC ("2024-05-01T12:34:56.123456Z") -> epoch nanoseconds
+inline bool parseRfc3339Nanos(std::string_view s, int64_t& nanos)
+{
+    auto num = [&](size_t pos, size_t len, int64_t& v) {
+        v = 0;
+        if (pos + len > s.size()) return false;
+        for (size_t i = pos; i < pos + len; i++) {
+            if (s[i] < '0' || s[i] > '9') return false;
+            v = v * 10 + (s[i] - '0');
+        }
+        return true;
+    };
+    int64_t y, mo, d, h, mi, sec;
+    if (!num(0, 4, y) || !num(5, 2, mo) || !num(8, 2, d) || !num(11, 2, h) || !num(14, 2, mi) || !num(17, 2, sec)) {
+        return false;
+    }
+    int64_t frac = 0;
+    size_t i = 19;
+    if (i < s.size() && s[i] == '.') {
+        int64_t digits = 0;
+        for (i++; i < s.size() && s[i] >= '0' && s[i] <= '9'; i++, digits++) {
+            if (digits < 9) frac = frac * 10 + (s[i] - '0');
+        }
+        for (; digits < 9; digits++) frac *= 10;
+    }
+    // Days from civil (proleptic Gregorian)
+    y -= mo <= 2;
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    int64_t yoe = y - era * 400;
+    int64_t doy = (153 * (mo + (mo > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    int64_t days = era * 146097 + doe - 719468;
+    nanos = ((days * 86400 + h * 3600 + mi * 60 + sec) * 1'000'000'000) + frac;
+    return true;
+}
+
+// Calls fn(productId, timeNanos, price, size, side) for every new trade in a market_trades
+// message, oldest first; side is +1 for a buy, -1 for a sell. Returns false for other messages.
+// Snapshot events are skipped: every (re)subscribe replays the last trades as one, which would
+// duplicate them and send timestamps backwards.
+template <typename Fn>
+bool forEachMarketTrade(const std::string& msg, Fn&& fn)
+{
+    nlohmann::json j = nlohmann::json::parse(msg, nullptr, false);
+    if (j.is_discarded() || j.value("channel", "") != "market_trades" || !j.contains("events")) {
+        return false;
+    }
+    for (const auto& event : j["events"]) {
+        if (!event.contains("trades") || event.value("type", "") == "snapshot") {
+            continue;
+        }
+        // Trades are listed newest first
+        const auto& trades = event["trades"];
+        for (size_t k = trades.size(); k-- > 0;) {
+            const auto& t = trades[k];
+            int64_t time = 0;
+            if (!parseRfc3339Nanos(t.value("time", ""), time)) {
+                continue;
+            }
+            fn(t.value("product_id", ""), time, std::atof(t.value("price", "0").c_str()),
+               std::atof(t.value("size", "0").c_str()), t.value("side", "") == "BUY" ? 1 : -1);
+        }
+    }
+    return true;
+}
+
+// Appends every trade in a market_trades message; returns the number captured.
+// Call on the feed thread that owns the writer.
+inline size_t captureMarketTrades(CaptureWriter& writer, const std::string& msg)
+{
+    size_t captured = 0;
+    forEachMarketTrade(msg, [&](const std::string&, int64_t time, double price, double size, int side) {
+        double v[3] = {price, size, static_cast<double>(side)};
+        if (writer.append(time, v)) {
+            captured++;
+        }
+    });
+    return captured;
+}
+
+//------------------------------------------
+// CANDLE FILE CONVERSION
+//------------------------------------------
+// Downloaded candle file (candle_store.h) -> compressed bars capture
+inline bool compressCandleFile(const std::string& inPath, const std::string& outPath)
+{
+    CandleFileHeader header;
+    CandleColumns candles;
+    if (!readCandleFile(inPath, header, candles)) {
+        return false;
+    }
+    std::error_code ec;
+    std::filesystem::remove(outPath, ec);
+    CaptureWriter writer;
+    if (!writer.open(outPath, CaptureKind::Bars, header.productId, header.granularitySeconds)
+        || !writer.appendBars(candles) || !writer.flush()) {
+        return false;
+    }
+    writer.close();
+    uint64_t before = std::filesystem::file_size(inPath, ec);
+    uint64_t after = std::filesystem::file_size(outPath, ec);
+    std::cout << "[INFO] " << candles.size() << " candles: " << before << " -> " << after << " bytes\n";
+    return true;
+}
+
+#endif // MARKET_CAPTURE_H
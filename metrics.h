@@ -0,0 +1,328 @@
+// metrics.h
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>   // Boost 1.74 asio uses std::exchange without including it (C++20 builds)
+
+#include <boost/asio.hpp>
+
+//------------------------------------------
+// LOCK-FREE METRICS
+//------------------------------------------
+// Updates are relaxed atomic increments so they can sit on the hot path.
+// The text exposition is only built when the metrics endpoint is scraped.
+
+class Counter {
+public:
+    void inc(uint64_t n = 1) { value_.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t value() const { return value_.load(std::memory_order_relaxed); }
+private:
+    std::atomic<uint64_t> value_{0};
+};
+
+class Gauge {
+public:
+    void set(int64_t v) { value_.store(v, std::memory_order_relaxed); }
+    int64_t value() const { return value_.load(std::memory_order_relaxed); }
+private:
+    std::atomic<int64_t> value_{0};
+};
+
+// Latency histogram with fixed bucket bounds in microseconds
+class LatencyHistogram {
+public:
+    static constexpr std::array<uint64_t, 16> kBoundsMicros = {
+            50, 100, 250, 500, 1'000, 2'500, 5'000, 10'000, 25'000, 50'000,
+            100'000, 250'000, 500'000, 1'000'000, 2'500'000, 5'000'000};
+
+    void observeNanos(int64_t nanos)
+    {
+        if (nanos < 0) nanos = 0;
+        uint64_t micros = static_cast<uint64_t>(nanos) / 1000;
+        size_t i = 0;
+        while (i < kBoundsMicros.size() && micros > kBoundsMicros[i]) {
+            i++;
+        }
+        buckets_[i].fetch_add(1, std::memory_order_relaxed); // Last slot is +Inf
+        sumNanos_.fetch_add(static_cast<uint64_t>(nanos), std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void render(std::ostream& out, const std::string& name, const std::string& help) const
+    {
+        out << "# HELP " << name << " " << help << "\n";
+        out << "# TYPE " << name << " histogram\n";
+        uint64_t cumulative = 0;
+        for (size_t i = 0; i < kBoundsMicros.size(); i++) {
+            cumulative += buckets_[i].load(std::memory_order_relaxed);
+            out << name << "_bucket{le=\"" << static_cast<double>(kBoundsMicros[i]) / 1e6 << "\"} " << cumulative << "\n";
+        }
+        cumulative += buckets_[kBoundsMicros.size()].load(std::memory_order_relaxed);
+        out << name << "_bucket{le=\"+Inf\"} " << cumulative << "\n";
+        out << name << "_sum " << static_cast<double>(sumNanos_.load(std::memory_order_relaxed)) / 1e9 << "\n";
+        out << name << "_count " << count_.load(std::memory_order_relaxed) << "\n";
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, kBoundsMicros.size() + 1> buckets_{};
+    std::atomic<uint64_t> sumNanos_{0};
+    std::atomic<uint64_t> count_{0};
+};
+
+// REST endpoints we label request metrics with
+enum class Endpoint : uint8_t { Candles = 0, Orders, Other, Count };
+
+inline const char* endpointName(Endpoint e)
+{
+    switch (e) {
+        case Endpoint::Candles: return "candles";
+        case Endpoint::Orders: return "orders";
+        default: return "other";
+    }
+}
+
+inline Endpoint endpointFromUrl(const char* url)
+{
+    std::string_view u(url);
+    if (u.find("/candles") != std::string_view::npos) return Endpoint::Candles;
+    if (u.find("/orders") != std::string_view::npos) return Endpoint::Orders;
+    return Endpoint::Other;
+}
+
+// Status is bucketed by class; 0 means the transport failed before a response
+enum class StatusClass : uint8_t { TransportError = 0, S2xx, S3xx, S4xx, S5xx, Count };
+
+inline StatusClass statusClassOf(long httpStatus)
+{
+    if (httpStatus >= 200 && httpStatus < 300) return StatusClass::S2xx;
+    if (httpStatus >= 300 && httpStatus < 400) return StatusClass::S3xx;
+    if (httpStatus >= 400 && httpStatus < 500) return StatusClass::S4xx;
+    if (httpStatus >= 500) return StatusClass::S5xx;
+    return StatusClass::TransportError;
+}
+
+struct Metrics {
+    static constexpr size_t kEndpoints = static_cast<size_t>(Endpoint::Count);
+    static constexpr size_t kStatuses = static_cast<size_t>(StatusClass::Count);
+
+    std::array<std::array<Counter, kStatuses>, kEndpoints> requests{};
+    std::array<LatencyHistogram, kEndpoints> requestLatency{};
+    LatencyHistogram jwtSignTime;
+    LatencyHistogram parseTime;
+    LatencyHistogram loopLag;
+    LatencyHistogram snapshotToOrderAck;
+    Gauge clockOffsetNanos;
+    Gauge clockRttNanos;
+    Counter ordersPlaced;
+    Counter ordersRejectedExchange;
+    Counter ordersRejectedRisk;
+    Counter orderRetries;
+    Counter ordersAmended;
+    Counter ordersCancelled;
+    Counter bookResyncs;
+    Counter amendsRejected;
+    Counter busEvents;
+    Counter busEventsLost;
+
+    void recordRequest(Endpoint e, long httpStatus, int64_t nanos)
+    {
+        requests[static_cast<size_t>(e)][static_cast<size_t>(statusClassOf(httpStatus))].inc();
+        requestLatency[static_cast<size_t>(e)].observeNanos(nanos);
+    }
+
+    std::string renderPrometheus() const
+    {
+        static const char* statusNames[kStatuses] = {"error", "2xx", "3xx", "4xx", "5xx"};
+        std::ostringstream out;
+
+        out << "# HELP coinbasebot_http_requests_total REST requests by endpoint and status class\n";
+        out << "# TYPE coinbasebot_http_requests_total counter\n";
+        for (size_t e = 0; e < kEndpoints; e++) {
+            for (size_t s = 0; s < kStatuses; s++) {
+                out << "coinbasebot_http_requests_total{endpoint=\"" << endpointName(static_cast<Endpoint>(e))
+                    << "\",status=\"" << statusNames[s] << "\"} " << requests[e][s].value() << "\n";
+            }
+        }
+        for (size_t e = 0; e < kEndpoints; e++) {
+            std::string name = std::string("coinbasebot_http_request_seconds_") + endpointName(static_cast<Endpoint>(e));
+            requestLatency[e].render(out, name, "REST request latency");
+        }
+        jwtSignTime.render(out, "coinbasebot_jwt_sign_seconds", "Time to create and sign a JWT");
+        parseTime.render(out, "coinbasebot_parse_seconds", "Time to parse a REST response");
+        loopLag.render(out, "coinbasebot_loop_lag_seconds", "Main loop wake-up delay past its schedule");
+        snapshotToOrderAck.render(out, "coinbasebot_snapshot_to_order_ack_seconds", "Market snapshot to order acknowledgement");
+
+        out << "# HELP coinbasebot_clock_offset_seconds Exchange clock minus local clock\n";
+        out << "# TYPE coinbasebot_clock_offset_seconds gauge\n";
+        out << "coinbasebot_clock_offset_seconds " << static_cast<double>(clockOffsetNanos.value()) / 1e9 << "\n";
+        out << "# HELP coinbasebot_clock_rtt_seconds Round trip of the clock sample in use\n";
+        out << "# TYPE coinbasebot_clock_rtt_seconds gauge\n";
+        out << "coinbasebot_clock_rtt_seconds " << static_cast<double>(clockRttNanos.value()) / 1e9 << "\n";
+
+        out << "# HELP coinbasebot_orders_total Orders by outcome\n";
+        out << "# TYPE coinbasebot_orders_total counter\n";
+        out << "coinbasebot_orders_total{outcome=\"placed\"} " << ordersPlaced.value() << "\n";
+        out << "coinbasebot_orders_total{outcome=\"rejected_exchange\"} " << ordersRejectedExchange.value() << "\n";
+        out << "coinbasebot_orders_total{outcome=\"rejected_risk\"} " << ordersRejectedRisk.value() << "\n";
+        out << "coinbasebot_orders_total{outcome=\"cancelled\"} " << ordersCancelled.value() << "\n";
+        out << "# HELP coinbasebot_order_retries_total Orders resent with the same client_order_id\n";
+        out << "# TYPE coinbasebot_order_retries_total counter\n";
+        out << "coinbasebot_order_retries_total " << orderRetries.value() << "\n";
+        out << "# HELP coinbasebot_order_amends_total Resting orders repriced in place, by outcome\n";
+        out << "# TYPE coinbasebot_order_amends_total counter\n";
+        out << "coinbasebot_order_amends_total{outcome=\"accepted\"} " << ordersAmended.value() << "\n";
+        out << "coinbasebot_order_amends_total{outcome=\"rejected\"} " << amendsRejected.value() << "\n";
+        out << "# HELP coinbasebot_book_resyncs_total Level2 sequence gaps that forced a resubscribe\n";
+        out << "# TYPE coinbasebot_book_resyncs_total counter\n";
+        out << "coinbasebot_book_resyncs_total " << bookResyncs.value() << "\n";
+        out << "# HELP coinbasebot_bus_events_total Events read from the shared-memory market bus\n";
+        out << "# TYPE coinbasebot_bus_events_total counter\n";
+        out << "coinbasebot_bus_events_total " << busEvents.value() << "\n";
+        out << "# HELP coinbasebot_bus_events_lost_total Bus events overwritten before they were read\n";
+        out << "# TYPE coinbasebot_bus_events_lost_total counter\n";
+        out << "coinbasebot_bus_events_lost_total " << busEventsLost.value() << "\n";
+        return out.str();
+    }
+};
+
+// Process-wide metrics instance
+inline Metrics& metrics()
+{
+    static Metrics instance;
+    return instance;
+}
+
+// Observes the lifetime of the scope into a histogram
+class ScopedTimer {
+public:
+    explicit ScopedTimer(LatencyHistogram& h) : hist_(h), start_(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer()
+    {
+        hist_.observeNanos(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start_).count());
+    }
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+private:
+    LatencyHistogram& hist_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+//------------------------------------------
+// METRICS HTTP LISTENER (BOOST.ASIO)
+//------------------------------------------
+// Serves GET /metrics in Prometheus text format on its own thread.
+// Every connection is asynchronous with a deadline and a request size cap, so a client
+// that connects and never sends a request cannot hold up other scrapers.
+class MetricsServer {
+public:
+    static constexpr size_t kMaxRequestBytes = 8 * 1024;
+    static constexpr std::chrono::seconds kRequestTimeout{5};
+
+    MetricsServer(const std::string& bindAddress, unsigned short port)
+        : acceptor_(io_, boost::asio::ip::tcp::endpoint(boost::asio::ip::make_address(bindAddress), port)) {}
+
+    ~MetricsServer() { stop(); }
+
+    void start()
+    {
+        doAccept();
+        thread_ = std::thread([this] { io_.run(); });
+    }
+
+    void stop()
+    {
+        io_.stop();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+private:
+    // One scrape: read the head (bounded, with a deadline), answer, close
+    struct Session : std::enable_shared_from_this<Session> {
+        boost::asio::ip::tcp::socket socket;
+        boost::asio::steady_timer deadline;
+        boost::asio::streambuf request{kMaxRequestBytes};
+        std::string response;
+
+        explicit Session(boost::asio::ip::tcp::socket s)
+            : socket(std::move(s)), deadline(socket.get_executor()) {}
+
+        void start()
+        {
+            auto self = shared_from_this();
+            deadline.expires_after(kRequestTimeout);
+            deadline.async_wait([self](const boost::system::error_code& ec) {
+                if (!ec) {
+                    boost::system::error_code ignored;
+                    self->socket.close(ignored); // Aborts the pending read/write
+                }
+            });
+            boost::asio::async_read_until(socket, request, "\r\n\r\n",
+                [self](const boost::system::error_code& ec, size_t) {
+                    if (ec) {
+                        self->deadline.cancel(); // Timed out, oversized or disconnected
+                        return;
+                    }
+                    self->respond();
+                });
+        }
+
+        void respond()
+        {
+            // The path is all we care about
+            std::istream in(&request);
+            std::string method, path;
+            in >> method >> path;
+
+            std::string body;
+            std::string status;
+            if (method == "GET" && (path == "/metrics" || path == "/")) {
+                status = "200 OK";
+                body = metrics().renderPrometheus();
+            } else {
+                status = "404 Not Found";
+                body = "not found\n";
+            }
+
+            response = "HTTP/1.1 " + status + "\r\n"
+                       "Content-Type: text/plain; version=0.0.4\r\n"
+                       "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                       "Connection: close\r\n\r\n" + body;
+            auto self = shared_from_this();
+            boost::asio::async_write(socket, boost::asio::buffer(response),
+                [self](const boost::system::error_code&, size_t) {
+                    boost::system::error_code ignored;
+                    self->socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ignored);
+                    self->deadline.cancel();
+                });
+        }
+    };
+
+    void doAccept()
+    {
+        acceptor_.async_accept([this](boost::system::error_code ec, boost::asio::ip::tcp::socket socket) {
+            if (!ec) {
+                std::make_shared<Session>(std::move(socket))->start();
+            }
+            doAccept();
+        });
+    }
+
+    boost::asio::io_context io_;
+    boost::asio::ip::tcp::acceptor acceptor_;
+    std::thread thread_;
+};
+
+#endif // METRICS_H
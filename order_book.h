@@ -0,0 +1,522 @@
+// order_book.h
+#ifndef ORDER_BOOK_H
+#define ORDER_BOOK_H
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <climits>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+//------------------------------------------
+// PRICES
+//------------------------------------------
+// Prices are kept as integers in units of 1e-8 so levels compare exactly.
+constexpr int64_t kPriceScale = 100'000'000;
+
+// "64123.45" -> 6412345000000. Returns false on anything that isn't a plain decimal, or
+// on a whole part too large for the scaled value to fit in an int64.
+inline bool parseScaledPrice(std::string_view s, int64_t& out)
+{
+    constexpr int64_t kMaxWhole = INT64_MAX / kPriceScale - 1; // Leaves room for the fraction
+    int64_t whole = 0;
+    int64_t frac = 0;
+    int64_t fracScale = kPriceScale;
+    bool seenDot = false;
+    if (s.empty()) {
+        return false;
+    }
+    for (char c : s) {
+        if (c == '.') {
+            if (seenDot) {
+                return false;
+            }
+            seenDot = true;
+        } else if (c >= '0' && c <= '9') {
+            if (!seenDot) {
+                if (whole > (kMaxWhole - (c - '0')) / 10) {
+                    return false;
+                }
+                whole = whole * 10 + (c - '0');
+            } else if (fracScale > 1) {
+                fracScale /= 10;
+                frac += (c - '0') * fracScale; // Digits past 1e-8 are dropped
+            }
+        } else {
+            return false;
+        }
+    }
+    out = whole * kPriceScale + frac;
+    return true;
+}
+
+inline double scaledToDouble(int64_t price) { return static_cast<double>(price) / kPriceScale; }
+
+//------------------------------------------
+// BOOK SIDE
+//------------------------------------------
+// One side of the book as a flat array sorted so the best level is at the back
+// (bids ascending, asks descending). Almost every update lands near the touch, so an
+// insert or erase moves only the few levels above it, and best() is a single load.
+struct PriceLevel {
+    int64_t price = 0;
+    double size = 0.0;
+};
+
+template <bool IsBid>
+class BookSide {
+public:
+    static constexpr size_t kReserveLevels = 4096;
+
+    BookSide() { levels_.reserve(kReserveLevels); }
+
+    // Sets the size at a price level; size 0 removes it
+    void apply(int64_t price, double size)
+    {
+        auto it = std::lower_bound(levels_.begin(), levels_.end(), price,
+                                   [](const PriceLevel& l, int64_t p) { return worse(l.price, p); });
+        bool exists = (it != levels_.end() && it->price == price);
+        if (size <= 0.0) {
+            if (exists) {
+                levels_.erase(it);
+            }
+        } else if (exists) {
+            it->size = size;
+        } else {
+            levels_.insert(it, PriceLevel{price, size});
+        }
+    }
+
+    // Snapshot loading: append levels in any order, then sort once. A snapshot arrives
+    // best-first, the reverse of this layout, so apply() would insert every level at the front.
+    void appendUnsorted(int64_t price, double size)
+    {
+        if (size > 0.0) {
+            levels_.push_back(PriceLevel{price, size});
+        }
+    }
+
+    void sortLevels()
+    {
+        std::stable_sort(levels_.begin(), levels_.end(),
+                         [](const PriceLevel& a, const PriceLevel& b) { return worse(a.price, b.price); });
+        // A repeated price keeps its last size, as apply() would
+        auto last = std::unique(levels_.rbegin(), levels_.rend(),
+                                [](const PriceLevel& a, const PriceLevel& b) { return a.price == b.price; });
+        levels_.erase(levels_.begin(), last.base());
+    }
+
+    const PriceLevel* best() const { return levels_.empty() ? nullptr : &levels_.back(); }
+
+    // i-th level counting from the touch (0 = best)
+    const PriceLevel& level(size_t i) const { return levels_[levels_.size() - 1 - i]; }
+    size_t depth() const { return levels_.size(); }
+    void clear() { levels_.clear(); }
+
+private:
+    // Sort order: worse prices first, so the best one ends up at the back
+    static bool worse(int64_t a, int64_t b) { return IsBid ? a < b : a > b; }
+
+    std::vector<PriceLevel> levels_;
+};
+
+struct OrderBook {
+    BookSide<true> bids;
+    BookSide<false> asks;
+    bool valid = false;          // A snapshot has been applied since the last (re)sync
+    int64_t updatedNanos = 0;    // Monotonic time of the last applied message
+
+    void clear()
+    {
+        bids.clear();
+        asks.clear();
+        valid = false;
+    }
+};
+
+//------------------------------------------
+// TOP OF BOOK (SEQLOCK)
+//------------------------------------------
+// Published by the book thread, read by the strategy without locks. The writer bumps the
+// sequence to odd, writes, then bumps it to even; a reader retries if it saw an odd or
+// changed sequence. Fields are relaxed atomics so a torn read is never undefined behaviour.
+struct TopOfBook {
+    double bidPrice = 0.0;
+    double bidSize = 0.0;
+    double askPrice = 0.0;
+    double askSize = 0.0;
+    int64_t timestampNanos = 0;
+    bool valid = false;
+};
+
+class TopOfBookCell {
+public:
+    void publish(const TopOfBook& t)
+    {
+        uint64_t s = seq_.load(std::memory_order_relaxed);
+        seq_.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bidPrice_.store(t.bidPrice, std::memory_order_relaxed);
+        bidSize_.store(t.bidSize, std::memory_order_relaxed);
+        askPrice_.store(t.askPrice, std::memory_order_relaxed);
+        askSize_.store(t.askSize, std::memory_order_relaxed);
+        timestampNanos_.store(t.timestampNanos, std::memory_order_relaxed);
+        valid_.store(t.valid, std::memory_order_relaxed);
+        seq_.store(s + 2, std::memory_order_release);
+    }
+
+    TopOfBook read() const
+    {
+        TopOfBook t;
+        for (;;) {
+            uint64_t s1 = seq_.load(std::memory_order_acquire);
+            if (s1 & 1) {
+                continue;
+            }
+            t.bidPrice = bidPrice_.load(std::memory_order_relaxed);
+            t.bidSize = bidSize_.load(std::memory_order_relaxed);
+            t.askPrice = askPrice_.load(std::memory_order_relaxed);
+            t.askSize = askSize_.load(std::memory_order_relaxed);
+            t.timestampNanos = timestampNanos_.load(std::memory_order_relaxed);
+            t.valid = valid_.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq_.load(std::memory_order_relaxed) == s1) {
+                return t;
+            }
+        }
+    }
+
+private:
+    std::atomic<uint64_t> seq_{0};
+    std::atomic<double> bidPrice_{0.0};
+    std::atomic<double> bidSize_{0.0};
+    std::atomic<double> askPrice_{0.0};
+    std::atomic<double> askSize_{0.0};
+    std::atomic<int64_t> timestampNanos_{0};
+    std::atomic<bool> valid_{false};
+};
+
+//------------------------------------------
+// LEVEL2 FEED
+//------------------------------------------
+// Applies "l2_data" messages from the level2 channel to one book per product.
+// sequence_num counts every message on the connection; a missing number means a lost
+// update, so all books are invalidated and onMessage() returns false to make the
+// websocket resubscribe (which starts over with fresh snapshots).
+// Messages are parsed with a SAX handler into reusable buffers: no DOM, and no allocation
+// once the buffers have grown to the feed's usual message size.
+class Level2Feed {
+public:
+    // Startup only: one book per product, top of book published to `top`
+    void addProduct(const std::string& productId, TopOfBookCell* top)
+    {
+        products_.push_back(Product{productId, OrderBook{}, top});
+    }
+
+    // New connection: sequence numbers restart, books wait for their snapshot
+    void reset()
+    {
+        haveSequence_ = false;
+        for (Product& p : products_) {
+            p.book.clear();
+            publishTop(p, 0);
+        }
+    }
+
+    // Returns false when the feed must be resynced
+    bool onMessage(const std::string& msg, int64_t nowNanos)
+    {
+        parsed_.clear();
+        Parser parser(parsed_);
+        if (!nlohmann::json::sax_parse(msg, &parser)) {
+            return true; // Not ours to judge; skip malformed messages
+        }
+
+        if (parsed_.hasSequence) {
+            if (haveSequence_ && parsed_.sequence == 0) {
+                reset(); // A new connection numbers from 0 again (replays have no reconnect hook)
+            }
+            if (haveSequence_ && parsed_.sequence != lastSequence_ + 1) {
+                gaps_++;
+                reset();
+                return false;
+            }
+            haveSequence_ = true;
+            lastSequence_ = parsed_.sequence;
+        }
+        if (parsed_.channel != "l2_data") {
+            return true; // Subscription acks, heartbeats
+        }
+
+        for (size_t n = 0; n < parsed_.eventCount; n++) {
+            const ParsedEvent& e = parsed_.events[n];
+            Product* p = find(e.productId);
+            if (!p) {
+                continue;
+            }
+            if (e.snapshot) {
+                p->book.clear();
+                p->book.valid = true;
+            } else if (!p->book.valid) {
+                continue; // Updates before the snapshot are meaningless
+            }
+            if (e.snapshot) {
+                for (size_t i = e.firstUpdate; i < e.lastUpdate; i++) {
+                    const ParsedUpdate& u = parsed_.updates[i];
+                    if (u.bid) {
+                        p->book.bids.appendUnsorted(u.price, u.size);
+                    } else {
+                        p->book.asks.appendUnsorted(u.price, u.size);
+                    }
+                }
+                p->book.bids.sortLevels();
+                p->book.asks.sortLevels();
+            } else {
+                for (size_t i = e.firstUpdate; i < e.lastUpdate; i++) {
+                    const ParsedUpdate& u = parsed_.updates[i];
+                    if (u.bid) {
+                        p->book.bids.apply(u.price, u.size);
+                    } else {
+                        p->book.asks.apply(u.price, u.size);
+                    }
+                }
+            }
+            updates_ += e.lastUpdate - e.firstUpdate;
+            p->book.updatedNanos = nowNanos;
+            publishTop(*p, nowNanos);
+        }
+        return true;
+    }
+
+    const OrderBook* book(std::string_view productId) const
+    {
+        for (const Product& p : products_) {
+            if (p.productId == productId) {
+                return &p.book;
+            }
+        }
+        return nullptr;
+    }
+
+    uint64_t gaps() const { return gaps_; }
+    uint64_t updatesApplied() const { return updates_; }
+
+private:
+    struct Product {
+        std::string productId;
+        OrderBook book;
+        TopOfBookCell* top = nullptr;
+    };
+
+    struct ParsedUpdate {
+        bool bid = false;
+        int64_t price = 0;
+        double size = 0.0;
+    };
+
+    struct ParsedEvent {
+        bool snapshot = false;
+        std::string productId;
+        size_t firstUpdate = 0;  // [firstUpdate, lastUpdate) in ParsedMessage::updates
+        size_t lastUpdate = 0;
+    };
+
+    struct ParsedMessage {
+        std::string channel;
+        bool hasSequence = false;
+        uint64_t sequence = 0;
+        std::vector<ParsedEvent> events;  // Only [0, eventCount) are live; the rest are kept for reuse
+        size_t eventCount = 0;
+        std::vector<ParsedUpdate> updates;
+
+        void clear()
+        {
+            channel.clear();
+            hasSequence = false;
+            eventCount = 0;
+            updates.clear();
+        }
+    };
+
+    // depth 1: message, 2: events[], 3: event, 4: updates[], 5: update
+    class Parser : public nlohmann::json_sax<nlohmann::json> {
+    public:
+        explicit Parser(ParsedMessage& out) : out_(out) {}
+
+        bool null() override { return true; }
+        bool boolean(bool) override { return true; }
+        bool number_integer(number_integer_t val) override { return number(static_cast<uint64_t>(val)); }
+        bool number_unsigned(number_unsigned_t val) override { return number(val); }
+        bool number_float(number_float_t, const string_t&) override { return true; }
+        bool binary(binary_t&) override { return true; }
+
+        bool string(string_t& val) override
+        {
+            if (depth_ == 1 && key_ == Key::Channel) {
+                out_.channel = val;
+            } else if (depth_ == 3 && event_) {
+                if (key_ == Key::Type) {
+                    event_->snapshot = (val == "snapshot");
+                } else if (key_ == Key::ProductId) {
+                    event_->productId = val;
+                }
+            } else if (depth_ == 5) {
+                if (key_ == Key::Side) {
+                    update_.bid = (val == "bid");
+                } else if (key_ == Key::PriceLevel) {
+                    if (!parseScaledPrice(val, update_.price)) {
+                        update_.price = 0; // Dropped in end_object()
+                    }
+                } else if (key_ == Key::NewQuantity) {
+                    std::from_chars(val.data(), val.data() + val.size(), update_.size);
+                }
+            }
+            key_ = Key::Other;
+            return true;
+        }
+
+        bool key(string_t& val) override
+        {
+            key_ = Key::Other;
+            if (depth_ == 1) {
+                if (val == "channel") key_ = Key::Channel;
+                else if (val == "sequence_num") key_ = Key::Sequence;
+                else if (val == "events") key_ = Key::Events;
+            } else if (depth_ == 3) {
+                if (val == "type") key_ = Key::Type;
+                else if (val == "product_id") key_ = Key::ProductId;
+                else if (val == "updates") key_ = Key::Updates;
+            } else if (depth_ == 5) {
+                if (val == "side") key_ = Key::Side;
+                else if (val == "price_level") key_ = Key::PriceLevel;
+                else if (val == "new_quantity") key_ = Key::NewQuantity;
+            }
+            return true;
+        }
+
+        bool start_object(std::size_t) override
+        {
+            ++depth_;
+            if (depth_ == 3 && inEvents_) {
+                if (out_.eventCount == out_.events.size()) {
+                    out_.events.emplace_back();
+                }
+                event_ = &out_.events[out_.eventCount++];
+                event_->snapshot = false;
+                event_->productId.clear();
+                event_->firstUpdate = event_->lastUpdate = out_.updates.size();
+            } else if (depth_ == 5 && inUpdates_) {
+                update_ = ParsedUpdate{};
+            }
+            return true;
+        }
+
+        bool end_object() override
+        {
+            if (depth_ == 5 && inUpdates_) {
+                if (update_.price > 0) {
+                    out_.updates.push_back(update_);
+                }
+                event_->lastUpdate = out_.updates.size();
+            } else if (depth_ == 3) {
+                event_ = nullptr;
+            }
+            --depth_;
+            return true;
+        }
+
+        bool start_array(std::size_t) override
+        {
+            ++depth_;
+            if (depth_ == 2 && key_ == Key::Events) {
+                inEvents_ = true;
+            } else if (depth_ == 4 && key_ == Key::Updates && event_) {
+                inUpdates_ = true;
+            }
+            key_ = Key::Other;
+            return true;
+        }
+
+        bool end_array() override
+        {
+            if (depth_ == 2) {
+                inEvents_ = false;
+            } else if (depth_ == 4) {
+                inUpdates_ = false;
+            }
+            --depth_;
+            return true;
+        }
+
+        bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception&) override
+        {
+            return false;
+        }
+
+    private:
+        enum class Key : uint8_t { Other, Channel, Sequence, Events, Type, ProductId, Updates, Side, PriceLevel, NewQuantity };
+
+        bool number(uint64_t val)
+        {
+            if (depth_ == 1 && key_ == Key::Sequence) {
+                out_.hasSequence = true;
+                out_.sequence = val;
+            }
+            key_ = Key::Other;
+            return true;
+        }
+
+        ParsedMessage& out_;
+        ParsedEvent* event_ = nullptr;
+        ParsedUpdate update_;
+        Key key_ = Key::Other;
+        int depth_ = 0;
+        bool inEvents_ = false;
+        bool inUpdates_ = false;
+    };
+
+    Product* find(std::string_view productId)
+    {
+        for (Product& p : products_) {
+            if (p.productId == productId) {
+                return &p;
+            }
+        }
+        return nullptr;
+    }
+
+    static void publishTop(Product& p, int64_t nowNanos)
+    {
+        if (!p.top) {
+            return;
+        }
+        TopOfBook t;
+        const PriceLevel* bid = p.book.bids.best();
+        const PriceLevel* ask = p.book.asks.best();
+        t.valid = p.book.valid && bid && ask;
+        if (bid) {
+            t.bidPrice = scaledToDouble(bid->price);
+            t.bidSize = bid->size;
+        }
+        if (ask) {
+            t.askPrice = scaledToDouble(ask->price);
+            t.askSize = ask->size;
+        }
+        t.timestampNanos = nowNanos;
+        p.top->publish(t);
+    }
+
+    std::vector<Product> products_;
+    ParsedMessage parsed_;
+    bool haveSequence_ = false;
+    uint64_t lastSequence_ = 0;
+    uint64_t gaps_ = 0;
+    uint64_t updates_ = 0;
+};
+
+#endif // ORDER_BOOK_H
@@ -0,0 +1,92 @@
+// order_id.h
+#ifndef ORDER_ID_H
+#define ORDER_ID_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string>
+#include <string_view>
+
+//------------------------------------------
+// CLIENT ORDER IDS
+//------------------------------------------
+// "<prefix>-<counter>": the prefix is random per process, the counter is a relaxed
+// atomic, so IDs are unique across restarts and threads without a lock or allocation.
+// The same ID is resent on retry, letting the exchange deduplicate the order.
+
+// Fixed-size, trivially copyable ID so it can travel through the SPSC queues
+struct ClientOrderId {
+    static constexpr size_t kMaxLen = 39; // 13-char prefix + up to 20 digits
+    char data[kMaxLen + 1] = {};
+
+    // Truncates anything longer than kMaxLen
+    static ClientOrderId from(std::string_view s)
+    {
+        ClientOrderId id;
+        size_t n = s.size() < kMaxLen ? s.size() : kMaxLen;
+        std::memcpy(id.data, s.data(), n);
+        id.data[n] = '\0';
+        return id;
+    }
+
+    std::string_view view() const { return std::string_view(data); }
+    std::string str() const { return std::string(data); }
+    bool empty() const { return data[0] == '\0'; }
+
+    bool operator==(const ClientOrderId& other) const { return std::strcmp(data, other.data) == 0; }
+    bool operator!=(const ClientOrderId& other) const { return !(*this == other); }
+};
+
+class ClientOrderIdGenerator {
+public:
+    ClientOrderIdGenerator()
+    {
+        // 48 random bits mixed with the start time -> 12 hex chars
+        std::random_device rd;
+        uint64_t seed = (static_cast<uint64_t>(rd()) << 32) ^ rd()
+                        ^ static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+        static const char hex[] = "0123456789abcdef";
+        for (int i = 0; i < 12; i++) {
+            prefix_[i] = hex[(seed >> (i * 4)) & 0xF];
+        }
+        prefix_[12] = '-';
+    }
+
+    ClientOrderId next()
+    {
+        uint64_t n = counter_.fetch_add(1, std::memory_order_relaxed);
+
+        ClientOrderId id;
+        std::memcpy(id.data, prefix_, kPrefixLen);
+
+        // Counter in decimal, written back to front
+        char digits[20];
+        int len = 0;
+        do {
+            digits[len++] = static_cast<char>('0' + n % 10);
+            n /= 10;
+        } while (n > 0);
+        for (int i = 0; i < len; i++) {
+            id.data[kPrefixLen + i] = digits[len - 1 - i];
+        }
+        id.data[kPrefixLen + len] = '\0';
+        return id;
+    }
+
+private:
+    static constexpr size_t kPrefixLen = 13;
+    char prefix_[kPrefixLen] = {};
+    std::atomic<uint64_t> counter_{1};
+};
+
+// Process-wide generator
+inline ClientOrderIdGenerator& clientOrderIds()
+{
+    static ClientOrderIdGenerator instance;
+    return instance;
+}
+
+#endif // ORDER_ID_H
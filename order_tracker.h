@@ -0,0 +1,324 @@
+// order_tracker.h
+#ifndef ORDER_TRACKER_H
+#define ORDER_TRACKER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#include "order_id.h"
+
+//------------------------------------------
+// ORDER LIFECYCLE
+//------------------------------------------
+//   New -> Open -> PartiallyFilled -> Filled
+//    |      |            |
+//    |      +------------+--> Cancelled
+//    +--> Rejected
+// New is set when the order is handed to the gateway, Open when the exchange acks it.
+// Fill and status updates may arrive out of order (poll vs. stream), so fills are applied
+// from cumulative totals and never move an order backwards.
+
+enum class OrderState : uint8_t { New, Open, PartiallyFilled, Filled, Cancelled, Rejected };
+
+inline const char* orderStateName(OrderState s)
+{
+    switch (s) {
+        case OrderState::New: return "NEW";
+        case OrderState::Open: return "OPEN";
+        case OrderState::PartiallyFilled: return "PARTIALLY_FILLED";
+        case OrderState::Filled: return "FILLED";
+        case OrderState::Cancelled: return "CANCELLED";
+        case OrderState::Rejected: return "REJECTED";
+    }
+    return "UNKNOWN";
+}
+
+inline bool isTerminal(OrderState s)
+{
+    return s == OrderState::Filled || s == OrderState::Cancelled || s == OrderState::Rejected;
+}
+
+struct TrackedOrder {
+    ClientOrderId clientOrderId;
+    char exchangeOrderId[48] = {};
+    int sideSign = 0;           // +1 BUY, -1 SELL
+    double limitPrice = 0.0;
+    double quoteSize = 0.0;     // Requested notional
+    double filledBase = 0.0;    // Cumulative
+    double filledQuote = 0.0;   // Cumulative
+    OrderState state = OrderState::New;
+    bool editPending = false;   // An amend is on its way to the exchange
+    int64_t createdNanos = 0;
+    int64_t updatedNanos = 0;
+    int64_t lastEditNanos = 0;  // Last amend sent or refused by the risk check (0 = never)
+
+    double averageFillPrice() const { return filledBase > 0.0 ? filledQuote / filledBase : 0.0; }
+};
+
+//------------------------------------------
+// OPEN-ADDRESSING INDEX
+//------------------------------------------
+// Fixed-capacity hash table keyed by client order ID with linear probing and tombstones.
+// All storage is allocated up front; when tombstones pile up the table is rebuilt into a
+// second preallocated array, so steady-state operation never touches the allocator.
+class OrderIndex {
+public:
+    explicit OrderIndex(size_t capacity = 8192)
+    {
+        size_t cap = 16;
+        while (cap < capacity * 2) {
+            cap <<= 1; // Keep load factor <= 0.5
+        }
+        slots_.resize(cap);
+        spare_.resize(cap);
+        mask_ = cap - 1;
+        maxLive_ = capacity;
+    }
+
+    // Returns nullptr when the table is full
+    TrackedOrder* insert(const TrackedOrder& order)
+    {
+        if (live_ >= maxLive_) {
+            return nullptr;
+        }
+        if (live_ + tombstones_ >= slots_.size() / 2) {
+            rebuild();
+        }
+        size_t i = hash(order.clientOrderId.view()) & mask_;
+        while (slots_[i].state == SlotState::Live) {
+            if (slots_[i].order.clientOrderId == order.clientOrderId) {
+                return &slots_[i].order; // Already tracked
+            }
+            i = (i + 1) & mask_;
+        }
+        if (slots_[i].state == SlotState::Tombstone) {
+            tombstones_--;
+        }
+        slots_[i].state = SlotState::Live;
+        slots_[i].order = order;
+        live_++;
+        return &slots_[i].order;
+    }
+
+    TrackedOrder* find(std::string_view clientOrderId)
+    {
+        Slot* slot = findSlot(clientOrderId);
+        return slot ? &slot->order : nullptr;
+    }
+
+    bool erase(std::string_view clientOrderId)
+    {
+        Slot* slot = findSlot(clientOrderId);
+        if (!slot) {
+            return false;
+        }
+        slot->state = SlotState::Tombstone;
+        live_--;
+        tombstones_++;
+        return true;
+    }
+
+    size_t size() const { return live_; }
+
+    template <typename Fn>
+    void forEach(Fn&& fn)
+    {
+        for (Slot& s : slots_) {
+            if (s.state == SlotState::Live) {
+                fn(s.order);
+            }
+        }
+    }
+
+private:
+    enum class SlotState : uint8_t { Empty, Live, Tombstone };
+
+    struct Slot {
+        TrackedOrder order;
+        SlotState state = SlotState::Empty;
+    };
+
+    Slot* findSlot(std::string_view clientOrderId)
+    {
+        size_t i = hash(clientOrderId) & mask_;
+        while (slots_[i].state != SlotState::Empty) {
+            if (slots_[i].state == SlotState::Live && slots_[i].order.clientOrderId.view() == clientOrderId) {
+                return &slots_[i];
+            }
+            i = (i + 1) & mask_;
+        }
+        return nullptr;
+    }
+
+    static size_t hash(std::string_view key)
+    {
+        uint64_t h = 1469598103934665603ull; // FNV-1a
+        for (char c : key) {
+            h ^= static_cast<unsigned char>(c);
+            h *= 1099511628211ull;
+        }
+        return static_cast<size_t>(h ^ (h >> 32));
+    }
+
+    void rebuild()
+    {
+        for (Slot& s : spare_) {
+            s.state = SlotState::Empty;
+        }
+        for (Slot& s : slots_) {
+            if (s.state != SlotState::Live) {
+                continue;
+            }
+            size_t i = hash(s.order.clientOrderId.view()) & mask_;
+            while (spare_[i].state == SlotState::Live) {
+                i = (i + 1) & mask_;
+            }
+            spare_[i] = s;
+        }
+        slots_.swap(spare_);
+        tombstones_ = 0;
+    }
+
+    std::vector<Slot> slots_;
+    std::vector<Slot> spare_;
+    size_t mask_ = 0;
+    size_t live_ = 0;
+    size_t tombstones_ = 0;
+    size_t maxLive_ = 0;
+};
+
+//------------------------------------------
+// TRACKER
+//------------------------------------------
+// Owned by the strategy thread. Every update returns the fill delta it produced so the
+// caller can move risk/position state by exactly what was filled.
+struct FillDelta {
+    double base = 0.0;
+    double quote = 0.0;
+    bool stateChanged = false;
+};
+
+class OrderTracker {
+public:
+    explicit OrderTracker(size_t capacity = 8192) : index_(capacity) {}
+
+    TrackedOrder* onSubmitted(const ClientOrderId& id, int sideSign, double limitPrice, double quoteSize, int64_t nowNanos)
+    {
+        TrackedOrder o;
+        o.clientOrderId = id;
+        o.sideSign = sideSign;
+        o.limitPrice = limitPrice;
+        o.quoteSize = quoteSize;
+        o.state = OrderState::New;
+        o.createdNanos = nowNanos;
+        o.updatedNanos = nowNanos;
+        return index_.insert(o);
+    }
+
+    // Exchange acknowledged the order
+    bool onAccepted(std::string_view id, std::string_view exchangeOrderId, int64_t nowNanos)
+    {
+        TrackedOrder* o = index_.find(id);
+        if (!o || o->state != OrderState::New) {
+            return false;
+        }
+        size_t n = std::min(exchangeOrderId.size(), sizeof(o->exchangeOrderId) - 1);
+        std::memcpy(o->exchangeOrderId, exchangeOrderId.data(), n);
+        o->exchangeOrderId[n] = '\0';
+        o->state = OrderState::Open;
+        o->updatedNanos = nowNanos;
+        return true;
+    }
+
+    // Cumulative fill totals (from the user channel or a status poll).
+    // done = the exchange reports the order as fully filled.
+    FillDelta onFill(std::string_view id, double cumulativeBase, double cumulativeQuote, bool done, int64_t nowNanos)
+    {
+        FillDelta d;
+        TrackedOrder* o = index_.find(id);
+        if (!o || isTerminal(o->state)) {
+            return d;
+        }
+        if (cumulativeBase > o->filledBase) {
+            d.base = cumulativeBase - o->filledBase;
+            d.quote = cumulativeQuote - o->filledQuote;
+            o->filledBase = cumulativeBase;
+            o->filledQuote = cumulativeQuote;
+        }
+        OrderState next = done ? OrderState::Filled
+                               : (o->filledBase > 0.0 ? OrderState::PartiallyFilled : o->state);
+        d.stateChanged = (next != o->state);
+        o->state = next;
+        o->updatedNanos = nowNanos;
+        return d;
+    }
+
+    // Cancelled/expired (cancel == true) or rejected/failed by the exchange
+    bool onClosed(std::string_view id, bool cancel, int64_t nowNanos)
+    {
+        TrackedOrder* o = index_.find(id);
+        if (!o || isTerminal(o->state)) {
+            return false;
+        }
+        o->state = cancel ? OrderState::Cancelled : OrderState::Rejected;
+        o->updatedNanos = nowNanos;
+        return true;
+    }
+
+    // Price amend sent for a resting order; at most one in flight per order
+    bool onEditSent(std::string_view id, int64_t nowNanos)
+    {
+        TrackedOrder* o = index_.find(id);
+        if (!o || isTerminal(o->state) || o->editPending) {
+            return false;
+        }
+        o->editPending = true;
+        o->lastEditNanos = nowNanos;
+        return true;
+    }
+
+    // Amend answered; on success the order now rests at newLimitPrice
+    bool onEditResult(std::string_view id, bool accepted, double newLimitPrice, int64_t nowNanos)
+    {
+        TrackedOrder* o = index_.find(id);
+        if (!o || !o->editPending) {
+            return false;
+        }
+        o->editPending = false;
+        if (accepted) {
+            o->limitPrice = newLimitPrice;
+        }
+        o->updatedNanos = nowNanos;
+        return true;
+    }
+
+    // Restart: put back an order recovered from the state journal as-is
+    TrackedOrder* restore(const TrackedOrder& order) { return index_.insert(order); }
+
+    TrackedOrder* find(std::string_view id) { return index_.find(id); }
+
+    // Drop a terminal order once its final state has been consumed
+    void release(std::string_view id) { index_.erase(id); }
+
+    // Orders in the index (terminal ones stay until release())
+    size_t trackedOrders() const { return index_.size(); }
+
+    template <typename Fn>
+    void forEachOpen(Fn&& fn)
+    {
+        index_.forEach([&](TrackedOrder& o) {
+            if (!isTerminal(o.state)) {
+                fn(o);
+            }
+        });
+    }
+
+private:
+    OrderIndex index_;
+};
+
+#endif // ORDER_TRACKER_H
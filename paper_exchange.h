@@ -0,0 +1,461 @@
+// paper_exchange.h
+#ifndef PAPER_EXCHANGE_H
+#define PAPER_EXCHANGE_H
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "order_book.h"
+#include "user_channel.h"   // UserOrderEvent
+
+//------------------------------------------
+// PAPER EXCHANGE
+//------------------------------------------
+// In-process stand-in for the Advanced Trade order endpoints. It takes the same request
+// bodies and answers with the same JSON the exchange would, so placeLimitOrder(),
+// editLimitOrder(), cancelOrders() and getOrderStatus() run unchanged on top of it.
+// Fills are pushed through the same UserOrderEvent callback as the real user channel.
+//
+// Matching model for resting post-only orders:
+//   - Post-only: a BUY at or above the best ask (SELL at or below the best bid) is rejected.
+//   - Queue position: an order joins the back of its price level, behind the size the
+//     book showed there. The queue ahead only shrinks: by trades at our price, and by
+//     cancellations (the level shrinking below the queue ahead).
+//   - Trades at our price fill us once the queue ahead is used up; trades through our
+//     price fill us up to the trade size. Partial fills accumulate until the order is done.
+// Market data comes from the level2 book (onBook) and the market_trades channel (onMarketMessage).
+// All entry points lock one mutex; the work per call is a scan of the open orders. Filled and
+// cancelled orders move to a bounded history that still answers status queries. Order events
+// from every entry point are queued and handed to the callback only by deliverEvents(), so
+// they reach it from one thread (the callback may feed a single-producer queue) and after
+// the mutex is released (the callback may call back into the exchange).
+class PaperExchange {
+public:
+    using OrderCallback = std::function<void(const UserOrderEvent&)>;
+
+    void setOrderCallback(OrderCallback cb) { onOrder_ = std::move(cb); }
+
+    // True for the REST endpoints this simulator answers
+    static bool handles(std::string_view url) { return url.find("/api/v3/brokerage/orders") != std::string_view::npos; }
+
+    // REST entry point: returns the HTTP status and fills `response` with the body
+    long handle(const std::string& method, std::string_view url, const std::string& body, std::string& response)
+    {
+        return handleLocked(method, url, body, response);
+    }
+
+    // Level2 book changed (call on the book thread after each applied message)
+    void onBook(const std::string& productId, const OrderBook& book)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Market& m = market(productId);
+        const PriceLevel* bid = book.bids.best();
+        const PriceLevel* ask = book.asks.best();
+        m.bestBid = bid ? bid->price : 0;
+        m.bestAsk = ask ? ask->price : 0;
+        // Copy the levels near the touch: the book itself keeps changing on the feed thread
+        m.bids.clear();
+        m.asks.clear();
+        for (size_t i = 0; i < book.bids.depth() && i < kSnapshotLevels; i++) {
+            m.bids.push_back(book.bids.level(i));
+        }
+        for (size_t i = 0; i < book.asks.depth() && i < kSnapshotLevels; i++) {
+            m.asks.push_back(book.asks.level(i));
+        }
+        // Size that left our level can only have come from ahead of us (or been traded,
+        // which the trade stream already counted). Levels past the copied ones are unknown.
+        for (Order& o : orders_) {
+            if (o.productId == productId && withinSnapshot(m, o.buy, o.price)) {
+                o.queueAhead = std::min(o.queueAhead, levelSize(m, o.buy, o.price));
+            }
+        }
+    }
+
+    // market_trades channel message
+    void onMarketMessage(const std::string& msg)
+    {
+        nlohmann::json j = nlohmann::json::parse(msg, nullptr, false);
+        if (j.is_discarded() || j.value("channel", "") != "market_trades" || !j.contains("events")) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const auto& event : j["events"]) {
+                // A (re)subscribe replays recent trades as a snapshot: those prints are stale
+                if (!event.contains("trades") || event.value("type", "") == "snapshot") {
+                    continue;
+                }
+                for (const auto& t : event["trades"]) {
+                    int64_t price = 0;
+                    if (!parseScaledPrice(t.value("price", ""), price)) {
+                        continue;
+                    }
+                    onTrade(t.value("product_id", ""), price, std::atof(t.value("size", "0").c_str()));
+                }
+            }
+            retireClosedOrders();
+        }
+    }
+
+    // Hands the queued order events to the callback. Call from one thread only, and not from
+    // inside the callback.
+    void deliverEvents()
+    {
+        std::vector<UserOrderEvent> events;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            events.swap(pending_);
+        }
+        for (const UserOrderEvent& e : events) {
+            onOrder_(e);
+        }
+    }
+
+    size_t openOrders() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return orders_.size(); // Closed orders are retired before every entry point returns
+    }
+
+private:
+    enum class Status : uint8_t { Open, Filled, Cancelled };
+
+    struct Order {
+        std::string orderId;
+        std::string clientOrderId;
+        std::string productId;
+        bool buy = true;
+        int64_t price = 0;          // Scaled, see kPriceScale
+        double baseSize = 0.0;
+        double filledBase = 0.0;
+        double filledQuote = 0.0;
+        double queueAhead = 0.0;    // Base size in front of us at our level
+        Status status = Status::Open;
+
+        bool open() const { return status == Status::Open; }
+        double remaining() const { return baseSize - filledBase; }
+    };
+
+    static constexpr size_t kSnapshotLevels = 64;     // Levels kept per side for queue position
+    static constexpr size_t kMaxClosedOrders = 4096;  // Filled/cancelled orders kept for status queries
+
+    struct Market {
+        std::string productId;
+        int64_t bestBid = 0;
+        int64_t bestAsk = 0;
+        std::vector<PriceLevel> bids; // Best first
+        std::vector<PriceLevel> asks;
+    };
+
+    long handleLocked(const std::string& method, std::string_view url, const std::string& body, std::string& response)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::string_view path = url.substr(url.find("/api/v3/brokerage/orders"));
+        nlohmann::json req = body.empty() ? nlohmann::json::object() : nlohmann::json::parse(body, nullptr, false);
+        if (req.is_discarded()) {
+            response = R"({"error":"INVALID_ARGUMENT","message":"malformed body"})";
+            return 400;
+        }
+
+        nlohmann::json out;
+        long status = 200;
+        if (method == "POST" && path == "/api/v3/brokerage/orders") {
+            out = place(req);
+        } else if (method == "POST" && path == "/api/v3/brokerage/orders/edit") {
+            out = edit(req);
+        } else if (method == "POST" && path == "/api/v3/brokerage/orders/batch_cancel") {
+            out = cancel(req);
+        } else if (method == "GET" && path.rfind("/api/v3/brokerage/orders/historical/", 0) == 0) {
+            std::string_view id = path.substr(std::string_view("/api/v3/brokerage/orders/historical/").size());
+            Order* o = findByOrderId(id);
+            if (!o) {
+                out = {{"error", "NOT_FOUND"}, {"message", "order not found"}};
+                status = 404;
+            } else {
+                out["order"] = describe(*o);
+            }
+        } else {
+            out = {{"error", "UNIMPLEMENTED"}, {"message", "not simulated"}};
+            status = 404;
+        }
+        retireClosedOrders();
+        response = out.dump();
+        return status;
+    }
+
+    nlohmann::json place(const nlohmann::json& req)
+    {
+        std::string clientId = req.value("client_order_id", "");
+        // Same client_order_id -> same order, like the exchange
+        if (!clientId.empty()) {
+            for (const Order& o : orders_) {
+                if (o.clientOrderId == clientId) {
+                    return success(o);
+                }
+            }
+            for (const Order& o : closed_) {
+                if (o.clientOrderId == clientId) {
+                    return success(o);
+                }
+            }
+        }
+
+        const nlohmann::json* cfg = nullptr;
+        if (req.contains("order_configuration") && req["order_configuration"].contains("limit_limit_gtc")) {
+            cfg = &req["order_configuration"]["limit_limit_gtc"];
+        }
+        if (!cfg) {
+            return failure("UNSUPPORTED_ORDER_CONFIGURATION", "paper trading only simulates limit_limit_gtc");
+        }
+
+        Order o;
+        o.clientOrderId = clientId;
+        o.productId = req.value("product_id", "");
+        o.buy = req.value("side", "") == "BUY";
+        if (!parseScaledPrice(cfg->value("limit_price", ""), o.price) || o.price <= 0) {
+            return failure("INVALID_LIMIT_PRICE", "bad limit_price");
+        }
+        double px = scaledToDouble(o.price);
+        if (cfg->contains("base_size")) {
+            o.baseSize = std::atof(cfg->value("base_size", "0").c_str());
+        } else {
+            o.baseSize = std::atof(cfg->value("quote_size", "0").c_str()) / px;
+        }
+        if (o.baseSize <= 0.0) {
+            return failure("INVALID_SIZE", "order size must be positive");
+        }
+
+        Market& m = market(o.productId);
+        if (cfg->value("post_only", false) && crosses(m, o.buy, o.price)) {
+            return failure("INVALID_LIMIT_PRICE_POST_ONLY", "post-only order would cross the book");
+        }
+
+        o.orderId = "paper-" + std::to_string(nextOrderId_++);
+        o.queueAhead = levelSize(m, o.buy, o.price);
+        orders_.push_back(o);
+        notify(orders_.back());
+        return success(orders_.back());
+    }
+
+    nlohmann::json edit(const nlohmann::json& req)
+    {
+        Order* o = findByOrderId(req.value("order_id", ""));
+        if (!o || !o->open()) {
+            return editFailure("ORDER_NOT_FOUND");
+        }
+        int64_t price = o->price;
+        if (req.contains("price") && !parseScaledPrice(req.value("price", ""), price)) {
+            return editFailure("INVALID_PRICE");
+        }
+        double size = req.contains("size") ? std::atof(req.value("size", "0").c_str()) : o->baseSize;
+        if (size <= o->filledBase) {
+            return editFailure("INVALID_SIZE");
+        }
+        if (crosses(market(o->productId), o->buy, price)) {
+            return editFailure("INVALID_LIMIT_PRICE_POST_ONLY");
+        }
+        // A new price goes to the back of the new level; only a size decrease keeps priority
+        if (price != o->price || size > o->baseSize) {
+            o->queueAhead = levelSize(market(o->productId), o->buy, price);
+        }
+        o->price = price;
+        o->baseSize = size;
+        return {{"success", true}, {"errors", nlohmann::json::array()}};
+    }
+
+    nlohmann::json cancel(const nlohmann::json& req)
+    {
+        nlohmann::json results = nlohmann::json::array();
+        for (const auto& idJson : req.value("order_ids", nlohmann::json::array())) {
+            std::string id = idJson.get<std::string>();
+            Order* o = findByOrderId(id);
+            bool ok = o && o->open();
+            if (ok) {
+                o->status = Status::Cancelled;
+                notify(*o);
+            }
+            results.push_back({{"success", ok}, {"failure_reason", ok ? "UNKNOWN_CANCEL_FAILURE_REASON" : "UNKNOWN_CANCEL_ORDER"},
+                               {"order_id", id}});
+        }
+        return {{"results", results}};
+    }
+
+    void onTrade(const std::string& productId, int64_t price, double size)
+    {
+        for (Order& o : orders_) {
+            if (!o.open() || o.productId != productId || size <= 0.0) {
+                continue;
+            }
+            bool through = o.buy ? price < o.price : price > o.price;
+            bool atPrice = price == o.price;
+            if (!through && !atPrice) {
+                continue;
+            }
+            double available = size;
+            if (atPrice) {
+                double used = std::min(o.queueAhead, available);
+                o.queueAhead -= used;
+                available -= used;
+            }
+            double fill = std::min(available, o.remaining());
+            if (fill <= 0.0) {
+                continue;
+            }
+            o.filledBase += fill;
+            o.filledQuote += fill * scaledToDouble(o.price); // Maker fills at our limit
+            if (o.remaining() <= o.baseSize * 1e-9) {
+                o.status = Status::Filled;
+            }
+            notify(o);
+        }
+    }
+
+    // Would a resting order at this price take liquidity right now?
+    static bool crosses(const Market& m, bool buy, int64_t price)
+    {
+        return buy ? (m.bestAsk > 0 && price >= m.bestAsk) : (m.bestBid > 0 && price <= m.bestBid);
+    }
+
+    // Is this price within the levels copied by onBook (or is the whole side copied)?
+    static bool withinSnapshot(const Market& m, bool buy, int64_t price)
+    {
+        const std::vector<PriceLevel>& levels = buy ? m.bids : m.asks;
+        if (levels.size() < kSnapshotLevels) {
+            return true;
+        }
+        return buy ? price >= levels.back().price : price <= levels.back().price;
+    }
+
+    // Visible size at our side's price level (0 if the level is empty or beyond the snapshot)
+    static double levelSize(const Market& m, bool buy, int64_t price)
+    {
+        for (const PriceLevel& l : buy ? m.bids : m.asks) {
+            if (l.price == price) {
+                return l.size;
+            }
+            if (buy ? l.price < price : l.price > price) {
+                break;
+            }
+        }
+        return 0.0;
+    }
+
+    Market& market(const std::string& productId)
+    {
+        for (Market& m : markets_) {
+            if (m.productId == productId) {
+                return m;
+            }
+        }
+        Market m;
+        m.productId = productId;
+        markets_.push_back(std::move(m));
+        return markets_.back();
+    }
+
+    Order* findByOrderId(std::string_view id)
+    {
+        for (Order& o : orders_) {
+            if (o.orderId == id) {
+                return &o;
+            }
+        }
+        for (Order& o : closed_) {
+            if (o.orderId == id) {
+                return &o;
+            }
+        }
+        return nullptr;
+    }
+
+    // Moves filled/cancelled orders out of the open list, keeping the newest kMaxClosedOrders
+    void retireClosedOrders()
+    {
+        auto firstClosed = std::stable_partition(orders_.begin(), orders_.end(), [](const Order& o) { return o.open(); });
+        for (auto it = firstClosed; it != orders_.end(); ++it) {
+            closed_.push_back(std::move(*it));
+        }
+        orders_.erase(firstClosed, orders_.end());
+        while (closed_.size() > kMaxClosedOrders) {
+            closed_.pop_front();
+        }
+    }
+
+    static const char* statusName(Status s)
+    {
+        switch (s) {
+            case Status::Open: return "OPEN";
+            case Status::Filled: return "FILLED";
+            case Status::Cancelled: return "CANCELLED";
+        }
+        return "UNKNOWN";
+    }
+
+    nlohmann::json describe(const Order& o) const
+    {
+        return {{"order_id", o.orderId}, {"client_order_id", o.clientOrderId}, {"product_id", o.productId},
+                {"side", o.buy ? "BUY" : "SELL"}, {"status", statusName(o.status)},
+                {"filled_size", decimal(o.filledBase)}, {"filled_value", decimal(o.filledQuote)}};
+    }
+
+    // Exchange-style decimal string (satoshi precision)
+    static std::string decimal(double x)
+    {
+        char buf[64];
+        std::snprintf(buf, sizeof(buf), "%.8f", x);
+        return buf;
+    }
+
+    static nlohmann::json success(const Order& o)
+    {
+        return {{"success", true},
+                {"success_response", {{"order_id", o.orderId}, {"product_id", o.productId},
+                                      {"side", o.buy ? "BUY" : "SELL"}, {"client_order_id", o.clientOrderId}}}};
+    }
+
+    static nlohmann::json failure(const char* error, const char* message)
+    {
+        return {{"success", false}, {"error_response", {{"error", error}, {"message", message}}}};
+    }
+
+    static nlohmann::json editFailure(const char* reason)
+    {
+        return {{"success", false}, {"errors", {{{"edit_failure_reason", reason}}}}};
+    }
+
+    // Queues the order's event for deliverEvents()
+    void notify(const Order& o)
+    {
+        if (!onOrder_) {
+            return;
+        }
+        UserOrderEvent e;
+        e.orderId = o.orderId;
+        e.clientOrderId = o.clientOrderId;
+        e.status = statusName(o.status);
+        e.cumulativeBase = o.filledBase;
+        e.cumulativeQuote = o.filledQuote;
+        pending_.push_back(std::move(e));
+    }
+
+    mutable std::mutex mutex_;
+    std::vector<Order> orders_;              // Open orders only
+    std::deque<Order> closed_;               // Recently filled/cancelled, oldest first
+    std::vector<UserOrderEvent> pending_;    // Events not yet delivered
+    std::vector<Market> markets_;
+    uint64_t nextOrderId_ = 1;
+    OrderCallback onOrder_;
+};
+
+#endif // PAPER_EXCHANGE_H
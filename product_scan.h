@@ -0,0 +1,227 @@
+// product_scan.h
+#ifndef PRODUCT_SCAN_H
+#define PRODUCT_SCAN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "indicator_kernels.h"   // SimdLevel, activeSimdLevel, KERNEL_TARGET
+#include "strategy.h"            // Decision, ExitOnBearishWithProfit
+
+//------------------------------------------
+// CROSS-PRODUCT SCAN
+//------------------------------------------
+// MaCrossoverStrategy's entry/exit rules for many products in one pass. Per-product state
+// is kept as columns (structure of arrays) instead of one Strategy object per product:
+//   shortMA, longMA, lastBuyPrice   doubles, written by the market-data side / fills
+//   wasBelow, havePosition, orderInFlight   one byte per product (0/1)
+// evaluate() makes two passes over blocks of eight products. The first turns the MA
+// comparisons into one 8-bit mask per block (one AVX-512 compare, or two AVX2 compares,
+// per condition). The second folds the byte flags into masks as well, so the buy/sell
+// conditions are a few integer ANDs per block. Only products that act are written to the
+// output list.
+//
+// The rules and their floating-point operations are the same as MaCrossSignal +
+// EnterOnCrossUp + ExitOnBearishWithProfit<MinProfitBps>, so a product here decides exactly
+// what a Strategy would decide on the same inputs.
+
+struct ScanAction {
+    uint32_t product = 0;
+    Decision::Action action = Decision::Action::None;
+    double minPrice = 0.0;   // Exit: lowest acceptable limit price
+};
+
+// Eight 0/1 bytes -> 8-bit mask (byte k -> bit k)
+inline unsigned packByteFlags(const uint8_t* flags)
+{
+    uint64_t v;
+    std::memcpy(&v, flags, sizeof(v));
+    return static_cast<unsigned>(((v & 0x0101010101010101ULL) * 0x0102040810204080ULL) >> 56);
+}
+
+// 8-bit mask -> eight 0/1 bytes
+inline void unpackByteFlags(unsigned mask, uint8_t* flags)
+{
+    uint64_t v = ((((mask * 0x0101010101010101ULL) & 0x8040201008040201ULL) + 0x7F7F7F7F7F7F7F7FULL) >> 7)
+                 & 0x0101010101010101ULL;
+    std::memcpy(flags, &v, sizeof(v));
+}
+
+// MA comparison masks, one byte per block of 8 products (bit k = product 8 * block + k):
+//   above:  shortMA > longMA
+//   below:  shortMA < longMA
+//   profit: shortMA >= lastBuyPrice * multiplier
+inline void crossMasksScalar(const double* s, const double* l, const double* lastBuy, double multiplier,
+                             size_t blocks, uint8_t* above, uint8_t* below, uint8_t* profit)
+{
+    for (size_t b = 0; b < blocks; b++) {
+        unsigned up = 0;
+        unsigned down = 0;
+        unsigned gain = 0;
+        for (unsigned k = 0; k < 8; k++) {
+            size_t i = b * 8 + k;
+            up |= static_cast<unsigned>(s[i] > l[i]) << k;
+            down |= static_cast<unsigned>(s[i] < l[i]) << k;
+            gain |= static_cast<unsigned>(s[i] >= lastBuy[i] * multiplier) << k;
+        }
+        above[b] = static_cast<uint8_t>(up);
+        below[b] = static_cast<uint8_t>(down);
+        profit[b] = static_cast<uint8_t>(gain);
+    }
+}
+
+#ifdef INDICATOR_KERNELS_X86
+KERNEL_TARGET("avx2")
+inline void crossMasksAvx2(const double* s, const double* l, const double* lastBuy, double multiplier,
+                           size_t blocks, uint8_t* above, uint8_t* below, uint8_t* profit)
+{
+    const __m256d mult = _mm256_set1_pd(multiplier);
+    for (size_t b = 0; b < blocks; b++) {
+        unsigned up = 0;
+        unsigned down = 0;
+        unsigned gain = 0;
+        for (unsigned h = 0; h < 8; h += 4) {
+            size_t i = b * 8 + h;
+            __m256d sv = _mm256_loadu_pd(s + i);
+            __m256d lv = _mm256_loadu_pd(l + i);
+            __m256d floor = _mm256_mul_pd(_mm256_loadu_pd(lastBuy + i), mult);
+            up |= static_cast<unsigned>(_mm256_movemask_pd(_mm256_cmp_pd(sv, lv, _CMP_GT_OQ))) << h;
+            down |= static_cast<unsigned>(_mm256_movemask_pd(_mm256_cmp_pd(sv, lv, _CMP_LT_OQ))) << h;
+            gain |= static_cast<unsigned>(_mm256_movemask_pd(_mm256_cmp_pd(sv, floor, _CMP_GE_OQ))) << h;
+        }
+        above[b] = static_cast<uint8_t>(up);
+        below[b] = static_cast<uint8_t>(down);
+        profit[b] = static_cast<uint8_t>(gain);
+    }
+}
+
+KERNEL_TARGET("avx512f")
+inline void crossMasksAvx512(const double* s, const double* l, const double* lastBuy, double multiplier,
+                             size_t blocks, uint8_t* above, uint8_t* below, uint8_t* profit)
+{
+    const __m512d mult = _mm512_set1_pd(multiplier);
+    for (size_t b = 0; b < blocks; b++) {
+        __m512d sv = _mm512_loadu_pd(s + b * 8);
+        __m512d lv = _mm512_loadu_pd(l + b * 8);
+        __m512d floor = _mm512_mul_pd(_mm512_loadu_pd(lastBuy + b * 8), mult);
+        above[b] = static_cast<uint8_t>(_mm512_cmp_pd_mask(sv, lv, _CMP_GT_OQ));
+        below[b] = static_cast<uint8_t>(_mm512_cmp_pd_mask(sv, lv, _CMP_LT_OQ));
+        profit[b] = static_cast<uint8_t>(_mm512_cmp_pd_mask(sv, floor, _CMP_GE_OQ));
+    }
+}
+#endif // INDICATOR_KERNELS_X86
+
+template <int MinProfitBps = 130>
+class MaCrossScan {
+public:
+    static constexpr double kExitMultiplier = ExitOnBearishWithProfit<MinProfitBps>::kMultiplier;
+
+    // Startup only: returns the product's column index
+    uint32_t addProduct()
+    {
+        uint32_t index = static_cast<uint32_t>(count_++);
+        // Columns stay a whole number of 8-product blocks; padding never acts
+        // (equal MAs are neither above nor below, and it holds no position)
+        size_t padded = (count_ + 7) / 8 * 8;
+        shortMA_.resize(padded, 0.0);
+        longMA_.resize(padded, 0.0);
+        lastBuyPrice_.resize(padded, 0.0);
+        wasBelow_.resize(padded, 0);
+        havePosition_.resize(padded, 0);
+        orderInFlight_.resize(padded, 0);
+        above_.resize(padded / 8);
+        below_.resize(padded / 8);
+        profit_.resize(padded / 8);
+        return index;
+    }
+
+    size_t size() const { return count_; }
+
+    // Per-tick inputs
+    void setMovingAverages(uint32_t product, double shortMA, double longMA)
+    {
+        shortMA_[product] = shortMA;
+        longMA_[product] = longMA;
+    }
+    double* shortMA() { return shortMA_.data(); }   // Bulk writes, e.g. from smaBatch
+    double* longMA() { return longMA_.data(); }
+
+    // Position and order state, from fills and order updates
+    void setPosition(uint32_t product, bool havePosition, double lastBuyPrice)
+    {
+        havePosition_[product] = havePosition;
+        lastBuyPrice_[product] = lastBuyPrice;
+    }
+    void setOrderInFlight(uint32_t product, bool inFlight) { orderInFlight_[product] = inFlight; }
+
+    bool havePosition(uint32_t product) const { return havePosition_[product] != 0; }
+    bool orderInFlight(uint32_t product) const { return orderInFlight_[product] != 0; }
+
+    // One pass over every product: replaces `actions` with the products that enter or exit.
+    // Allocation-free once `actions` has grown to its usual size.
+    void evaluate(std::vector<ScanAction>& actions, SimdLevel level = activeSimdLevel())
+    {
+        actions.clear();
+        size_t blocks = shortMA_.size() / 8;
+        computeMasks(blocks, level);
+        for (size_t b = 0; b < blocks; b++) {
+            size_t i = b * 8;
+            unsigned wasBelow = packByteFlags(&wasBelow_[i]);
+            unsigned position = packByteFlags(&havePosition_[i]);
+            unsigned free = ~packByteFlags(&orderInFlight_[i]) & 0xFF;
+
+            unsigned enter = wasBelow & above_[b] & ~position & free;  // EnterOnCrossUp
+            unsigned exit = position & below_[b] & profit_[b] & free;  // ExitOnBearishWithProfit
+            unpackByteFlags(below_[b], &wasBelow_[i]);
+
+            for (unsigned act = enter | exit, k = 0; act; act >>= 1, k++) {
+                if (act & 1) {
+                    ScanAction a;
+                    a.product = static_cast<uint32_t>(i + k);
+                    if (enter & (1u << k)) {
+                        a.action = Decision::Action::Enter;
+                    } else {
+                        a.action = Decision::Action::Exit;
+                        a.minPrice = lastBuyPrice_[i + k] * kExitMultiplier;
+                    }
+                    actions.push_back(a);
+                }
+            }
+        }
+    }
+
+private:
+    void computeMasks(size_t blocks, SimdLevel level)
+    {
+        const double* sm = shortMA_.data();
+        const double* lm = longMA_.data();
+        const double* lb = lastBuyPrice_.data();
+#ifdef INDICATOR_KERNELS_X86
+        if (level == SimdLevel::Avx512) {
+            crossMasksAvx512(sm, lm, lb, kExitMultiplier, blocks, above_.data(), below_.data(), profit_.data());
+            return;
+        }
+        if (level == SimdLevel::Avx2) {
+            crossMasksAvx2(sm, lm, lb, kExitMultiplier, blocks, above_.data(), below_.data(), profit_.data());
+            return;
+        }
+#endif
+        (void)level;
+        crossMasksScalar(sm, lm, lb, kExitMultiplier, blocks, above_.data(), below_.data(), profit_.data());
+    }
+
+    size_t count_ = 0;
+    std::vector<double> shortMA_;
+    std::vector<double> longMA_;
+    std::vector<double> lastBuyPrice_;
+    std::vector<uint8_t> wasBelow_;
+    std::vector<uint8_t> havePosition_;
+    std::vector<uint8_t> orderInFlight_;
+    std::vector<uint8_t> above_;    // Per-block masks, rebuilt by every evaluate()
+    std::vector<uint8_t> below_;
+    std::vector<uint8_t> profit_;
+};
+
+#endif // PRODUCT_SCAN_H
@@ -0,0 +1,62 @@
+// rate_limiter.h
+#ifndef RATE_LIMITER_H
+#define RATE_LIMITER_H
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+//------------------------------------------
+// TOKEN BUCKET RATE LIMITER
+//------------------------------------------
+// Shared by every thread that talks to the same API key.
+// acquire() blocks until a request token is available; event loops use the non-blocking
+// tryAcquire(wait) and sleep on their own timers instead.
+class RateLimiter {
+public:
+    RateLimiter(double requestsPerSecond, double burst)
+        : rate_(requestsPerSecond), burst_(burst), tokens_(burst),
+          last_(std::chrono::steady_clock::now()) {}
+
+    void acquire() {
+        std::chrono::nanoseconds wait{};
+        while (!tryAcquire(wait)) {
+            std::this_thread::sleep_for(wait);
+        }
+    }
+
+    // Non-blocking variant, returns false when the bucket is empty
+    bool tryAcquire() {
+        std::chrono::nanoseconds wait{};
+        return tryAcquire(wait);
+    }
+
+    // Same, and on false sets `wait` to the time until the next token is due
+    bool tryAcquire(std::chrono::nanoseconds& wait) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        refill();
+        if (tokens_ >= 1.0) {
+            tokens_ -= 1.0;
+            return true;
+        }
+        wait = std::chrono::ceil<std::chrono::nanoseconds>(std::chrono::duration<double>((1.0 - tokens_) / rate_));
+        return false;
+    }
+
+private:
+    void refill() {
+        auto now = std::chrono::steady_clock::now();
+        std::chrono::duration<double> elapsed = now - last_;
+        last_ = now;
+        tokens_ = std::min(burst_, tokens_ + elapsed.count() * rate_);
+    }
+
+    std::mutex mutex_;
+    double rate_;
+    double burst_;
+    double tokens_;
+    std::chrono::steady_clock::time_point last_;
+};
+
+#endif // RATE_LIMITER_H
@@ -0,0 +1,352 @@
+// replay_log.h
+#ifndef REPLAY_LOG_H
+#define REPLAY_LOG_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+//------------------------------------------
+// RECORD / REPLAY LOG
+//------------------------------------------
+// Layout: "CBRL" + uint32 version, then records of
+//   uint8 type, varint timestampNanos (since capture start), then per type:
+//   HttpExchange: varint status, str method, str url, str requestBody, str responseBody
+//   MarketEvent:  str payload   (level2 connection: l2_data, market_trades, heartbeats)
+//   UserEvent:    str payload   (user channel connection)
+// where str = varint length + bytes. Bearer tokens are never written.
+
+enum class ReplayRecordType : uint8_t { HttpExchange = 1, MarketEvent = 2, UserEvent = 3 };
+
+enum class ReplaySpeed { Original, AsFastAsPossible };
+
+namespace replay_detail {
+    inline void putVarint(std::string& out, uint64_t v)
+    {
+        while (v >= 0x80) {
+            out.push_back(static_cast<char>((v & 0x7F) | 0x80));
+            v >>= 7;
+        }
+        out.push_back(static_cast<char>(v));
+    }
+
+    inline void putString(std::string& out, std::string_view s)
+    {
+        putVarint(out, s.size());
+        out.append(s);
+    }
+
+    inline bool getVarint(const std::string& in, size_t& pos, uint64_t& v)
+    {
+        v = 0;
+        for (int shift = 0; pos < in.size() && shift < 64; shift += 7) {
+            auto byte = static_cast<uint8_t>(in[pos++]);
+            v |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    inline bool getString(const std::string& in, size_t& pos, std::string& s)
+    {
+        uint64_t len;
+        if (!getVarint(in, pos, len) || pos + len > in.size()) {
+            return false;
+        }
+        s.assign(in, pos, len);
+        pos += len;
+        return true;
+    }
+
+    // Replayed requests are matched on method + path; the query string carries
+    // timestamps that differ between capture and replay
+    inline std::string requestKey(std::string_view method, std::string_view url)
+    {
+        std::string_view path = url.substr(0, url.find('?'));
+        std::string key(method);
+        key.push_back(' ');
+        key.append(path);
+        return key;
+    }
+
+    inline int64_t steadyNanos()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+//------------------------------------------
+// CAPTURE
+//------------------------------------------
+class EventRecorder {
+public:
+    ~EventRecorder() { close(); }
+
+    bool open(const std::string& path)
+    {
+        file_ = std::fopen(path.c_str(), "wb");
+        if (!file_) {
+            std::cerr << "[ERROR] Could not open capture file " << path << "\n";
+            return false;
+        }
+        const char magic[4] = {'C', 'B', 'R', 'L'};
+        uint32_t version = 1;
+        std::fwrite(magic, 1, sizeof(magic), file_);
+        std::fwrite(&version, sizeof(version), 1, file_);
+        startNanos_ = replay_detail::steadyNanos();
+        lastFlushNanos_ = startNanos_;
+        return true;
+    }
+
+    void recordHttp(std::string_view method, std::string_view url, std::string_view requestBody,
+                    long httpStatus, std::string_view responseBody)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        scratch_.clear();
+        scratch_.push_back(static_cast<char>(ReplayRecordType::HttpExchange));
+        replay_detail::putVarint(scratch_, static_cast<uint64_t>(replay_detail::steadyNanos() - startNanos_));
+        replay_detail::putVarint(scratch_, static_cast<uint64_t>(httpStatus));
+        replay_detail::putString(scratch_, method);
+        replay_detail::putString(scratch_, url);
+        replay_detail::putString(scratch_, requestBody);
+        replay_detail::putString(scratch_, responseBody);
+        write();
+    }
+
+    void recordMarketEvent(std::string_view payload) { recordEvent(ReplayRecordType::MarketEvent, payload); }
+    void recordUserEvent(std::string_view payload) { recordEvent(ReplayRecordType::UserEvent, payload); }
+
+    // Pushes buffered records to the file; called periodically (housekeeping) and on close
+    void flush()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (file_) {
+            std::fflush(file_);
+            lastFlushNanos_ = replay_detail::steadyNanos();
+        }
+    }
+
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (file_) {
+            std::fclose(file_);
+            file_ = nullptr;
+        }
+    }
+
+private:
+    // Records go through stdio's buffer (level2 can be hundreds of messages a second);
+    // the file is flushed at most every kFlushIntervalNanos here, and by flush()/close()
+    static constexpr int64_t kFlushIntervalNanos = 200'000'000;
+
+    void recordEvent(ReplayRecordType type, std::string_view payload)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        scratch_.clear();
+        scratch_.push_back(static_cast<char>(type));
+        replay_detail::putVarint(scratch_, static_cast<uint64_t>(replay_detail::steadyNanos() - startNanos_));
+        replay_detail::putString(scratch_, payload);
+        write();
+    }
+
+    void write()
+    {
+        if (file_) {
+            std::fwrite(scratch_.data(), 1, scratch_.size(), file_);
+            int64_t now = replay_detail::steadyNanos();
+            if (now - lastFlushNanos_ >= kFlushIntervalNanos) {
+                std::fflush(file_); // Keep the capture usable if the bot is killed
+                lastFlushNanos_ = now;
+            }
+        }
+    }
+
+    std::FILE* file_ = nullptr;
+    std::mutex mutex_;
+    std::string scratch_;
+    int64_t startNanos_ = 0;
+    int64_t lastFlushNanos_ = 0;
+};
+
+//------------------------------------------
+// REPLAY
+//------------------------------------------
+class EventReplayer {
+public:
+    struct Record {
+        ReplayRecordType type;
+        int64_t timestampNanos;
+        long httpStatus = 0;
+        std::string method;
+        std::string url;
+        std::string requestBody;
+        std::string payload; // Response body, market or user event
+    };
+
+    bool open(const std::string& path, ReplaySpeed speed)
+    {
+        speed_ = speed;
+        std::FILE* f = std::fopen(path.c_str(), "rb");
+        if (!f) {
+            std::cerr << "[ERROR] Could not open replay file " << path << "\n";
+            return false;
+        }
+        std::string data;
+        char buf[1 << 16];
+        size_t n;
+        while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) {
+            data.append(buf, n);
+        }
+        std::fclose(f);
+
+        if (data.size() < 8 || data.compare(0, 4, "CBRL") != 0) {
+            std::cerr << "[ERROR] " << path << " is not a capture file\n";
+            return false;
+        }
+
+        size_t pos = 8;
+        while (pos < data.size()) {
+            Record r;
+            r.type = static_cast<ReplayRecordType>(data[pos++]);
+            uint64_t ts;
+            if (!replay_detail::getVarint(data, pos, ts)) break;
+            r.timestampNanos = static_cast<int64_t>(ts);
+
+            if (r.type == ReplayRecordType::HttpExchange) {
+                uint64_t status;
+                if (!replay_detail::getVarint(data, pos, status)
+                    || !replay_detail::getString(data, pos, r.method)
+                    || !replay_detail::getString(data, pos, r.url)
+                    || !replay_detail::getString(data, pos, r.requestBody)
+                    || !replay_detail::getString(data, pos, r.payload)) {
+                    break; // Truncated tail
+                }
+                r.httpStatus = static_cast<long>(status);
+                httpQueues_[replay_detail::requestKey(r.method, r.url)].push_back(records_.size());
+                remainingHttp_.fetch_add(1, std::memory_order_relaxed);
+            } else if (r.type == ReplayRecordType::MarketEvent || r.type == ReplayRecordType::UserEvent) {
+                if (!replay_detail::getString(data, pos, r.payload)) break;
+                (r.type == ReplayRecordType::MarketEvent ? hasMarketEvents_ : hasUserEvents_) = true;
+            } else {
+                break;
+            }
+            records_.push_back(std::move(r));
+        }
+
+        std::cout << "[REPLAY] Loaded " << records_.size() << " records from " << path << "\n";
+        replayStartNanos_ = replay_detail::steadyNanos(); // Recorded offsets are relative to this
+        return true;
+    }
+
+    // Next recorded response for this method + path, or nullptr when the capture has none left.
+    // In Original speed mode this waits until the response's recorded time. The wait happens
+    // outside the lock, so other threads keep taking their own responses meanwhile.
+    const Record* nextHttpResponse(std::string_view method, std::string_view url)
+    {
+        const Record* r = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = httpQueues_.find(replay_detail::requestKey(method, url));
+            if (it == httpQueues_.end() || it->second.empty()) {
+                return nullptr;
+            }
+            r = &records_[it->second.front()]; // records_ is immutable after open()
+            it->second.pop_front();
+            remainingHttp_.fetch_sub(1, std::memory_order_relaxed);
+            servedHttp_++;
+        }
+        served_.notify_all();
+        paceTo(r->timestampNanos);
+        return r;
+    }
+
+    // Feeds every market and user event, in order, to handler until the capture ends or stop().
+    // Run it on its own thread: it stands in for the level2 and user channel connections.
+    // In Original speed mode each event waits for its recorded time; as fast as possible, it
+    // waits until as many responses have been served as were recorded before it, so the bot
+    // sees market data and responses in the order they were captured.
+    void replayEvents(const std::function<void(const Record&)>& handler)
+    {
+        size_t httpBefore = 0;
+        for (const Record& r : records_) {
+            if (r.type == ReplayRecordType::HttpExchange) {
+                httpBefore++;
+                continue;
+            }
+            if (!waitForEvent(r.timestampNanos, httpBefore)) {
+                return;
+            }
+            handler(r);
+        }
+    }
+
+    // Ends replayEvents() early (at shutdown)
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopped_ = true;
+        }
+        served_.notify_all();
+    }
+
+    bool httpExhausted() const { return remainingHttp_.load(std::memory_order_relaxed) == 0; }
+    bool fastMode() const { return speed_ == ReplaySpeed::AsFastAsPossible; }
+    bool hasMarketEvents() const { return hasMarketEvents_; }
+    bool hasUserEvents() const { return hasUserEvents_; }
+
+private:
+    void paceTo(int64_t recordedNanos)
+    {
+        if (speed_ != ReplaySpeed::Original) {
+            return;
+        }
+        int64_t now = replay_detail::steadyNanos();
+        int64_t due = replayStartNanos_ + recordedNanos;
+        if (due > now) {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(due - now));
+        }
+    }
+
+    // False once stop() was called
+    bool waitForEvent(int64_t recordedNanos, size_t httpBefore)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (speed_ == ReplaySpeed::Original) {
+            auto due = std::chrono::steady_clock::time_point(std::chrono::nanoseconds(replayStartNanos_ + recordedNanos));
+            served_.wait_until(lock, due, [this] { return stopped_; });
+        } else {
+            served_.wait(lock, [this, httpBefore] { return stopped_ || servedHttp_ >= httpBefore || httpExhausted(); });
+        }
+        return !stopped_;
+    }
+
+    ReplaySpeed speed_ = ReplaySpeed::Original;
+    std::vector<Record> records_;
+    std::map<std::string, std::deque<size_t>> httpQueues_;
+    std::atomic<size_t> remainingHttp_{0}; // Read without the lock by httpExhausted()
+    int64_t replayStartNanos_ = 0;
+    size_t servedHttp_ = 0;                // Responses handed out so far
+    bool hasMarketEvents_ = false;
+    bool hasUserEvents_ = false;
+    bool stopped_ = false;
+    std::mutex mutex_;
+    std::condition_variable served_;       // A response was served, or stop()
+};
+
+#endif // REPLAY_LOG_H
@@ -0,0 +1,100 @@
+// request_control.h
+#ifndef REQUEST_CONTROL_H
+#define REQUEST_CONTROL_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+
+#include <curl/curl.h>
+
+#include "metrics.h"
+
+//------------------------------------------
+// CANCELLATION
+//------------------------------------------
+// Shared flag checked by in-flight requests; once cancelled it stays cancelled
+class CancelToken {
+public:
+    void cancel() { cancelled_.store(true, std::memory_order_release); }
+    bool isCancelled() const { return cancelled_.load(std::memory_order_acquire); }
+private:
+    std::atomic<bool> cancelled_{false};
+};
+
+//------------------------------------------
+// PER-REQUEST OPTIONS AND RESULT
+//------------------------------------------
+constexpr int64_t kDefaultRequestTimeoutNanos = 10'000'000'000LL; // Used when no deadline is given
+constexpr long kConnectTimeoutMs = 3000;
+
+struct RequestOptions {
+    int64_t deadlineNanos = 0;          // Absolute monotonic deadline; 0 = now + default timeout
+    const CancelToken* cancel = nullptr; // Abort as soon as this is cancelled
+    bool hedge = false;                 // GET only: send a duplicate after the p95 delay
+    std::function<std::string()> hedgeToken; // Signs the duplicate's JWT (filled in by the caller)
+};
+
+struct HttpResult {
+    CURLcode code = CURLE_OK;
+    long httpStatus = 0;
+    bool timedOut = false;
+    bool cancelled = false;
+    bool hedged = false;    // A duplicate request was sent
+    bool hedgeWon = false;  // ...and answered first
+
+    bool ok() const { return code == CURLE_OK && httpStatus >= 200 && httpStatus < 300; }
+};
+
+//------------------------------------------
+// LATENCY WINDOW (HEDGE DELAY)
+//------------------------------------------
+// Last kSize successful latencies of one endpoint; the hedge fires at their p95.
+class LatencyWindow {
+public:
+    static constexpr size_t kSize = 128;
+    static constexpr size_t kMinSamples = 20;
+    static constexpr int64_t kDefaultDelayNanos = 500'000'000; // Until we have enough samples
+    static constexpr int64_t kMinDelayNanos = 50'000'000;
+    static constexpr int64_t kMaxDelayNanos = 2'000'000'000;
+
+    void add(int64_t nanos)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        samples_[count_++ % kSize] = nanos;
+    }
+
+    int64_t hedgeDelayNanos(double quantile = 0.95)
+    {
+        std::array<int64_t, kSize> sorted;
+        size_t n;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            n = std::min(count_, kSize);
+            if (n < kMinSamples) {
+                return kDefaultDelayNanos;
+            }
+            std::copy(samples_.begin(), samples_.begin() + n, sorted.begin());
+        }
+        size_t k = std::min(n - 1, static_cast<size_t>(quantile * n));
+        std::nth_element(sorted.begin(), sorted.begin() + k, sorted.begin() + n);
+        return std::clamp(sorted[k], kMinDelayNanos, kMaxDelayNanos);
+    }
+
+private:
+    std::mutex mutex_;
+    std::array<int64_t, kSize> samples_{};
+    size_t count_ = 0;
+};
+
+inline LatencyWindow& latencyWindow(Endpoint e)
+{
+    static std::array<LatencyWindow, static_cast<size_t>(Endpoint::Count)> windows;
+    return windows[static_cast<size_t>(e)];
+}
+
+#endif // REQUEST_CONTROL_H
@@ -0,0 +1,256 @@
+// risk_engine.h
+#ifndef RISK_ENGINE_H
+#define RISK_ENGINE_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <string>
+
+//------------------------------------------
+// PRE-TRADE RISK ENGINE
+//------------------------------------------
+// Every order is checked against preloaded per-product limits before it goes on the wire.
+// Products are registered once at startup and addressed by slot index afterwards, so
+// check() is a handful of comparisons: no allocation, no hashing, no locks.
+// The engine is owned by the thread that places orders.
+
+enum class RiskResult : uint8_t {
+    Accept = 0,
+    UnknownProduct,     // Slot was never configured
+    ProductDisabled,    // Kill switch for this product
+    MaxOrderNotional,   // Single order too large
+    MaxPosition,        // Order would push net position past the limit
+    OrderRate,          // Too many orders in the rate window
+    PriceBand,          // Limit price too far from the reference price
+    NoReferencePrice    // Price band configured but no reference price yet
+};
+
+inline const char* riskResultName(RiskResult r)
+{
+    switch (r) {
+        case RiskResult::Accept: return "ACCEPT";
+        case RiskResult::UnknownProduct: return "UNKNOWN_PRODUCT";
+        case RiskResult::ProductDisabled: return "PRODUCT_DISABLED";
+        case RiskResult::MaxOrderNotional: return "MAX_ORDER_NOTIONAL";
+        case RiskResult::MaxPosition: return "MAX_POSITION";
+        case RiskResult::OrderRate: return "ORDER_RATE";
+        case RiskResult::PriceBand: return "PRICE_BAND";
+        case RiskResult::NoReferencePrice: return "NO_REFERENCE_PRICE";
+    }
+    return "UNKNOWN";
+}
+
+struct RiskLimits {
+    double maxOrderNotionalUsd = 10.0;   // Per order
+    double maxPositionUsd = 50.0;        // Absolute net position (quote currency)
+    uint32_t maxOrdersPerWindow = 5;     // Order-rate limit...
+    int64_t rateWindowNanos = 60'000'000'000; // ...per this window
+    double priceBandFraction = 0.01;     // |limit / reference - 1| must be within this (0 disables)
+};
+
+class RiskEngine {
+public:
+    static constexpr size_t kMaxProducts = 256;
+
+    // Startup only: assigns a slot to productId and loads its limits.
+    // Returns the slot index, or -1 when the table is full or the limits are invalid.
+    int addProduct(const std::string& productId, const RiskLimits& limits)
+    {
+        if (numProducts_ >= kMaxProducts) {
+            std::cerr << "[ERROR] Risk engine product table is full.\n";
+            return -1;
+        }
+        if (!validLimits(limits)) {
+            std::cerr << "[ERROR] Invalid risk limits for " << productId << ".\n";
+            return -1;
+        }
+        int slot = static_cast<int>(numProducts_++);
+        ProductState& s = products_[slot];
+        s = ProductState{};
+        s.productId = productId;
+        s.limits = limits;
+        s.configured = true;
+        s.enabled = true;
+        // Token bucket: capacity = maxOrdersPerWindow, refilled at maxOrdersPerWindow per window
+        s.rateTokens = limits.maxOrdersPerWindow;
+        return slot;
+    }
+
+    // Positive window and order count, and window * (count + 1) fits the refill arithmetic
+    static bool validLimits(const RiskLimits& limits)
+    {
+        return limits.maxOrdersPerWindow > 0 && limits.rateWindowNanos > 0
+               && limits.rateWindowNanos <= std::numeric_limits<int64_t>::max() / (int64_t{limits.maxOrdersPerWindow} + 1)
+               && limits.maxOrderNotionalUsd >= 0.0 && limits.maxPositionUsd >= 0.0
+               && limits.priceBandFraction >= 0.0;
+    }
+
+    //------------------------------------------
+    // HOT PATH
+    //------------------------------------------
+    // sideSign is +1 for BUY, -1 for SELL. nowNanos is a monotonic timestamp.
+    // On Accept the order is counted against the rate limit and the pending position.
+    RiskResult check(int slot, int sideSign, double limitPrice, double quoteNotionalUsd, int64_t nowNanos)
+    {
+        if (slot < 0 || static_cast<size_t>(slot) >= numProducts_) {
+            return RiskResult::UnknownProduct;
+        }
+        ProductState& s = products_[slot];
+        if (!s.configured) {
+            return RiskResult::UnknownProduct;
+        }
+        if (!s.enabled) {
+            return RiskResult::ProductDisabled;
+        }
+        if (quoteNotionalUsd > s.limits.maxOrderNotionalUsd) {
+            return RiskResult::MaxOrderNotional;
+        }
+
+        double newPosition = s.positionUsd + s.pendingUsd + sideSign * quoteNotionalUsd;
+        if (std::fabs(newPosition) > s.limits.maxPositionUsd) {
+            return RiskResult::MaxPosition;
+        }
+
+        if (s.limits.priceBandFraction > 0.0) {
+            if (s.referencePrice <= 0.0) {
+                return RiskResult::NoReferencePrice;
+            }
+            if (std::fabs(limitPrice / s.referencePrice - 1.0) > s.limits.priceBandFraction) {
+                return RiskResult::PriceBand;
+            }
+        }
+
+        refillRateTokens(s, nowNanos);
+        if (s.rateTokens == 0) {
+            return RiskResult::OrderRate;
+        }
+
+        s.rateTokens--;
+        s.pendingUsd += sideSign * quoteNotionalUsd;
+        return RiskResult::Accept;
+    }
+
+    // Amending the price of a resting order: notional and pending position are unchanged,
+    // so only the kill switch, price band and rate limit apply.
+    RiskResult checkAmend(int slot, double newLimitPrice, int64_t nowNanos)
+    {
+        if (slot < 0 || static_cast<size_t>(slot) >= numProducts_ || !products_[slot].configured) {
+            return RiskResult::UnknownProduct;
+        }
+        ProductState& s = products_[slot];
+        if (!s.enabled) {
+            return RiskResult::ProductDisabled;
+        }
+        if (s.limits.priceBandFraction > 0.0) {
+            if (s.referencePrice <= 0.0) {
+                return RiskResult::NoReferencePrice;
+            }
+            if (std::fabs(newLimitPrice / s.referencePrice - 1.0) > s.limits.priceBandFraction) {
+                return RiskResult::PriceBand;
+            }
+        }
+        refillRateTokens(s, nowNanos);
+        if (s.rateTokens == 0) {
+            return RiskResult::OrderRate;
+        }
+        s.rateTokens--;
+        return RiskResult::Accept;
+    }
+
+    // Nearest price to `price` that passes the price band (unchanged when no band or no
+    // reference price yet). Pulled in by a hair so the band check cannot reject it on rounding.
+    double clampToPriceBand(int slot, double price) const
+    {
+        const ProductState& s = products_[slot];
+        if (s.limits.priceBandFraction <= 0.0 || s.referencePrice <= 0.0) {
+            return price;
+        }
+        double band = s.limits.priceBandFraction * (1.0 - 1e-9);
+        return std::min(std::max(price, s.referencePrice * (1.0 - band)), s.referencePrice * (1.0 + band));
+    }
+
+    // Reference price for the price band (last trade, mid or MA)
+    void updateReferencePrice(int slot, double price) { products_[slot].referencePrice = price; }
+
+    // Order left the book without filling (cancelled, rejected by exchange, or never sent)
+    void onOrderReleased(int slot, int sideSign, double quoteNotionalUsd)
+    {
+        products_[slot].pendingUsd -= sideSign * quoteNotionalUsd;
+    }
+
+    // Fill moves notional from pending into the position
+    void onFill(int slot, int sideSign, double filledQuoteUsd)
+    {
+        ProductState& s = products_[slot];
+        s.pendingUsd -= sideSign * filledQuoteUsd;
+        s.positionUsd += sideSign * filledQuoteUsd;
+    }
+
+    // Restart: position and working-order exposure recovered from the state journal
+    void restore(int slot, double positionUsd, double pendingUsd)
+    {
+        products_[slot].positionUsd = positionUsd;
+        products_[slot].pendingUsd = pendingUsd;
+    }
+
+    void setEnabled(int slot, bool enabled) { products_[slot].enabled = enabled; }
+
+    double positionUsd(int slot) const { return products_[slot].positionUsd; }
+    double pendingUsd(int slot) const { return products_[slot].pendingUsd; }
+
+private:
+    struct ProductState {
+        RiskLimits limits;
+        double positionUsd = 0.0;
+        double pendingUsd = 0.0;   // Accepted orders not yet filled or released
+        double referencePrice = 0.0;
+        uint32_t rateTokens = 0;
+        int64_t refillCredit = 0;  // Elapsed nanos * maxOrdersPerWindow not yet turned into tokens
+        int64_t lastRefillNanos = 0;
+        bool configured = false;
+        bool enabled = false;
+        std::string productId;     // Only read off the hot path (logging)
+    };
+
+    // Exact rational refill: maxOrdersPerWindow tokens per rateWindowNanos, with the
+    // fractional remainder carried in refillCredit (no truncated per-token interval)
+    static void refillRateTokens(ProductState& s, int64_t nowNanos)
+    {
+        if (s.lastRefillNanos == 0) {
+            s.lastRefillNanos = nowNanos;
+            return;
+        }
+        int64_t elapsed = nowNanos - s.lastRefillNanos;
+        if (elapsed <= 0) {
+            return;
+        }
+        s.lastRefillNanos = nowNanos;
+        const int64_t window = s.limits.rateWindowNanos;
+        const uint32_t capacity = s.limits.maxOrdersPerWindow;
+        if (elapsed >= window) {
+            s.rateTokens = capacity; // A whole window refills the bucket
+            s.refillCredit = 0;
+            return;
+        }
+        // credit < window and elapsed * capacity < window * capacity: no overflow (checked at startup)
+        s.refillCredit += elapsed * capacity;
+        int64_t earned = s.refillCredit / window;
+        if (earned > 0) {
+            s.refillCredit -= earned * window;
+            uint64_t tokens = s.rateTokens + static_cast<uint64_t>(earned);
+            s.rateTokens = static_cast<uint32_t>(tokens < capacity ? tokens : capacity);
+        }
+        if (s.rateTokens == capacity) {
+            s.refillCredit = 0;
+        }
+    }
+
+    std::array<ProductState, kMaxProducts> products_{};
+    size_t numProducts_ = 0;
+};
+
+#endif // RISK_ENGINE_H
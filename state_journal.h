@@ -0,0 +1,491 @@
+// state_journal.h
+#ifndef STATE_JOURNAL_H
+#define STATE_JOURNAL_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "candle_store.h"   // fnv1a
+#include "order_tracker.h"
+
+//------------------------------------------
+// STATE JOURNAL
+//------------------------------------------
+// Append-only log of the strategy thread's state so a restart resumes where it stopped:
+// position, last buy price, signal state and every order still working.
+//
+// File layout: JournalFileHeader, then records of
+//   JournalRecordHeader { size, type, checksum } + payload
+// Records are appended into a memory-mapped file that grows in kGrowBytes steps. The
+// unused tail is zero, so a zero size marks the end; a record whose checksum does not
+// match is a torn write from a crash and everything from it onwards is discarded.
+// Writes into the mapping survive a process crash as soon as they are made; the sync
+// policy only decides how often they are forced to disk (power loss).
+//
+// Once the journal passes kCompactBytes it is compacted: a new file holding a single
+// snapshot is written next to it, synced, and renamed over the old one.
+
+enum class JournalSyncPolicy : uint8_t {
+    Never,    // Leave it to the OS
+    Interval, // msync at most once per interval, on append
+    Always    // msync after every record
+};
+
+// Strategy-thread state besides the orders. The signal is stored as raw bytes, so the
+// strategy's Signal policy must be trivially copyable and fit in kMaxSignalBytes.
+struct JournalStrategyState {
+    static constexpr size_t kMaxSignalBytes = 64;
+
+    uint8_t havePosition = 0;
+    double lastBuyPrice = 0.0;
+    double positionUsd = 0.0;    // Filled position as the risk engine saw it
+    uint32_t signalBytes = 0;
+    unsigned char signal[kMaxSignalBytes] = {};
+};
+
+// Field by field: the struct has padding, and padding bytes are indeterminate
+inline bool operator==(const JournalStrategyState& a, const JournalStrategyState& b)
+{
+    return a.havePosition == b.havePosition && a.lastBuyPrice == b.lastBuyPrice && a.positionUsd == b.positionUsd
+           && a.signalBytes == b.signalBytes && std::memcmp(a.signal, b.signal, sizeof(a.signal)) == 0;
+}
+inline bool operator!=(const JournalStrategyState& a, const JournalStrategyState& b) { return !(a == b); }
+
+struct JournalRecovery {
+    bool haveState = false;
+    JournalStrategyState state;
+    std::vector<TrackedOrder> orders;   // Non-terminal orders, in journal order
+    size_t records = 0;
+    bool tornTail = false;              // A partial record was found and dropped
+};
+
+class StateJournal {
+public:
+    static constexpr uint32_t kMagic = 0x314A4243; // "CBJ1"
+    static constexpr uint32_t kVersion = 1;
+    static constexpr size_t kGrowBytes = 1 << 20;
+    static constexpr size_t kCompactBytes = 8 << 20;
+
+    enum class RecordType : uint8_t { Snapshot = 1, StrategyState = 2, OrderUpsert = 3, OrderRemoved = 4 };
+
+    StateJournal() = default;
+    StateJournal(const StateJournal&) = delete;
+    StateJournal& operator=(const StateJournal&) = delete;
+    ~StateJournal() { close(); }
+
+    // Opens (or creates) the journal and replays it into recovered()
+    bool open(const std::string& path, JournalSyncPolicy policy, int64_t syncIntervalNanos)
+    {
+        path_ = path;
+        policy_ = policy;
+        syncIntervalNanos_ = syncIntervalNanos;
+        if (!mapFile(path_)) {
+            return false;
+        }
+        recover();
+        return true;
+    }
+
+    bool isOpen() const { return base_ != nullptr; }
+    const JournalRecovery& recovered() const { return recovery_; }
+
+    bool appendStrategyState(const JournalStrategyState& s, int64_t nowNanos)
+    {
+        return append(RecordType::StrategyState, &s, sizeof(s), nowNanos);
+    }
+
+    bool appendOrder(const TrackedOrder& o, int64_t nowNanos)
+    {
+        return append(RecordType::OrderUpsert, &o, sizeof(o), nowNanos);
+    }
+
+    bool appendOrderRemoved(const ClientOrderId& id, int64_t nowNanos)
+    {
+        return append(RecordType::OrderRemoved, &id, sizeof(id), nowNanos);
+    }
+
+    bool needsCompaction() const { return isOpen() && end_ >= kCompactBytes; }
+
+    // Replaces the journal with one snapshot of the current state
+    bool compact(const JournalStrategyState& state, const std::vector<TrackedOrder>& openOrders)
+    {
+        std::vector<unsigned char> payload(sizeof(state) + sizeof(uint32_t) + openOrders.size() * sizeof(TrackedOrder));
+        uint32_t count = static_cast<uint32_t>(openOrders.size());
+        std::memcpy(payload.data(), &state, sizeof(state));
+        std::memcpy(payload.data() + sizeof(state), &count, sizeof(count));
+        if (count) {
+            std::memcpy(payload.data() + sizeof(state) + sizeof(count), openOrders.data(), count * sizeof(TrackedOrder));
+        }
+
+        std::string tmpPath = path_ + ".tmp";
+        std::error_code ec;
+        std::filesystem::remove(tmpPath, ec);
+
+        StateJournal fresh;
+        fresh.path_ = tmpPath;
+        if (!fresh.mapFile(tmpPath) || !fresh.append(RecordType::Snapshot, payload.data(), payload.size(), 0)) {
+            std::cerr << "[ERROR] Journal compaction failed to write " << tmpPath << "\n";
+            return false;
+        }
+        fresh.syncNow();
+        fresh.close();
+        close();
+
+        std::filesystem::rename(tmpPath, path_, ec);
+        if (ec) {
+            std::cerr << "[ERROR] Journal compaction rename failed: " << ec.message() << "\n";
+        }
+        if (!mapFile(path_)) {
+            return false;
+        }
+        // Position the write cursor after the snapshot
+        JournalRecovery scratch;
+        scan(scratch);
+        return true;
+    }
+
+    // Force everything written so far to disk
+    void syncNow()
+    {
+#if !defined(_WIN32)
+        if (base_) {
+            msync(base_, end_, MS_SYNC);
+        }
+#else
+        if (file_) {
+            std::fflush(file_);
+        }
+#endif
+    }
+
+    void close()
+    {
+#if !defined(_WIN32)
+        if (base_) {
+            munmap(base_, mapped_);
+            base_ = nullptr;
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+#else
+        if (file_) {
+            std::fclose(file_);
+            file_ = nullptr;
+        }
+        buffer_.clear();
+        base_ = nullptr;
+#endif
+        mapped_ = 0;
+        end_ = 0;
+    }
+
+private:
+    struct JournalFileHeader {
+        uint32_t magic = kMagic;
+        uint32_t version = kVersion;
+    };
+
+    struct JournalRecordHeader {
+        uint32_t size = 0;      // Payload bytes; 0 = end of journal
+        uint8_t type = 0;
+        uint8_t reserved[3] = {};
+        uint32_t checksum = 0;  // fnv1a over type + payload
+    };
+
+    static_assert(std::is_trivially_copyable<TrackedOrder>::value, "TrackedOrder is journaled as raw bytes");
+    static_assert(std::is_trivially_copyable<JournalStrategyState>::value, "JournalStrategyState is journaled as raw bytes");
+
+    static uint32_t checksum(RecordType type, const void* payload, size_t size)
+    {
+        uint8_t t = static_cast<uint8_t>(type);
+        return fnv1a(payload, size, fnv1a(&t, 1));
+    }
+
+    bool append(RecordType type, const void* payload, size_t size, int64_t nowNanos)
+    {
+        if (!base_) {
+            return false;
+        }
+        size_t need = end_ + sizeof(JournalRecordHeader) + size;
+        if (need + sizeof(JournalRecordHeader) > mapped_ && !grow(need + sizeof(JournalRecordHeader))) {
+            return false;
+        }
+
+        // Payload first, header last: a crash mid-append leaves either no record or a
+        // header whose checksum cannot match
+        JournalRecordHeader h;
+        h.size = static_cast<uint32_t>(size);
+        h.type = static_cast<uint8_t>(type);
+        h.checksum = checksum(type, payload, size);
+        std::memcpy(base_ + end_ + sizeof(h), payload, size);
+        std::memcpy(base_ + end_, &h, sizeof(h));
+        size_t recordStart = end_;
+        end_ = need;
+
+#if defined(_WIN32)
+        std::fseek(file_, static_cast<long>(recordStart), SEEK_SET);
+        std::fwrite(base_ + recordStart, 1, end_ - recordStart, file_);
+#else
+        (void)recordStart;
+#endif
+        maybeSync(nowNanos);
+        return true;
+    }
+
+    void maybeSync(int64_t nowNanos)
+    {
+        if (policy_ == JournalSyncPolicy::Always
+            || (policy_ == JournalSyncPolicy::Interval && nowNanos - lastSyncNanos_ >= syncIntervalNanos_)) {
+            syncNow();
+            lastSyncNanos_ = nowNanos;
+        }
+    }
+
+    // Rebuilds the state by applying every valid record in order
+    void recover()
+    {
+        recovery_ = JournalRecovery{};
+        scan(recovery_);
+        if (recovery_.tornTail) {
+            std::cerr << "[WARN] Journal " << path_ << ": dropped a torn record after " << recovery_.records << " records\n";
+        }
+    }
+
+    void scan(JournalRecovery& out)
+    {
+        size_t pos = sizeof(JournalFileHeader);
+        while (pos + sizeof(JournalRecordHeader) <= mapped_) {
+            JournalRecordHeader h;
+            std::memcpy(&h, base_ + pos, sizeof(h));
+            if (h.size == 0) {
+                break;
+            }
+            const unsigned char* payload = base_ + pos + sizeof(h);
+            if (pos + sizeof(h) + h.size > mapped_
+                || h.checksum != checksum(static_cast<RecordType>(h.type), payload, h.size)
+                || !apply(out, static_cast<RecordType>(h.type), payload, h.size)) {
+                out.tornTail = true;
+                break;
+            }
+            out.records++;
+            pos += sizeof(h) + h.size;
+        }
+        end_ = pos;
+        // Zero whatever follows so the next append is the new end
+        if (out.tornTail) {
+            std::memset(base_ + end_, 0, mapped_ - end_);
+#if defined(_WIN32)
+            std::fseek(file_, static_cast<long>(end_), SEEK_SET);
+            std::fwrite(base_ + end_, 1, mapped_ - end_, file_);
+#endif
+        }
+    }
+
+    static bool apply(JournalRecovery& out, RecordType type, const unsigned char* payload, size_t size)
+    {
+        switch (type) {
+            case RecordType::Snapshot: {
+                uint32_t count = 0;
+                if (size < sizeof(JournalStrategyState) + sizeof(count)) {
+                    return false;
+                }
+                std::memcpy(&out.state, payload, sizeof(JournalStrategyState));
+                std::memcpy(&count, payload + sizeof(JournalStrategyState), sizeof(count));
+                if (size != sizeof(JournalStrategyState) + sizeof(count) + count * sizeof(TrackedOrder)) {
+                    return false;
+                }
+                out.haveState = true;
+                out.orders.resize(count);
+                if (count) {
+                    std::memcpy(out.orders.data(), payload + sizeof(JournalStrategyState) + sizeof(count),
+                                count * sizeof(TrackedOrder));
+                }
+                return true;
+            }
+            case RecordType::StrategyState:
+                if (size != sizeof(JournalStrategyState)) {
+                    return false;
+                }
+                std::memcpy(&out.state, payload, size);
+                out.haveState = true;
+                return true;
+            case RecordType::OrderUpsert: {
+                if (size != sizeof(TrackedOrder)) {
+                    return false;
+                }
+                TrackedOrder o;
+                std::memcpy(&o, payload, size);
+                for (TrackedOrder& existing : out.orders) {
+                    if (existing.clientOrderId == o.clientOrderId) {
+                        existing = o;
+                        return true;
+                    }
+                }
+                out.orders.push_back(o);
+                return true;
+            }
+            case RecordType::OrderRemoved: {
+                if (size != sizeof(ClientOrderId)) {
+                    return false;
+                }
+                ClientOrderId id;
+                std::memcpy(&id, payload, size);
+                for (size_t i = 0; i < out.orders.size(); i++) {
+                    if (out.orders[i].clientOrderId == id) {
+                        out.orders.erase(out.orders.begin() + static_cast<std::ptrdiff_t>(i));
+                        break;
+                    }
+                }
+                return true;
+            }
+        }
+        return false; // Unknown type: treat as corruption
+    }
+
+#if !defined(_WIN32)
+    bool mapFile(const std::string& path)
+    {
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd_ < 0) {
+            std::cerr << "[ERROR] Cannot open journal " << path << "\n";
+            return false;
+        }
+        struct stat st{};
+        fstat(fd_, &st);
+        size_t size = static_cast<size_t>(st.st_size);
+        bool fresh = size < sizeof(JournalFileHeader);
+        if (fresh) {
+            size = 0;
+        }
+        if (!remap(std::max(size, kGrowBytes))) {
+            return false;
+        }
+        if (fresh) {
+            JournalFileHeader header;
+            std::memcpy(base_, &header, sizeof(header));
+        } else {
+            JournalFileHeader header;
+            std::memcpy(&header, base_, sizeof(header));
+            if (header.magic != kMagic || header.version != kVersion) {
+                std::cerr << "[ERROR] " << path << " is not a state journal\n";
+                close();
+                return false;
+            }
+        }
+        end_ = sizeof(JournalFileHeader);
+        return true;
+    }
+
+    bool remap(size_t size)
+    {
+        if (base_) {
+            munmap(base_, mapped_);
+            base_ = nullptr;
+        }
+        if (ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+            std::cerr << "[ERROR] Cannot size journal " << path_ << "\n";
+            return false;
+        }
+        void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (p == MAP_FAILED) {
+            std::cerr << "[ERROR] Cannot map journal " << path_ << "\n";
+            return false;
+        }
+        base_ = static_cast<unsigned char*>(p);
+        mapped_ = size;
+        return true;
+    }
+
+    bool grow(size_t need)
+    {
+        size_t size = mapped_;
+        while (size < need) {
+            size += kGrowBytes;
+        }
+        return remap(size);
+    }
+#else
+    // No mmap on Windows here: an in-memory image written through to the file
+    bool mapFile(const std::string& path)
+    {
+        file_ = std::fopen(path.c_str(), "r+b");
+        if (!file_) {
+            file_ = std::fopen(path.c_str(), "w+b");
+        }
+        if (!file_) {
+            std::cerr << "[ERROR] Cannot open journal " << path << "\n";
+            return false;
+        }
+        std::fseek(file_, 0, SEEK_END);
+        size_t size = static_cast<size_t>(std::ftell(file_));
+        std::fseek(file_, 0, SEEK_SET);
+        buffer_.assign(std::max(size, kGrowBytes), 0);
+        if (size) {
+            size_t read = std::fread(buffer_.data(), 1, size, file_);
+            (void)read;
+        }
+        base_ = buffer_.data();
+        mapped_ = buffer_.size();
+        JournalFileHeader header;
+        if (size < sizeof(header)) {
+            std::memcpy(base_, &header, sizeof(header));
+            std::fseek(file_, 0, SEEK_SET);
+            std::fwrite(&header, 1, sizeof(header), file_);
+        } else {
+            std::memcpy(&header, base_, sizeof(header));
+            if (header.magic != kMagic || header.version != kVersion) {
+                std::cerr << "[ERROR] " << path << " is not a state journal\n";
+                close();
+                return false;
+            }
+        }
+        end_ = sizeof(JournalFileHeader);
+        return true;
+    }
+
+    bool grow(size_t need)
+    {
+        size_t size = mapped_;
+        while (size < need) {
+            size += kGrowBytes;
+        }
+        buffer_.resize(size, 0);
+        base_ = buffer_.data();
+        mapped_ = size;
+        return true;
+    }
+
+    FILE* file_ = nullptr;
+    std::vector<unsigned char> buffer_;
+#endif
+
+    std::string path_;
+    JournalSyncPolicy policy_ = JournalSyncPolicy::Interval;
+    int64_t syncIntervalNanos_ = 1'000'000'000;
+    int64_t lastSyncNanos_ = 0;
+    JournalRecovery recovery_;
+#if !defined(_WIN32)
+    int fd_ = -1;
+#endif
+    unsigned char* base_ = nullptr;
+    size_t mapped_ = 0;   // Bytes mapped (file size)
+    size_t end_ = 0;      // Write cursor
+};
+
+#endif // STATE_JOURNAL_H
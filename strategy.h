@@ -0,0 +1,155 @@
+// strategy.h
+#ifndef STRATEGY_H
+#define STRATEGY_H
+
+#include <cstdint>
+
+//------------------------------------------
+// COMPILE-TIME STRATEGY POLICIES
+//------------------------------------------
+// A strategy is Strategy<Signal, Entry, Exit, Sizing>. Each policy is a plain class and
+// the composition is resolved by the compiler, so decide() inlines into straight-line
+// code: no virtual calls, no function pointers. Swapping a policy is a one-line typedef.
+//
+// Policy requirements (duck-typed):
+//   Signal: void update(const StrategyInput&)            - called once per snapshot
+//   Entry:  bool shouldEnter(const Signal&, const StrategyInput&, const PositionView&) const
+//   Exit:   bool wantsExit(const Signal&, const PositionView&) const   - the exit signal alone
+//           bool shouldExit(const Signal&, const StrategyInput&, const PositionView&) const
+//           double minExitPrice(const PositionView&) const - floor for the exit limit price
+//   Sizing: double quoteSize(Side, const StrategyInput&, const PositionView&) const
+// Policies are stateless except Signal, which may keep whatever history it needs.
+
+enum class Side : int8_t { Buy = 1, Sell = -1 };
+
+// What the strategy sees on every market snapshot
+struct StrategyInput {
+    double shortMA = 0.0;
+    double longMA = 0.0;
+    int64_t timestampNanos = 0;
+};
+
+// Position and order state, owned by the strategy thread (set from fills)
+struct PositionView {
+    bool havePosition = false;
+    double lastBuyPrice = 0.0;   // Average fill price of the last buy
+    bool orderInFlight = false;  // An order is still working; never stack another
+};
+
+struct Decision {
+    enum class Action : uint8_t { None, Enter, Exit };
+
+    Action action = Action::None;
+    Side side = Side::Buy;
+    double quoteUsd = 0.0;
+    double minPrice = 0.0;       // Exit: lowest acceptable limit price (0 = no floor)
+    bool exitBlocked = false;    // Exit signal fired but the exit rule held back (e.g. not enough profit)
+};
+
+//------------------------------------------
+// SIGNALS
+//------------------------------------------
+// Short/long moving average crossover. crossedUp() is true on the snapshot where the short
+// MA moves above the long MA after having been below it.
+class MaCrossSignal {
+public:
+    void update(const StrategyInput& in)
+    {
+        bool above = in.shortMA > in.longMA;
+        bool below = in.shortMA < in.longMA;
+        crossedUp_ = wasBelow_ && above;
+        bearish_ = below;
+        wasBelow_ = below;
+    }
+
+    bool crossedUp() const { return crossedUp_; }
+    bool bearish() const { return bearish_; }
+
+private:
+    bool wasBelow_ = false;
+    bool crossedUp_ = false;
+    bool bearish_ = false;
+};
+
+//------------------------------------------
+// ENTRY / EXIT RULES
+//------------------------------------------
+struct EnterOnCrossUp {
+    template <typename Signal>
+    bool shouldEnter(const Signal& signal, const StrategyInput&, const PositionView& pos) const
+    {
+        return signal.crossedUp() && !pos.havePosition && !pos.orderInFlight;
+    }
+};
+
+// Sell while bearish, but only once the price covers fees plus MinProfitBps over the buy.
+// MinProfitBps = 130 reproduces the original 1.013 multiplier.
+template <int MinProfitBps = 130>
+struct ExitOnBearishWithProfit {
+    static constexpr double kMultiplier = 1.0 + MinProfitBps / 10'000.0;
+
+    double minExitPrice(const PositionView& pos) const { return pos.lastBuyPrice * kMultiplier; }
+
+    template <typename Signal>
+    bool wantsExit(const Signal& signal, const PositionView& pos) const
+    {
+        return pos.havePosition && signal.bearish() && !pos.orderInFlight;
+    }
+
+    template <typename Signal>
+    bool shouldExit(const Signal& signal, const StrategyInput& in, const PositionView& pos) const
+    {
+        return wantsExit(signal, pos) && in.shortMA >= minExitPrice(pos);
+    }
+};
+
+//------------------------------------------
+// SIZING
+//------------------------------------------
+// Fixed notional per order, in cents so it can be a template argument
+template <int QuoteCents = 500>
+struct FixedQuoteSize {
+    double quoteSize(Side, const StrategyInput&, const PositionView&) const { return QuoteCents / 100.0; }
+};
+
+//------------------------------------------
+// COMPOSITION
+//------------------------------------------
+template <typename Signal, typename Entry, typename Exit, typename Sizing>
+class Strategy : private Entry, private Exit, private Sizing {
+public:
+    using SignalType = Signal;
+
+    // Feed one snapshot; returns what to do about it
+    Decision decide(const StrategyInput& in, const PositionView& pos)
+    {
+        signal_.update(in);
+
+        Decision d;
+        if (Entry::shouldEnter(signal_, in, pos)) {
+            d.action = Decision::Action::Enter;
+            d.side = Side::Buy;
+            d.quoteUsd = Sizing::quoteSize(Side::Buy, in, pos);
+        } else if (Exit::shouldExit(signal_, in, pos)) {
+            d.action = Decision::Action::Exit;
+            d.side = Side::Sell;
+            d.quoteUsd = Sizing::quoteSize(Side::Sell, in, pos);
+            d.minPrice = Exit::minExitPrice(pos);
+        } else {
+            d.exitBlocked = Exit::wantsExit(signal_, pos);
+        }
+        return d;
+    }
+
+    double minExitPrice(const PositionView& pos) const { return Exit::minExitPrice(pos); }
+    const Signal& signal() const { return signal_; }
+    void restoreSignal(const Signal& s) { signal_ = s; } // Restart from a journaled signal
+
+private:
+    Signal signal_;
+};
+
+// The bot's strategy: buy the MA cross up, sell on the way down once fees are covered, $5 orders
+using MaCrossoverStrategy = Strategy<MaCrossSignal, EnterOnCrossUp, ExitOnBearishWithProfit<130>, FixedQuoteSize<500>>;
+
+#endif // STRATEGY_H
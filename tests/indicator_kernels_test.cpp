@@ -0,0 +1,154 @@
+// indicator_kernels_test.cpp
+// Batch kernels (indicator_kernels.h) against the streaming indicators they replace, on every
+// SIMD level this CPU has. The kernels promise bit-identical outputs, so values must be equal.
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "indicator_kernels.h"
+#include "indicators.h"
+
+static int g_failures = 0;
+
+#define CHECK(cond, ...)                                  \
+    do {                                                  \
+        if (!(cond)) {                                    \
+            std::printf("[FAIL] %s:%d: ", __FILE__, __LINE__); \
+            std::printf(__VA_ARGS__);                     \
+            std::printf("\n");                            \
+            g_failures++;                                 \
+        }                                                 \
+    } while (0)
+
+static std::vector<double> randomWalk(size_t n, uint64_t seed)
+{
+    std::mt19937_64 rng(seed);
+    std::normal_distribution<double> step(0.0, 5.0);
+    std::vector<double> x(n);
+    double price = 64000.0;
+    for (double& v : x) {
+        price += step(rng);
+        v = price;
+    }
+    return x;
+}
+
+// Index of the first difference, or -1
+static long firstMismatch(const std::vector<double>& got, const std::vector<double>& want)
+{
+    for (size_t i = 0; i < want.size(); i++) {
+        if (got[i] != want[i]) {
+            return static_cast<long>(i);
+        }
+    }
+    return -1;
+}
+
+static std::vector<SimdLevel> levelsToTest()
+{
+    std::vector<SimdLevel> levels = {SimdLevel::Scalar};
+    SimdLevel best = detectSimdLevel();
+    if (best >= SimdLevel::Avx2) {
+        levels.push_back(SimdLevel::Avx2);
+    }
+    if (best >= SimdLevel::Avx512) {
+        levels.push_back(SimdLevel::Avx512);
+    }
+    return levels;
+}
+
+// Short series run as one lane, long ones split into lanes with a leftover tail
+static void testWindowKernels()
+{
+    for (size_t n : {size_t(10), size_t(5'000), size_t(100'003)}) {
+        std::vector<double> x = randomWalk(n, n);
+        for (size_t period : {size_t(1), size_t(7), size_t(20), size_t(200), size_t(999)}) {
+            std::vector<double> sma(n), mean(n), stddev(n);
+            Sma<> smaRef(period);
+            Bollinger<> bollingerRef(period);
+            for (size_t i = 0; i < n; i++) {
+                sma[i] = smaRef.update(x[i]);
+                bollingerRef.update(x[i]);
+                mean[i] = bollingerRef.middle();
+                stddev[i] = bollingerRef.stddev();
+            }
+            for (SimdLevel level : levelsToTest()) {
+                std::vector<double> gotSma(n), gotMean(n), gotStddev(n);
+                smaBatch(x.data(), n, period, gotSma.data(), level);
+                rollingStddevBatch(x.data(), n, period, gotMean.data(), gotStddev.data(), level);
+                long bad = firstMismatch(gotSma, sma);
+                CHECK(bad < 0, "smaBatch %s n=%zu period=%zu differs at %ld", simdLevelName(level), n, period, bad);
+                bad = firstMismatch(gotMean, mean);
+                CHECK(bad < 0, "rollingStddevBatch mean %s n=%zu period=%zu differs at %ld", simdLevelName(level), n,
+                      period, bad);
+                bad = firstMismatch(gotStddev, stddev);
+                CHECK(bad < 0, "rollingStddevBatch stddev %s n=%zu period=%zu differs at %ld", simdLevelName(level), n,
+                      period, bad);
+            }
+        }
+    }
+}
+
+// 11 series: one full group of lanes and a padded partial one
+static void testEmaBatch()
+{
+    constexpr size_t kSeries = 11;
+    constexpr size_t kBars = 3'001;
+    for (size_t period : {size_t(1), size_t(12), size_t(26)}) {
+        std::vector<std::vector<double>> series, want;
+        for (size_t s = 0; s < kSeries; s++) {
+            series.push_back(randomWalk(kBars, 1000 + s));
+            Ema<> ref(period);
+            want.emplace_back();
+            for (double v : series.back()) {
+                want.back().push_back(ref.update(v));
+            }
+        }
+        std::vector<const double*> in;
+        for (const auto& s : series) {
+            in.push_back(s.data());
+        }
+        for (SimdLevel level : levelsToTest()) {
+            std::vector<std::vector<double>> got(kSeries, std::vector<double>(kBars));
+            std::vector<double*> out;
+            for (auto& g : got) {
+                out.push_back(g.data());
+            }
+            emaBatch(in.data(), kSeries, kBars, period, out.data(), level);
+            for (size_t s = 0; s < kSeries; s++) {
+                long bad = firstMismatch(got[s], want[s]);
+                CHECK(bad < 0, "emaBatch %s period=%zu series %zu differs at %ld", simdLevelName(level), period, s, bad);
+            }
+        }
+    }
+}
+
+static void testCrossoverBatch()
+{
+    constexpr size_t kBars = 10'007;
+    std::vector<double> x = randomWalk(kBars, 7);
+    std::vector<double> fast(kBars), slow(kBars);
+    smaBatch(x.data(), kBars, 5, fast.data(), SimdLevel::Scalar);
+    smaBatch(x.data(), kBars, 20, slow.data(), SimdLevel::Scalar);
+    std::vector<int8_t> want(kBars, 0);
+    crossoverScalar(fast.data(), slow.data(), 0, kBars, want.data());
+    for (SimdLevel level : levelsToTest()) {
+        std::vector<int8_t> got(kBars, 42);
+        crossoverBatch(fast.data(), slow.data(), kBars, got.data(), level);
+        CHECK(got == want, "crossoverBatch %s differs from the scalar rule", simdLevelName(level));
+    }
+}
+
+int main()
+{
+    std::printf("[INFO] SIMD levels up to %s\n", simdLevelName(detectSimdLevel()));
+    testWindowKernels();
+    testEmaBatch();
+    testCrossoverBatch();
+    if (g_failures) {
+        std::printf("[FAIL] %d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("[INFO] indicator_kernels_test passed\n");
+    return 0;
+}
@@ -0,0 +1,125 @@
+// indicators_test.cpp
+// Streaming indicators (indicators.h) against exact recomputation over the same window.
+#include <cmath>
+#include <cstdio>
+#include <deque>
+#include <random>
+
+#include "indicators.h"
+
+static int g_failures = 0;
+
+#define CHECK(cond, ...)                                  \
+    do {                                                  \
+        if (!(cond)) {                                    \
+            std::printf("[FAIL] %s:%d: ", __FILE__, __LINE__); \
+            std::printf(__VA_ARGS__);                     \
+            std::printf("\n");                            \
+            g_failures++;                                 \
+        }                                                 \
+    } while (0)
+
+static double relativeError(double got, double want)
+{
+    double scale = std::max(std::fabs(want), 1e-300);
+    return std::fabs(got - want) / scale;
+}
+
+// Random walk around a BTC-like price with small steps: the case where running sums
+// lose the most, since the window's spread is tiny next to its level
+static void testAgainstExactWindow()
+{
+    constexpr size_t kPeriod = 20;
+    std::mt19937_64 rng(42);
+    std::normal_distribution<double> step(0.0, 5.0);
+    std::uniform_real_distribution<double> volume(0.001, 2.0);
+
+    Sma<kPeriod> sma;
+    Sma<> smaDynamic(kPeriod);
+    Bollinger<kPeriod> bollinger;
+    Bollinger<> bollingerDynamic(kPeriod);
+    RollingVwap<kPeriod> vwap;
+
+    std::deque<double> prices;
+    std::deque<double> volumes;
+    double price = 64000.0;
+    double worstMean = 0.0;
+    double worstStddev = 0.0;
+    double worstVwap = 0.0;
+    for (int i = 0; i < 2'000'000; i++) {
+        price += step(rng);
+        double v = volume(rng);
+        sma.update(price);
+        smaDynamic.update(price);
+        bollinger.update(price);
+        bollingerDynamic.update(price);
+        vwap.update(price, v);
+
+        prices.push_back(price);
+        volumes.push_back(v);
+        if (prices.size() > kPeriod) {
+            prices.pop_front();
+            volumes.pop_front();
+        }
+        if (prices.size() < kPeriod || i % 97 != 0) {
+            continue;
+        }
+
+        long double sum = 0.0L, pv = 0.0L, vol = 0.0L;
+        for (size_t k = 0; k < kPeriod; k++) {
+            sum += prices[k];
+            pv += static_cast<long double>(prices[k]) * volumes[k];
+            vol += volumes[k];
+        }
+        long double mean = sum / kPeriod;
+        long double m2 = 0.0L;
+        for (double x : prices) {
+            m2 += (x - mean) * (x - mean);
+        }
+        double stddev = static_cast<double>(std::sqrt(m2 / kPeriod));
+
+        worstMean = std::max({worstMean, relativeError(sma.value(), static_cast<double>(mean)),
+                              relativeError(smaDynamic.value(), static_cast<double>(mean)),
+                              relativeError(bollinger.middle(), static_cast<double>(mean))});
+        worstStddev = std::max({worstStddev, relativeError(bollinger.stddev(), stddev),
+                                relativeError(bollingerDynamic.stddev(), stddev)});
+        worstVwap = std::max(worstVwap, relativeError(vwap.value(), static_cast<double>(pv / vol)));
+    }
+    std::printf("[INFO] worst relative error: mean %.2e, stddev %.2e, rolling vwap %.2e\n",
+                worstMean, worstStddev, worstVwap);
+    CHECK(worstMean < 1e-12, "SMA drifted: %.3e", worstMean);
+    CHECK(worstStddev < 1e-9, "Bollinger stddev drifted: %.3e", worstStddev);
+    CHECK(worstVwap < 1e-12, "RollingVwap drifted: %.3e", worstVwap);
+}
+
+static void testReadiness()
+{
+    Sma<3> sma;
+    sma.update(1.0);
+    sma.update(2.0);
+    CHECK(!sma.ready(), "Sma ready before its window is full");
+    sma.update(3.0);
+    CHECK(sma.ready() && sma.value() == 2.0, "Sma<3> of 1,2,3 = %f", sma.value());
+    sma.update(4.0);
+    CHECK(sma.value() == 3.0, "Sma<3> of 2,3,4 = %f", sma.value());
+
+    Ema<3> ema;
+    ema.update(1.0);
+    ema.update(2.0);
+    ema.update(3.0);
+    CHECK(ema.ready() && ema.value() == 2.0, "Ema seed = %f", ema.value());
+    ema.update(4.0);
+    CHECK(ema.value() == 3.0, "Ema step = %f", ema.value());
+}
+
+int main()
+{
+    testReadiness();
+    testAgainstExactWindow();
+    if (g_failures) {
+        std::printf("[FAIL] %d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("[INFO] indicators_test passed\n");
+    return 0;
+}
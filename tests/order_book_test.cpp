@@ -0,0 +1,111 @@
+// order_book_test.cpp
+// Level2Feed (order_book.h): snapshots and updates applied to the right books, including
+// when the reused parse buffers hold stale events from a longer earlier message.
+#include <cstdio>
+#include <string>
+
+#include "order_book.h"
+
+static int g_failures = 0;
+
+#define CHECK(cond, ...)                                  \
+    do {                                                  \
+        if (!(cond)) {                                    \
+            std::printf("[FAIL] %s:%d: ", __FILE__, __LINE__); \
+            std::printf(__VA_ARGS__);                     \
+            std::printf("\n");                            \
+            g_failures++;                                 \
+        }                                                 \
+    } while (0)
+
+static std::string level(const char* side, const char* price, const char* qty)
+{
+    return std::string(R"({"side":")") + side + R"(","event_time":"","price_level":")" + price +
+           R"(","new_quantity":")" + qty + R"("})";
+}
+
+// A two-product message followed by a one-product one: only the live event may be applied
+static void testMultiThenSingleEvent()
+{
+    TopOfBookCell btcTop, ethTop;
+    Level2Feed feed;
+    feed.addProduct("BTC-USD", &btcTop);
+    feed.addProduct("ETH-USD", &ethTop);
+
+    std::string snapshots = R"({"channel":"l2_data","sequence_num":0,"events":[)"
+                            R"({"type":"snapshot","product_id":"BTC-USD","updates":[)" +
+                            level("bid", "100", "1") + "," + level("offer", "101", "2") +
+                            R"(]},{"type":"snapshot","product_id":"ETH-USD","updates":[)" +
+                            level("bid", "10", "3") + "," + level("offer", "11", "4") + "]}]}";
+    CHECK(feed.onMessage(snapshots, 1), "snapshot message rejected");
+    CHECK(feed.updatesApplied() == 4, "updatesApplied %llu after the snapshots, want 4",
+          static_cast<unsigned long long>(feed.updatesApplied()));
+
+    std::string update = R"({"channel":"l2_data","sequence_num":1,"events":[)"
+                         R"({"type":"update","product_id":"ETH-USD","updates":[)" +
+                         level("bid", "10.5", "5") + "]}]}";
+    CHECK(feed.onMessage(update, 2), "update message rejected");
+    CHECK(feed.updatesApplied() == 5, "updatesApplied %llu after the update, want 5",
+          static_cast<unsigned long long>(feed.updatesApplied()));
+
+    TopOfBook eth = ethTop.read();
+    CHECK(eth.valid && eth.bidPrice == 10.5 && eth.bidSize == 5.0, "ETH best bid %.2f x %.2f, want 10.50 x 5",
+          eth.bidPrice, eth.bidSize);
+    CHECK(eth.askPrice == 11.0, "ETH best ask %.2f, want 11", eth.askPrice);
+    const OrderBook* ethBook = feed.book("ETH-USD");
+    CHECK(ethBook && ethBook->bids.depth() == 2, "ETH bid depth %zu, want 2", ethBook ? ethBook->bids.depth() : 0);
+
+    TopOfBook btc = btcTop.read();
+    CHECK(btc.valid && btc.bidPrice == 100.0 && btc.askPrice == 101.0 && btc.timestampNanos == 1,
+          "BTC book touched by the ETH-only message (bid %.2f ask %.2f at %lld)", btc.bidPrice, btc.askPrice,
+          static_cast<long long>(btc.timestampNanos));
+}
+
+// A missing sequence number invalidates every book until fresh snapshots arrive
+static void testSequenceGap()
+{
+    TopOfBookCell top;
+    Level2Feed feed;
+    feed.addProduct("BTC-USD", &top);
+    std::string snapshot = R"({"channel":"l2_data","sequence_num":0,"events":[)"
+                           R"({"type":"snapshot","product_id":"BTC-USD","updates":[)" +
+                           level("bid", "100", "1") + "," + level("offer", "101", "1") + "]}]}";
+    CHECK(feed.onMessage(snapshot, 1), "snapshot message rejected");
+    std::string late = R"({"channel":"l2_data","sequence_num":2,"events":[)"
+                       R"({"type":"update","product_id":"BTC-USD","updates":[)" +
+                       level("bid", "100.5", "1") + "]}]}";
+    CHECK(!feed.onMessage(late, 2), "gap not reported");
+    CHECK(feed.gaps() == 1, "gaps %llu, want 1", static_cast<unsigned long long>(feed.gaps()));
+    CHECK(!top.read().valid, "book still valid after a gap");
+}
+
+// A new connection (a replayed reconnect has no reset() call) numbers from 0 again
+static void testNewConnection()
+{
+    TopOfBookCell top;
+    Level2Feed feed;
+    feed.addProduct("BTC-USD", &top);
+    for (int connection = 0; connection < 2; connection++) {
+        std::string snapshot = R"({"channel":"l2_data","sequence_num":0,"events":[)"
+                               R"({"type":"snapshot","product_id":"BTC-USD","updates":[)" +
+                               level("bid", connection ? "200" : "100", "1") + "," + level("offer", "201", "1") +
+                               "]}]}";
+        CHECK(feed.onMessage(snapshot, 1), "snapshot on connection %d rejected", connection);
+    }
+    CHECK(feed.gaps() == 0, "restart at 0 counted as a gap");
+    TopOfBook t = top.read();
+    CHECK(t.valid && t.bidPrice == 200.0, "best bid %.2f after the second snapshot, want 200", t.bidPrice);
+}
+
+int main()
+{
+    testMultiThenSingleEvent();
+    testSequenceGap();
+    testNewConnection();
+    if (g_failures) {
+        std::printf("[FAIL] %d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("[INFO] order_book_test passed\n");
+    return 0;
+}
@@ -0,0 +1,112 @@
+// product_scan_test.cpp
+// MaCrossScan (product_scan.h) against one MaCrossoverStrategy per product, on every SIMD level
+// this CPU has: both must take the same actions on the same inputs.
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "product_scan.h"
+
+static int g_failures = 0;
+
+#define CHECK(cond, ...)                                  \
+    do {                                                  \
+        if (!(cond)) {                                    \
+            std::printf("[FAIL] %s:%d: ", __FILE__, __LINE__); \
+            std::printf(__VA_ARGS__);                     \
+            std::printf("\n");                            \
+            g_failures++;                                 \
+        }                                                 \
+    } while (0)
+
+static const char* actionName(Decision::Action a)
+{
+    return a == Decision::Action::Enter ? "enter" : a == Decision::Action::Exit ? "exit" : "none";
+}
+
+// 37 products (not a whole number of blocks) over many ticks. MAs move on a coarse grid so
+// equal MAs and exits right at the profit floor happen often; a few are NaN.
+static void testMatchesStrategy(SimdLevel level)
+{
+    constexpr size_t kProducts = 37;
+    constexpr int kTicks = 20'000;
+    std::mt19937_64 rng(11);
+    std::uniform_int_distribution<int> grid(-3, 3);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    MaCrossScan<130> scan;
+    std::vector<MaCrossoverStrategy> strategies(kProducts);
+    std::vector<PositionView> positions(kProducts);
+    std::vector<double> shortMA(kProducts, 100.0);
+    std::vector<double> longMA(kProducts, 100.0);
+    for (size_t p = 0; p < kProducts; p++) {
+        scan.addProduct();
+    }
+
+    std::vector<ScanAction> actions;
+    size_t entries = 0;
+    size_t exits = 0;
+    for (int tick = 0; tick < kTicks && g_failures == 0; tick++) {
+        for (size_t p = 0; p < kProducts; p++) {
+            shortMA[p] = 100.0 + grid(rng) * 0.65;
+            longMA[p] = unit(rng) < 0.002 ? std::numeric_limits<double>::quiet_NaN() : 100.0 + grid(rng) * 0.65;
+            positions[p].orderInFlight = unit(rng) < 0.1;
+            scan.setMovingAverages(static_cast<uint32_t>(p), shortMA[p], longMA[p]);
+            scan.setOrderInFlight(static_cast<uint32_t>(p), positions[p].orderInFlight);
+            scan.setPosition(static_cast<uint32_t>(p), positions[p].havePosition, positions[p].lastBuyPrice);
+        }
+
+        scan.evaluate(actions, level);
+        size_t next = 0;
+        for (size_t p = 0; p < kProducts; p++) {
+            StrategyInput in;
+            in.shortMA = shortMA[p];
+            in.longMA = longMA[p];
+            Decision want = strategies[p].decide(in, positions[p]);
+
+            ScanAction got;
+            got.product = static_cast<uint32_t>(p);
+            if (next < actions.size() && actions[next].product == p) {
+                got = actions[next++];
+            }
+            CHECK(got.action == want.action, "%s tick %d product %zu: scan %s, strategy %s", simdLevelName(level), tick,
+                  p, actionName(got.action), actionName(want.action));
+            CHECK(got.minPrice == want.minPrice, "%s tick %d product %zu: min price %.10f vs %.10f",
+                  simdLevelName(level), tick, p, got.minPrice, want.minPrice);
+
+            // Fill at once, like an order that executes before the next tick
+            if (want.action == Decision::Action::Enter) {
+                positions[p].havePosition = true;
+                positions[p].lastBuyPrice = longMA[p] - 1.3;
+                entries++;
+            } else if (want.action == Decision::Action::Exit) {
+                positions[p].havePosition = false;
+                exits++;
+            }
+        }
+        CHECK(next == actions.size(), "%s tick %d: scan returned %zu actions, out of order or for padding",
+              simdLevelName(level), tick, actions.size());
+    }
+    std::printf("[INFO] %s: %zu entries, %zu exits compared\n", simdLevelName(level), entries, exits);
+    CHECK(entries > 1000 && exits > 1000, "too few actions to compare (%zu entries, %zu exits)", entries, exits);
+}
+
+int main()
+{
+    testMatchesStrategy(SimdLevel::Scalar);
+    SimdLevel best = detectSimdLevel();
+    if (best >= SimdLevel::Avx2) {
+        testMatchesStrategy(SimdLevel::Avx2);
+    }
+    if (best >= SimdLevel::Avx512) {
+        testMatchesStrategy(SimdLevel::Avx512);
+    }
+    if (g_failures) {
+        std::printf("[FAIL] %d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("[INFO] product_scan_test passed\n");
+    return 0;
+}
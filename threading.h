@@ -0,0 +1,170 @@
+// threading.h
+#ifndef THREADING_H
+#define THREADING_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+//------------------------------------------
+// CPU PINNING
+//------------------------------------------
+// Pins the calling thread to one core. core < 0 leaves the thread unpinned.
+inline bool pinCurrentThreadToCore(int core)
+{
+    if (core < 0) {
+        return true;
+    }
+#if defined(_WIN32)
+    if (core >= static_cast<int>(sizeof(DWORD_PTR) * 8)) {
+        return false;
+    }
+    return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << core) != 0;
+#elif defined(__linux__)
+    if (core >= CPU_SETSIZE) {
+        return false; // CPU_SET would write past the set
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    return false; // No affinity API (e.g. macOS)
+#endif
+}
+
+// Hint to the CPU that we are spinning
+inline void cpuRelax()
+{
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+    _mm_pause();
+#else
+    std::this_thread::yield();
+#endif
+}
+
+// Reads an integer core id from the environment, -1 if unset or not a core of this machine
+inline int coreFromEnv(const char* name)
+{
+    const char* v = std::getenv(name);
+    if (!v) {
+        return -1;
+    }
+    char* end = nullptr;
+    long core = std::strtol(v, &end, 10);
+    unsigned cores = std::thread::hardware_concurrency(); // 0 when unknown
+    if (end == v || *end != '\0' || core < 0 || (cores > 0 && core >= static_cast<long>(cores))) {
+        std::cerr << "[WARN] Ignoring " << name << "=" << v << ": not a core id on this machine (0-"
+                  << (cores > 0 ? static_cast<long>(cores) - 1 : 0) << "); thread stays unpinned\n";
+        return -1;
+    }
+    return static_cast<int>(core);
+}
+
+//------------------------------------------
+// WAIT STRATEGY
+//------------------------------------------
+// BusyPoll spins on the queue (lowest latency, burns the core);
+// Sleep backs off with a short sleep between empty polls.
+enum class WaitStrategy { Sleep, BusyPoll };
+
+inline void idleWait(WaitStrategy strategy)
+{
+    if (strategy == WaitStrategy::BusyPoll) {
+        cpuRelax();
+    } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+}
+
+//------------------------------------------
+// SPSC RING BUFFER
+//------------------------------------------
+// Lock-free single-producer/single-consumer queue used between the bot threads.
+// Capacity must be a power of two. Head and tail live on separate cache lines.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    bool tryPush(const T& item)
+    {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - headCache_ == Capacity) {
+            headCache_ = head_.load(std::memory_order_acquire);
+            if (tail - headCache_ == Capacity) {
+                return false; // Full
+            }
+        }
+        slots_[tail & (Capacity - 1)] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::optional<T> tryPop()
+    {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tailCache_) {
+            tailCache_ = tail_.load(std::memory_order_acquire);
+            if (head == tailCache_) {
+                return std::nullopt; // Empty
+            }
+        }
+        T item = std::move(slots_[head & (Capacity - 1)]);
+        head_.store(head + 1, std::memory_order_release);
+        return item;
+    }
+
+    size_t sizeApprox() const
+    {
+        return tail_.load(std::memory_order_relaxed) - head_.load(std::memory_order_relaxed);
+    }
+
+private:
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) size_t tailCache_ = 0;   // Consumer's view of tail_
+    alignas(64) std::atomic<size_t> tail_{0};
+    alignas(64) size_t headCache_ = 0;   // Producer's view of head_
+    alignas(64) std::array<T, Capacity> slots_{};
+};
+
+//------------------------------------------
+// NAMED, OPTIONALLY PINNED THREAD
+//------------------------------------------
+template <typename Fn>
+std::thread startPinnedThread(const std::string& name, int core, Fn&& fn)
+{
+    return std::thread([name, core, fn = std::forward<Fn>(fn)]() mutable {
+        if (core >= 0) {
+            if (pinCurrentThreadToCore(core)) {
+                std::cout << "[THREAD] " << name << " pinned to core " << core << "\n";
+            } else {
+                std::cerr << "[WARN] Could not pin " << name << " to core " << core << "\n";
+            }
+        }
+        fn();
+    });
+}
+
+#endif // THREADING_H
@@ -0,0 +1,88 @@
+// tick_arena.h
+#ifndef TICK_ARENA_H
+#define TICK_ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+//------------------------------------------
+// COUNTING UPSTREAM RESOURCE
+//------------------------------------------
+// Sits behind the arena and counts every allocation that did not fit in the
+// arena's initial buffer. In a well-sized arena this stays at zero.
+class CountingResource : public std::pmr::memory_resource {
+public:
+    explicit CountingResource(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+        : upstream_(upstream) {}
+
+    size_t allocations() const { return allocations_; }
+    size_t bytes() const { return bytes_; }
+    void resetCounters() { allocations_ = 0; bytes_ = 0; }
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        ++allocations_;
+        bytes_ += bytes;
+        return upstream_->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        upstream_->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+    std::pmr::memory_resource* upstream_;
+    size_t allocations_ = 0;
+    size_t bytes_ = 0;
+};
+
+//------------------------------------------
+// PER-TICK MONOTONIC ARENA
+//------------------------------------------
+// One buffer is allocated up front. Every transient string/vector of a tick is
+// bump-allocated from it and the whole tick is released at once by reset().
+class TickArena {
+public:
+    explicit TickArena(size_t initialBytes = 256 * 1024)
+        : buffer_(new std::byte[initialBytes]),
+          size_(initialBytes),
+          resource_(buffer_.get(), size_, &upstream_) {}
+
+    TickArena(const TickArena&) = delete;
+    TickArena& operator=(const TickArena&) = delete;
+
+    std::pmr::memory_resource* resource() { return &resource_; }
+
+    // Number of times the arena had to go to the heap during this tick
+    size_t upstreamAllocations() const { return upstream_.allocations(); }
+    size_t upstreamBytes() const { return upstream_.bytes(); }
+
+    // Release everything allocated during the tick and rewind to the initial buffer
+    void reset() {
+        resource_.release();
+        upstream_.resetCounters();
+    }
+
+    // RAII helper: releases the arena when the tick scope ends (including on continue/throw)
+    class Scope {
+    public:
+        explicit Scope(TickArena& arena) : arena_(arena) {}
+        ~Scope() { arena_.reset(); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        TickArena& arena_;
+    };
+
+private:
+    std::unique_ptr<std::byte[]> buffer_;
+    size_t size_;
+    CountingResource upstream_;
+    std::pmr::monotonic_buffer_resource resource_;
+};
+
+#endif // TICK_ARENA_H
@@ -0,0 +1,99 @@
+// user_channel.h
+#ifndef USER_CHANNEL_H
+#define USER_CHANNEL_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "ws_channel.h"
+
+//------------------------------------------
+// ADVANCED TRADE USER CHANNEL (WEBSOCKET)
+//------------------------------------------
+// Subscribes to the authenticated "user" channel and pushes every order update
+// (fills, cancels, rejects) to a callback as soon as it arrives.
+// The subscribe message carries a JWT signed with the same CDP key as the REST calls.
+// "heartbeats" is subscribed too so the exchange keeps an otherwise idle connection open.
+// The snapshot sent after every (re)subscribe carries cumulative fills, so nothing is
+// lost across a reconnect.
+
+struct UserOrderEvent {
+    std::string orderId;
+    std::string clientOrderId;
+    std::string status;          // PENDING, OPEN, FILLED, CANCELLED, EXPIRED, FAILED, ...
+    double cumulativeBase = 0.0; // "cumulative_quantity"
+    double cumulativeQuote = 0.0; // "filled_value"
+};
+
+class UserChannelClient {
+public:
+    using JwtFactory = CoinbaseWsClient::JwtFactory;
+    using OrderCallback = std::function<void(const UserOrderEvent&)>;
+    using RawCallback = std::function<void(const std::string&)>;
+
+    UserChannelClient(std::vector<std::string> productIds, JwtFactory makeJwt, OrderCallback onOrder,
+                      std::string host = "advanced-trade-ws-user.coinbase.com")
+        : onOrder_(std::move(onOrder)),
+          ws_(std::move(host), {"user", "heartbeats"}, std::move(productIds), std::move(makeJwt),
+              [this](const std::string& msg) { handleMessage(msg); return true; }) {}
+
+    // Optional: every raw message (used by the capture log)
+    void setRawCallback(RawCallback cb) { onRaw_ = std::move(cb); }
+
+    // Runs until stop(); call on a dedicated thread
+    void run() { ws_.run(); }
+    void stop() { ws_.stop(); }
+    bool connected() const { return ws_.connected(); }
+
+    // One message as if it had arrived on the connection (replay feeds recorded ones here)
+    void onMessage(const std::string& msg) { handleMessage(msg); }
+
+private:
+    void handleMessage(const std::string& msg)
+    {
+        if (onRaw_) {
+            onRaw_(msg);
+        }
+        nlohmann::json j = nlohmann::json::parse(msg, nullptr, false);
+        if (j.is_discarded() || j.value("channel", "") != "user" || !j.contains("events")) {
+            return; // Heartbeats, subscription acks
+        }
+        for (const auto& event : j["events"]) {
+            if (!event.contains("orders")) {
+                continue;
+            }
+            for (const auto& order : event["orders"]) {
+                UserOrderEvent e;
+                e.orderId = order.value("order_id", "");
+                e.clientOrderId = order.value("client_order_id", "");
+                e.status = order.value("status", "");
+                e.cumulativeBase = toDouble(order, "cumulative_quantity");
+                e.cumulativeQuote = toDouble(order, "filled_value");
+                onOrder_(e);
+            }
+        }
+    }
+
+    // Numeric fields arrive as strings
+    static double toDouble(const nlohmann::json& obj, const char* key)
+    {
+        auto it = obj.find(key);
+        if (it == obj.end() || !it->is_string()) {
+            return 0.0;
+        }
+        try {
+            return std::stod(it->get<std::string>());
+        } catch (...) {
+            return 0.0;
+        }
+    }
+
+    OrderCallback onOrder_;
+    RawCallback onRaw_;
+    CoinbaseWsClient ws_;
+};
+
+#endif // USER_CHANNEL_H
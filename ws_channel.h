@@ -0,0 +1,191 @@
+// ws_channel.h
+#ifndef WS_CHANNEL_H
+#define WS_CHANNEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/asio/connect.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/ssl.hpp>
+#include <boost/beast/websocket.hpp>
+#include <boost/beast/websocket/ssl.hpp>
+#include <nlohmann/json.hpp>
+
+//------------------------------------------
+// ADVANCED TRADE WEBSOCKET CHANNELS
+//------------------------------------------
+// One TLS websocket subscribed to a set of channels for a set of products.
+// Every message is handed to the callback on the thread calling run(); returning false
+// from the callback drops the connection and resubscribes (used to resync after a gap).
+// Reconnects with exponential backoff. When a JWT factory is given, each subscribe
+// message carries a freshly signed JWT (required for "user", optional for market data).
+class CoinbaseWsClient {
+public:
+    using JwtFactory = std::function<std::string()>;
+    using MessageCallback = std::function<bool(const std::string&)>;
+    using ConnectCallback = std::function<void()>;
+
+    CoinbaseWsClient(std::string host, std::vector<std::string> channels, std::vector<std::string> productIds,
+                     JwtFactory makeJwt, MessageCallback onMessage)
+        : host_(std::move(host)), channels_(std::move(channels)), productIds_(std::move(productIds)),
+          makeJwt_(std::move(makeJwt)), onMessage_(std::move(onMessage)) {}
+
+    // Optional: called before subscribing on every (re)connect, e.g. to reset sequence state
+    void setOnConnect(ConnectCallback cb) { onConnect_ = std::move(cb); }
+
+    // Runs until stop(); call on a dedicated thread
+    void run()
+    {
+        int backoffMs = 250;
+        while (!stopped_.load()) {
+            try {
+                session();
+                backoffMs = 250; // Resync requested by the callback: reconnect right away
+            } catch (const std::exception& e) {
+                if (stopped_.load()) break;
+                std::cerr << "[WS] " << host_ << ": " << e.what() << ", reconnecting in " << backoffMs << "ms\n";
+                std::this_thread::sleep_for(std::chrono::milliseconds(backoffMs));
+                backoffMs = std::min(backoffMs * 2, 10'000);
+            }
+        }
+    }
+
+    // Safe from any thread: the close runs on the session's io_context, never on the caller's
+    void stop()
+    {
+        stopped_.store(true);
+        std::lock_guard<std::mutex> lock(liveMutex_);
+        if (liveIoc_) {
+            Stream* ws = liveWs_;
+            boost::asio::post(*liveIoc_, [ws] {
+                ws->async_close(boost::beast::websocket::close_code::normal, [](const boost::system::error_code&) {});
+            });
+        }
+    }
+
+    bool connected() const { return connected_.load(); }
+
+private:
+    using Stream = boost::beast::websocket::stream<boost::beast::ssl_stream<boost::beast::tcp_stream>>;
+
+    void session()
+    {
+        namespace net = boost::asio;
+        namespace ssl = boost::asio::ssl;
+        namespace websocket = boost::beast::websocket;
+
+        net::io_context ioc;
+        ssl::context sslCtx(ssl::context::tlsv12_client);
+        sslCtx.set_default_verify_paths();
+        sslCtx.set_verify_mode(ssl::verify_peer);
+
+        net::ip::tcp::resolver resolver(ioc);
+        Stream ws(ioc, sslCtx);
+
+        auto endpoints = resolver.resolve(host_, "443");
+        boost::beast::get_lowest_layer(ws).connect(endpoints);
+        boost::beast::get_lowest_layer(ws).socket().set_option(net::ip::tcp::no_delay(true));
+
+        // SNI + hostname verification
+        if (!SSL_set_tlsext_host_name(ws.next_layer().native_handle(), host_.c_str())) {
+            throw std::runtime_error("Failed to set SNI host name");
+        }
+        ws.next_layer().set_verify_callback(ssl::host_name_verification(host_));
+        ws.next_layer().handshake(ssl::stream_base::client);
+        boost::beast::get_lowest_layer(ws).expires_never();
+        // Only async operations are timed; here that bounds the close handshake stop() starts
+        websocket::stream_base::timeout timeouts = websocket::stream_base::timeout::suggested(boost::beast::role_type::client);
+        timeouts.handshake_timeout = std::chrono::seconds(2);
+        ws.set_option(timeouts);
+        ws.handshake(host_, "/");
+
+        // Published for stop() until the stream goes out of scope (cleared first, under the lock)
+        {
+            std::lock_guard<std::mutex> lock(liveMutex_);
+            liveIoc_ = &ioc;
+            liveWs_ = &ws;
+        }
+        struct Reset {
+            CoinbaseWsClient* self;
+            ~Reset()
+            {
+                std::lock_guard<std::mutex> lock(self->liveMutex_);
+                self->liveIoc_ = nullptr;
+                self->liveWs_ = nullptr;
+                self->connected_.store(false);
+            }
+        } reset{this};
+        if (stopped_.load()) {
+            return; // stop() ran before the stream was published
+        }
+
+        if (onConnect_) {
+            onConnect_();
+        }
+        for (const std::string& channel : channels_) {
+            subscribe(ws, channel);
+        }
+        connected_.store(true);
+        std::cout << "[WS] Subscribed on " << host_ << "\n";
+
+        // Reads are asynchronous so that stop()'s posted close runs on this thread, between or
+        // during reads; the callback still runs here
+        boost::beast::flat_buffer buffer;
+        while (!stopped_.load()) {
+            buffer.clear();
+            boost::system::error_code readEc;
+            ws.async_read(buffer, [&](const boost::system::error_code& ec, size_t) { readEc = ec; });
+            ioc.restart();
+            ioc.run();
+            if (readEc) {
+                if (stopped_.load()) {
+                    return;
+                }
+                throw boost::system::system_error(readEc);
+            }
+            if (!onMessage_(boost::beast::buffers_to_string(buffer.data()))) {
+                boost::system::error_code ec;
+                ws.close(websocket::close_code::normal, ec);
+                return;
+            }
+        }
+    }
+
+    void subscribe(Stream& ws, const std::string& channel)
+    {
+        nlohmann::json sub;
+        sub["type"] = "subscribe";
+        sub["channel"] = channel;
+        sub["product_ids"] = productIds_;
+        if (makeJwt_) {
+            sub["jwt"] = makeJwt_(); // Fresh JWT per subscribe message
+        }
+        ws.write(boost::asio::buffer(sub.dump()));
+    }
+
+    std::string host_;
+    std::vector<std::string> channels_;
+    std::vector<std::string> productIds_;
+    JwtFactory makeJwt_;
+    MessageCallback onMessage_;
+    ConnectCallback onConnect_;
+    std::atomic<bool> stopped_{false};
+    std::atomic<bool> connected_{false};
+    std::mutex liveMutex_;              // Guards the two pointers below
+    boost::asio::io_context* liveIoc_ = nullptr; // Current session's io_context and stream,
+    Stream* liveWs_ = nullptr;                   // null outside session()
+};
+
+#endif // WS_CHANNEL_H